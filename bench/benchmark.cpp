@@ -0,0 +1,326 @@
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "NumericMatrix.h"
+#include "read_utils.h"
+#include "utils.h"
+
+#include "quality_control_rna.h"
+#include "normalize_counts.h"
+#include "matrix_stats.h"
+#include "model_gene_variances.h"
+#include "run_pca.h"
+#include "NeighborIndex.h"
+#include "build_snn_graph.h"
+#include "cluster_graph.h"
+#include "cluster_kmeans.h"
+#include "run_tsne.h"
+#include "run_umap.h"
+#include "score_markers.h"
+#include "aggregate_across_cells.h"
+#include "score_gsdecon.h"
+
+#include "tatami/tatami.hpp"
+
+/**
+ * Each step below calls the same Embind-free functions as the corresponding
+ * binding in src/, using the same options as the defaults in the Javascript
+ * wrappers. This allows us to track the throughput of each step without going
+ * through the Wasm heap, and to compare native and Wasm timings for the same input.
+ */
+
+struct BenchmarkOptions {
+    MatrixIndex num_rows = 10000;
+    MatrixIndex num_columns = 10000;
+    double density = 0.1;
+    int num_threads = 1;
+    int num_groups = 10;
+    int num_repeats = 1;
+    bool layered = true;
+    std::uint64_t seed = 42;
+    std::vector<std::string> steps;
+};
+
+BenchmarkOptions parse_options(int argc, char** argv) {
+    BenchmarkOptions opt;
+
+    auto next = [&](int& i) -> std::string {
+        if (i + 1 >= argc) {
+            throw std::runtime_error("expected a value after '" + std::string(argv[i]) + "'");
+        }
+        ++i;
+        return std::string(argv[i]);
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag(argv[i]);
+        if (flag == "--rows") {
+            opt.num_rows = std::stoi(next(i));
+        } else if (flag == "--columns") {
+            opt.num_columns = std::stoi(next(i));
+        } else if (flag == "--density") {
+            opt.density = std::stod(next(i));
+        } else if (flag == "--threads") {
+            opt.num_threads = std::stoi(next(i));
+        } else if (flag == "--groups") {
+            opt.num_groups = std::stoi(next(i));
+        } else if (flag == "--repeats") {
+            opt.num_repeats = std::stoi(next(i));
+        } else if (flag == "--seed") {
+            opt.seed = std::stoull(next(i));
+        } else if (flag == "--compressed") {
+            opt.layered = false;
+        } else if (flag == "--step") {
+            opt.steps.push_back(next(i));
+        } else {
+            throw std::runtime_error("unknown flag '" + flag + "'");
+        }
+    }
+
+    if (opt.num_rows <= 0 || opt.num_columns <= 0) {
+        throw std::runtime_error("'--rows' and '--columns' should be positive");
+    }
+    if (opt.density <= 0 || opt.density > 1) {
+        throw std::runtime_error("'--density' should lie in (0, 1]");
+    }
+    if (opt.num_groups <= 0) {
+        throw std::runtime_error("'--groups' should be positive");
+    }
+    return opt;
+}
+
+/**********************************/
+
+struct SimulatedCounts {
+    std::vector<std::int32_t> values;
+    std::vector<MatrixIndex> indices;
+    std::vector<std::size_t> pointers;
+    std::vector<std::int32_t> groups;
+};
+
+// Each group has a different mean for a subset of genes, so that the marker
+// detection and clustering steps have some actual structure to work with.
+SimulatedCounts simulate_counts(const BenchmarkOptions& opt) {
+    SimulatedCounts output;
+    std::mt19937_64 rng(opt.seed);
+    std::uniform_real_distribution<double> unif(0, 1);
+
+    std::vector<double> base(opt.num_rows);
+    std::lognormal_distribution<double> lnorm(0, 1);
+    for (auto& b : base) {
+        b = lnorm(rng);
+    }
+
+    output.groups.resize(opt.num_columns);
+    output.pointers.reserve(sanisizer::sum<std::size_t>(opt.num_columns, 1));
+    output.pointers.push_back(0);
+
+    for (MatrixIndex c = 0; c < opt.num_columns; ++c) {
+        const auto g = c % opt.num_groups;
+        output.groups[c] = g;
+        for (MatrixIndex r = 0; r < opt.num_rows; ++r) {
+            if (unif(rng) >= opt.density) {
+                continue;
+            }
+            double mu = base[r];
+            if (r % opt.num_groups == g) {
+                mu *= 5;
+            }
+            std::poisson_distribution<std::int32_t> pois(mu);
+            output.values.push_back(1 + pois(rng));
+            output.indices.push_back(r);
+        }
+        output.pointers.push_back(output.values.size());
+    }
+
+    return output;
+}
+
+/**********************************/
+
+class Timer {
+public:
+    Timer(int num_repeats) : my_num_repeats(num_repeats) {}
+
+    void run(const std::string& name, const std::function<void()>& fun) {
+        double total = 0;
+        for (int r = 0; r < my_num_repeats; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            fun();
+            const auto end = std::chrono::steady_clock::now();
+            total += std::chrono::duration<double>(end - start).count();
+        }
+        std::cout << name << "\t" << total / my_num_repeats << std::endl;
+    }
+
+private:
+    int my_num_repeats;
+};
+
+/**********************************/
+
+int main(int argc, char** argv) {
+    const auto opt = parse_options(argc, argv);
+    auto chosen = [&](const std::string& step) -> bool {
+        return opt.steps.empty() || std::find(opt.steps.begin(), opt.steps.end(), step) != opt.steps.end();
+    };
+
+    std::cerr << "rows: " << opt.num_rows
+        << ", columns: " << opt.num_columns
+        << ", density: " << opt.density
+        << ", threads: " << opt.num_threads
+        << ", layered: " << (opt.layered ? "true" : "false")
+        << std::endl;
+
+    const auto sim = simulate_counts(opt);
+    tatami::CompressedSparseColumnMatrix<std::int32_t, MatrixIndex, I<decltype(sim.values)>, I<decltype(sim.indices)>, I<decltype(sim.pointers)> > raw(
+        opt.num_rows,
+        opt.num_columns,
+        sim.values,
+        sim.indices,
+        sim.pointers
+    );
+
+    Timer timer(opt.num_repeats);
+    std::cout << "step\tseconds" << std::endl;
+
+    // Same as js_initialize_sparse_matrix_from_sparse_arrays() for a CSC input.
+    NumericMatrix counts;
+    timer.run("initialize", [&]() -> void {
+        counts = sparse_from_tatami(raw, opt.layered, false);
+    });
+
+    // The first 1% of genes are used as a pseudo-mitochondrial subset.
+    if (chosen("rna_qc")) {
+        std::vector<std::uint8_t> mito(opt.num_rows);
+        std::fill_n(mito.begin(), std::max(1, opt.num_rows / 100), 1);
+        std::vector<const std::uint8_t*> subsets{ mito.data() };
+        timer.run("rna_qc", [&]() -> void {
+            compute_rna_qc_metrics(counts, subsets, opt.num_threads);
+        });
+    }
+
+    // The library sizes are used as size factors, as in normalizeCounts().
+    NumericMatrix normalized;
+    {
+        std::vector<double> totals(opt.num_columns);
+        matrix_sums(counts, false, totals.data(), opt.num_threads);
+        timer.run("normalize", [&]() -> void {
+            auto sf = totals;
+            center_size_factors(sf.size(), sf.data(), NULL, true);
+            normalized = normalize_counts(counts, std::move(sf), true, false, false);
+        });
+    }
+
+    if (chosen("matrix_sums")) {
+        std::vector<double> buffer(opt.num_rows);
+        timer.run("matrix_sums", [&]() -> void {
+            matrix_sums(normalized, true, buffer.data(), opt.num_threads);
+        });
+    }
+
+    // All downstream steps need the PCs, so we compute them if any of those steps are requested.
+    const bool need_pcs = chosen("pca") || chosen("neighbors") || chosen("snn_graph") || chosen("cluster_multilevel") || chosen("kmeans") || chosen("tsne") || chosen("umap");
+
+    std::vector<std::uint8_t> hvgs(opt.num_rows, 1);
+    if (chosen("variances") || need_pcs) {
+        scran_variances::ModelGeneVariancesResults<double> varres;
+        timer.run("variances", [&]() -> void {
+            varres = scran_variances::model_gene_variances(*(normalized.ptr()), model_gene_variances_options(0.3, "variable", opt.num_threads));
+        });
+        choose_highly_variable_genes(hvgs.size(), varres.residuals.data(), hvgs.data(), 4000, 0);
+    }
+
+    // Using the highly variable genes as a feature subset, without blocking.
+    const int num_pcs = std::min(25, std::min(opt.num_rows, opt.num_columns) - 1);
+    Eigen::MatrixXd components;
+    if (need_pcs) {
+        timer.run("pca", [&]() -> void {
+            auto ptr = pca_input(normalized, hvgs.data());
+            auto res = scran_pca::simple_pca(*ptr, pca_options<scran_pca::SimplePcaOptions>(num_pcs, false, true, opt.num_threads));
+            components = std::move(res.components);
+        });
+    }
+
+    // Using the approximate search, as in findNearestNeighbors().
+    NeighborResults neighbors;
+    if (chosen("neighbors") || chosen("snn_graph") || chosen("cluster_multilevel") || chosen("umap")) {
+        timer.run("neighbors", [&]() -> void {
+            auto index = build_neighbor_index(components.data(), components.rows(), components.cols(), true);
+            neighbors = find_nearest_neighbors(index, 15, opt.num_threads);
+        });
+    }
+
+    if (chosen("snn_graph") || chosen("cluster_multilevel")) {
+        std::unique_ptr<BuildSnnGraphResult> graph;
+        timer.run("snn_graph", [&]() -> void {
+            graph.reset(new BuildSnnGraphResult(build_snn_graph(truncate_nearest_neighbors(neighbors, 10), "rank", opt.num_threads)));
+        });
+
+        if (chosen("cluster_multilevel")) {
+            timer.run("cluster_multilevel", [&]() -> void {
+                cluster_multilevel(*graph, 1);
+            });
+        }
+    }
+
+    if (chosen("kmeans")) {
+        timer.run("kmeans", [&]() -> void {
+            ClusterKmeansOptions kopt;
+            kopt.num_threads = opt.num_threads;
+            cluster_kmeans(components.data(), components.rows(), components.cols(), opt.num_groups, kopt);
+        });
+    }
+
+    // Including the exact neighbor search with the perplexity-derived k, as in runTsne().
+    if (chosen("tsne")) {
+        timer.run("tsne", [&]() -> void {
+            auto index = build_neighbor_index(components.data(), components.rows(), components.cols(), false);
+            auto tneighbors = find_nearest_neighbors(index, qdtsne::perplexity_to_k(30.0), opt.num_threads);
+            auto status = initialize_tsne(tneighbors, 30, opt.num_threads);
+            std::vector<double> Y(sanisizer::product<std::size_t>(2, opt.num_columns));
+            qdtsne::initialize_random<2>(Y.data(), opt.num_columns, 42);
+            run_tsne(status, 0, 1000, Y.data());
+        });
+    }
+
+    if (chosen("umap")) {
+        timer.run("umap", [&]() -> void {
+            std::vector<float> embedding(sanisizer::product<std::size_t>(2, opt.num_columns));
+            auto status = initialize_umap(neighbors, 500, 0.01, embedding.data(), opt.num_threads);
+            run_umap(status, embedding.data(), 0);
+        });
+    }
+
+    if (chosen("markers")) {
+        timer.run("markers", [&]() -> void {
+            scran_markers::score_markers_summary(*(normalized.ptr()), sim.groups.data(), score_markers_options(0, true, false, false, opt.num_threads));
+        });
+    }
+
+    if (chosen("aggregate")) {
+        timer.run("aggregate", [&]() -> void {
+            aggregate_across_cells(counts, sim.groups.data(), false, opt.num_threads);
+        });
+    }
+
+    // Using a gene set containing the first 100 genes.
+    if (chosen("gsdecon")) {
+        std::vector<std::uint8_t> in_set(opt.num_rows);
+        std::fill_n(in_set.begin(), std::min(100, opt.num_rows), 1);
+        timer.run("gsdecon", [&]() -> void {
+            auto ptr = subset_rows_by_mask(normalized.ptr(), in_set.data());
+            gsdecon::compute(*ptr, gsdecon_options(false, "variable", opt.num_threads));
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Compares the per-step timings of the baseline and SIMD128 Wasm builds.
+# Any arguments are passed directly to the benchmark executable, e.g.,
+#
+#   ./bench/compare_simd.sh --rows 20000 --columns 50000 --threads 8
+
+set -e
+set -u
+
+root=$(dirname $0)/..
+
+for variant in baseline simd
+do
+    builddir=${root}/build_bench_${variant}
+    if [ ! -e $builddir ]
+    then
+        simd_flag=OFF
+        if [ $variant == "simd" ]
+        then
+            simd_flag=ON
+        fi
+        emcmake cmake \
+            -S ${root}/bench \
+            -B $builddir \
+            -DCMAKE_BUILD_TYPE=Release \
+            -DCMAKE_PREFIX_PATH=${root}/extern/installed \
+            -DCMAKE_C_FLAGS="-sMEMORY64" \
+            -DBENCH_SIMD=${simd_flag}
+    fi
+    cmake --build $builddir
+done
+
+baseline=$(mktemp)
+simd=$(mktemp)
+trap "rm -f $baseline $simd" EXIT
+
+node ${root}/build_bench_baseline/scran_bench.js "$@" > $baseline
+node ${root}/build_bench_simd/scran_bench.js "$@" > $simd
+
+# Reporting the speed-up of the SIMD build for each step.
+paste $baseline $simd | awk -F'\t' '
+    NR == 1 { printf "step\tbaseline\tsimd\tspeedup\n"; next }
+    { printf "%s\t%.4f\t%.4f\t%.2f\n", $1, $2, $4, ($4 > 0 ? $2 / $4 : 0) }
+'
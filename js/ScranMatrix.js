@@ -1,5 +1,6 @@
 import * as utils from "./utils.js";
 import * as gc from "./gc.js";
+import * as wasm from "./wasm.js";
 import * as wa from "wasmarrays.js";
 
 /**
@@ -108,6 +109,187 @@ export class ScranMatrix {
         return utils.toTypedArray(buffer, tmp == null, asTypedArray);
     }
 
+    #extractMultiple(indices, row, options) {
+        let { asTypedArray = true, buffer = null, numberOfThreads = 1, ...others } = options;
+        utils.checkOtherOptions(others);
+        let tmp = null;
+        let wasm_indices;
+
+        try {
+            wasm_indices = utils.wasmifyArray(indices, "Int32WasmArray");
+            let expected = wasm_indices.length * (row ? this.#matrix.ncol() : this.#matrix.nrow());
+            if (buffer == null) {
+                tmp = utils.createFloat64WasmArray(expected);
+                buffer = tmp;
+            } else if (buffer.length != expected) {
+                throw new Error("length of 'buffer' should be equal to the product of the number of indices and the extraction dimension");
+            }
+
+            if (row) {
+                this.#matrix.rows(wasm_indices.offset, wasm_indices.length, buffer.offset, numberOfThreads);
+            } else {
+                this.#matrix.columns(wasm_indices.offset, wasm_indices.length, buffer.offset, numberOfThreads);
+            }
+
+        } catch (e) {
+            utils.free(tmp);
+            throw e;
+
+        } finally {
+            utils.free(wasm_indices);
+        }
+
+        return utils.toTypedArray(buffer, tmp == null, asTypedArray);
+    }
+
+    /**
+     * Extract multiple rows at once.
+     * This is more efficient than repeated calls to {@linkcode ScranMatrix#row row} as the matrix can prefetch the requested rows and extraction can be parallelized.
+     *
+     * @param {Array|TypedArray|Int32WasmArray} indices - Indices of the rows to extract.
+     * Each entry should be a non-negative integer less than {@linkcode ScranMatrix#numberOfRows numberOfRows}.
+     * @param {object} [options={}] - Optional parameters.
+     * @param {boolean} [options.asTypedArray=true] - Whether to return a Float64Array.
+     * If `false`, a Float64WasmArray is returned instead.
+     * @param {?Float64WasmArray} [options.buffer=null] - Buffer for storing the extracted data.
+     * If supplied, this should have length equal to the product of `indices.length` and {@linkcode ScranMatrix#numberOfColumns numberOfColumns}.
+     * @param {number} [options.numberOfThreads=1] - Number of threads to use for extraction.
+     *
+     * @return {Float64Array|Float64WasmArray} An array containing the contents of the requested rows.
+     * The contents of row `indices[i]` are stored contiguously, starting at `i * numberOfColumns()`.
+     * If `buffer` is supplied, the function returns `buffer` if `asTypedArray = false`, or a view on `buffer` if `asTypedArray = true`.
+     */
+    rows(indices, options = {}) {
+        return this.#extractMultiple(indices, true, options);
+    }
+
+    /**
+     * Extract multiple columns at once.
+     * This is more efficient than repeated calls to {@linkcode ScranMatrix#column column} as the matrix can prefetch the requested columns and extraction can be parallelized.
+     *
+     * @param {Array|TypedArray|Int32WasmArray} indices - Indices of the columns to extract.
+     * Each entry should be a non-negative integer less than {@linkcode ScranMatrix#numberOfColumns numberOfColumns}.
+     * @param {object} [options={}] - Optional parameters.
+     * @param {boolean} [options.asTypedArray=true] - Whether to return a Float64Array.
+     * If `false`, a Float64WasmArray is returned instead.
+     * @param {?Float64WasmArray} [options.buffer=null] - Buffer for storing the extracted data.
+     * If supplied, this should have length equal to the product of `indices.length` and {@linkcode ScranMatrix#numberOfRows numberOfRows}.
+     * @param {number} [options.numberOfThreads=1] - Number of threads to use for extraction.
+     *
+     * @return {Float64Array|Float64WasmArray} An array containing the contents of the requested columns.
+     * The contents of column `indices[i]` are stored contiguously, starting at `i * numberOfRows()`.
+     * If `buffer` is supplied, the function returns `buffer` if `asTypedArray = false`, or a view on `buffer` if `asTypedArray = true`.
+     */
+    columns(indices, options = {}) {
+        return this.#extractMultiple(indices, false, options);
+    }
+
+    #extractSparse(func) {
+        let temp;
+        let output = [];
+
+        try {
+            temp = wasm.call(func);
+            let values = temp.values().slice();
+            let indices = temp.indices().slice();
+            let counts = temp.counts();
+
+            let start = 0;
+            for (const n of counts) {
+                let end = start + n;
+                output.push({ indices: indices.subarray(start, end), values: values.subarray(start, end) });
+                start = end;
+            }
+
+        } finally {
+            if (temp) {
+                temp.delete();
+            }
+        }
+
+        return output;
+    }
+
+    #extractSparseMultiple(indices, row, options) {
+        let { numberOfThreads = 1, ...others } = options;
+        utils.checkOtherOptions(others);
+        let wasm_indices;
+        let output;
+
+        try {
+            wasm_indices = utils.wasmifyArray(indices, "Int32WasmArray");
+            if (row) {
+                output = this.#extractSparse(module => module.sparse_rows(this.#matrix, wasm_indices.offset, wasm_indices.length, numberOfThreads));
+            } else {
+                output = this.#extractSparse(module => module.sparse_columns(this.#matrix, wasm_indices.offset, wasm_indices.length, numberOfThreads));
+            }
+        } finally {
+            utils.free(wasm_indices);
+        }
+
+        return output;
+    }
+
+    /**
+     * Extract the non-zero elements of a row, without creating a dense array.
+     * This is more efficient than {@linkcode ScranMatrix#row row} for sparse matrices, including those with delayed operations that preserve sparsity.
+     *
+     * @param {number} i - Index of the row to extract.
+     * This should be a non-negative integer less than {@linkcode ScranMatrix#numberOfRows numberOfRows}.
+     *
+     * @return {object} Object containing `indices`, an Int32Array of the column indices of the non-zero elements;
+     * and `values`, a Float64Array of the values of those elements.
+     * For dense matrices, all elements are reported.
+     */
+    rowSparse(i) {
+        return this.#extractSparse(module => module.sparse_row(this.#matrix, i))[0];
+    }
+
+    /**
+     * Extract the non-zero elements of a column, without creating a dense array.
+     * This is more efficient than {@linkcode ScranMatrix#column column} for sparse matrices, including those with delayed operations that preserve sparsity.
+     *
+     * @param {number} i - Index of the column to extract.
+     * This should be a non-negative integer less than {@linkcode ScranMatrix#numberOfColumns numberOfColumns}.
+     *
+     * @return {object} Object containing `indices`, an Int32Array of the row indices of the non-zero elements;
+     * and `values`, a Float64Array of the values of those elements.
+     * For dense matrices, all elements are reported.
+     */
+    columnSparse(i) {
+        return this.#extractSparse(module => module.sparse_column(this.#matrix, i))[0];
+    }
+
+    /**
+     * Extract the non-zero elements of multiple rows at once.
+     *
+     * @param {Array|TypedArray|Int32WasmArray} indices - Indices of the rows to extract.
+     * Each entry should be a non-negative integer less than {@linkcode ScranMatrix#numberOfRows numberOfRows}.
+     * @param {object} [options={}] - Optional parameters.
+     * @param {number} [options.numberOfThreads=1] - Number of threads to use for extraction.
+     *
+     * @return {Array} Array of length equal to `indices.length`.
+     * Each entry is an object containing the `indices` and `values` of the non-zero elements in the corresponding row, see {@linkcode ScranMatrix#rowSparse rowSparse}.
+     */
+    rowsSparse(indices, options = {}) {
+        return this.#extractSparseMultiple(indices, true, options);
+    }
+
+    /**
+     * Extract the non-zero elements of multiple columns at once.
+     *
+     * @param {Array|TypedArray|Int32WasmArray} indices - Indices of the columns to extract.
+     * Each entry should be a non-negative integer less than {@linkcode ScranMatrix#numberOfColumns numberOfColumns}.
+     * @param {object} [options={}] - Optional parameters.
+     * @param {number} [options.numberOfThreads=1] - Number of threads to use for extraction.
+     *
+     * @return {Array} Array of length equal to `indices.length`.
+     * Each entry is an object containing the `indices` and `values` of the non-zero elements in the corresponding column, see {@linkcode ScranMatrix#columnSparse columnSparse}.
+     */
+    columnsSparse(indices, options = {}) {
+        return this.#extractSparseMultiple(indices, false, options);
+    }
+
     /** 
      * Free the memory on the Wasm heap for this.#matrix.
      * This invalidates this object and all of its references.
@@ -126,4 +308,53 @@ export class ScranMatrix {
     isSparse() {
         return this.#matrix.sparse();
     }
+
+    /**
+     * @return {number} Number of bytes saved by storing the matrix contents in the narrowest possible types,
+     * e.g., 8- or 16-bit unsigned integers for small counts, 16-bit indices when there are no more than 65536 columns.
+     * This is only non-zero for non-layered sparse matrices that were directly created by the initialization functions.
+     */
+    storageSavings() {
+        return this.#matrix.storage_savings();
+    }
+
+    /**
+     * @return {object} Object describing the memory used by the matrix contents on the Wasm heap, containing:
+     *
+     * - `owned`: number of bytes that are only referenced by this matrix, and will be released when this matrix is freed.
+     * - `shared`: number of bytes that are also referenced by other matrices, e.g., when this matrix was created by a delayed operation or {@linkcode ScranMatrix#clone clone}.
+     *
+     * Only the storage created by the initialization functions, {@linkcode realizeMatrix} or a physical {@linkcode cbind} is counted.
+     * Temporary buffers used by extraction or delayed operations are ignored.
+     */
+    memoryUsage() {
+        return this.#matrix.memory_usage();
+    }
+
+    /**
+     * @return {?object} For file-backed matrices created by {@linkcode initializeMatrixFromHdf5} with `fileBacked = true`, an object containing:
+     *
+     * - `fetches`: number of rows/columns that were read from the file-backed matrix.
+     * - `hits`: number of fetches that were served from the chunk cache.
+     * - `misses`: number of fetches that required reading chunks from the file.
+     * - `chunksRead`: estimated number of Deflate-compressed chunks that were read from the file and inflated.
+     *   This assumes that each miss reads all chunks overlapping the requested row/column.
+     * - `bytesCompressed`: number of compressed bytes in the chunks that were read.
+     * - `bytesDecompressed`: number of bytes produced by inflating those chunks.
+     *
+     * Counts include all accesses by matrices derived from this one, e.g., via delayed operations.
+     * Chunks that are not Deflate-compressed are not counted in `chunksRead` and the byte counts.
+     * For other matrices, `null` is returned.
+     */
+    fileAccessStatistics() {
+        return this.#matrix.file_access_statistics();
+    }
+
+    /**
+     * @return The counters in {@linkcode ScranMatrix#fileAccessStatistics fileAccessStatistics} are reset to zero.
+     */
+    resetFileAccessStatistics() {
+        this.#matrix.reset_file_access_statistics();
+        return;
+    }
 }
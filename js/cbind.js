@@ -18,16 +18,27 @@ function harvest_matrices(x) {
  * @param {Array} inputs - Array of one or more {@linkplain ScranMatrix} objects.
  * All of these should have the same number and order of features.
  *
+ * @param {object} [options={}] - Optional parameters.
+ * @param {boolean} [options.physical=false] - Whether to physically combine the matrices into a single compressed sparse column matrix.
+ * This is only performed if all `inputs` are sparse, otherwise a delayed combination is always used.
+ * A physical combination uses more memory but is faster to iterate over in downstream steps, especially when there are many `inputs`.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use for a physical combination.
+ * If `null`, defaults to {@linkcode maximumThreads}.
+ *
  * @return {ScranMatrix} A {@linkplain ScranMatrix} containing the matrices after combining them by column.
  */
-export function cbind(inputs) {
+export function cbind(inputs, options = {}) {
+    const { physical = false, numberOfThreads = null, ...others } = options;
+    utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
+
     let mat_ptrs;
     let output;
 
     try {
         mat_ptrs = harvest_matrices(inputs);
         output = gc.call(
-            module => module.cbind(mat_ptrs.length, mat_ptrs.offset),
+            module => module.cbind(mat_ptrs.length, mat_ptrs.offset, physical, nthreads),
             ScranMatrix
         );
     } catch (e) {
@@ -46,16 +57,27 @@ export function cbind(inputs) {
  * @param {Array} inputs - Array of one or more {@linkplain ScranMatrix} objects.
  * All of these should have the same number and order of cells.
  *
+ * @param {object} [options={}] - Optional parameters.
+ * @param {boolean} [options.physical=false] - Whether to physically combine the matrices into a single compressed sparse row matrix.
+ * This is only performed if all `inputs` are sparse, otherwise a delayed combination is always used.
+ * A physical combination uses more memory but is faster to iterate over in downstream steps, especially when there are many `inputs`.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use for a physical combination.
+ * If `null`, defaults to {@linkcode maximumThreads}.
+ *
  * @return {ScranMatrix} A {@linkplain ScranMatrix} containing the matrices after combining them by row.
  */
-export function rbind(inputs) {
+export function rbind(inputs, options = {}) {
+    const { physical = false, numberOfThreads = null, ...others } = options;
+    utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
+
     let mat_ptrs;
     let output;
 
     try {
         mat_ptrs = harvest_matrices(inputs);
         output = gc.call(
-            module => module.rbind(mat_ptrs.length, mat_ptrs.offset),
+            module => module.rbind(mat_ptrs.length, mat_ptrs.offset, physical, nthreads),
             ScranMatrix
         );
     } catch (e) {
@@ -87,8 +109,9 @@ export function rbind(inputs) {
  *    This is guaranteed to be sorted.
  * - `names`, an array of names identifying the rows of `matrix`.
  *    This is constructed by indexing the first entry of `names` with `indices`.
+ * @param {object} [options={}] - Optional parameters, passed to {@linkcode cbind}.
  */
-export function cbindWithNames(x, names) {
+export function cbindWithNames(x, names, options = {}) {
     // Find the intersection of names, following the order of the first entry.
     // We do so to try to improve the chance of getting an ordered subset for efficient extraction.
     let ordered_intersection = [];
@@ -142,7 +165,7 @@ export function cbindWithNames(x, names) {
             tmp_sliced.push(subset.subsetRows(x[n], survivors));
         }
 
-        output.matrix = cbind(tmp_sliced);
+        output.matrix = cbind(tmp_sliced, options);
         output.indices = tmp_subset[0].slice();
         output.names = ordered_intersection;
 
@@ -1,16 +1,21 @@
 import * as utils from "./utils.js";
 import * as wasm from "./wasm.js";
 import * as fac from "./factorize.js";
+import * as sp from "./stringPool.js";
 
 function check_shape(x, shape) {
+    // String pools are treated like an array of strings.
+    const is_pool = sp.isStringPool(x);
+    const length = (is_pool ? x.offsets.length - 1 : x.length);
+
     if (shape.length > 0) {
         let full_length = shape.reduce((a, b) => a * b);
-        if (x.length != full_length) {
+        if (length != full_length) {
             throw new Error("length of 'x' must be equal to the product of 'shape'");
         }
     } else {
-        if (x instanceof Array || ArrayBuffer.isView(x)) {
-            if (x.length != 1) {
+        if (is_pool || x instanceof Array || ArrayBuffer.isView(x)) {
+            if (length != 1) {
                 throw new Error("length of 'x' should be 1 for a scalar dataset");
             }
         } else {
@@ -712,6 +717,25 @@ export class H5DataSet extends H5Base {
         }
     }
 
+    /**
+     * Load the contents of a string dataset as a {@linkplain StringPool}.
+     * This is more efficient than {@linkcode H5DataSet#values values} for large datasets, e.g., with millions of barcodes.
+     *
+     * @return {StringPool} String pool containing the contents of this dataset.
+     */
+    stringPool() {
+        if (!(this.#type instanceof H5StringType)) {
+            throw new Error("cannot load a string pool for a non-string dataset");
+        }
+
+        let x = wasm.call(module => new module.LoadedH5DataSet(this.file, this.name));
+        try {
+            return sp.extractStringPool(x.string_pool());
+        } finally {
+            x.delete();
+        }
+    }
+
     // Provided for back-compatibility only.
     get levels() {
         return this.#type.levels;
@@ -726,9 +750,10 @@ export class H5DataSet extends H5Base {
     }
 
     /**
-     * @param {Array|TypedArray|number|string} x - Values to write to the dataset.
+     * @param {Array|TypedArray|number|string|StringPool} x - Values to write to the dataset.
      * This should be of length equal to the product of {@linkcode H5DataSet#shape shape};
      * unless `shape` is empty, in which case it should either be of length 1, or a single number or string.
+     * For string datasets, this may also be a {@linkplain StringPool} containing the same number of strings.
      * @param {object} [options={}] - Optional parameters.
      *
      * @return `x` is written to the dataset on file.
@@ -741,6 +766,18 @@ export class H5DataSet extends H5Base {
         if (x === null) {
             throw new Error("cannot write 'null' to HDF5"); 
         }
+
+        if (sp.isStringPool(x)) {
+            if (!(this.#type instanceof H5StringType)) {
+                throw new Error("string pools can only be written to string datasets");
+            }
+            check_shape(x, this.shape);
+            sp.wasmifyStringPool(x, (bytes_offset, bytes_length, offsets_offset, n) => {
+                wasm.call(module => module.write_string_pool_hdf5_dataset(this.file, this.name, bytes_offset, bytes_length, offsets_offset, n));
+            });
+            return;
+        }
+
         x = check_shape(x, this.shape);
 
         if (typeof this.#type == "string") {
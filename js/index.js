@@ -1,4 +1,4 @@
-export { initialize, terminate, wasmArraySpace, heapSize, maximumThreads } from "./wasm.js";
+export { initialize, terminate, wasmArraySpace, heapSize, heapUsage, releaseScratchSpace, maximumThreads, usesSimd } from "./wasm.js";
 export { createUint8WasmArray, createInt32WasmArray, createFloat64WasmArray, free } from "./utils.js";
 
 export * from "./initializeMatrixFromArrays.js";
@@ -10,6 +10,7 @@ export * from "./rds.js";
 export * from "./file.js"; 
 
 export * from "./hdf5.js";
+export { decodeStringPool, encodeStringPool } from "./stringPool.js";
 export * from "./writeSparseMatrixToHdf5.js";
 
 export * from "./guessFeatures.js";
@@ -20,6 +21,7 @@ export * from "./cbind.js";
 export * from "./subset.js";
 export * from "./delayed.js";
 export * from "./matrixStats.js";
+export * from "./realizeMatrix.js";
 
 export * from "./perCellRnaQcMetrics.js";
 export * from "./perCellAdtQcMetrics.js";
@@ -13,11 +13,14 @@ import { ScranMatrix } from "./ScranMatrix.js";
  * @param {object} [options={}] - Optional parameters.
  * @param {boolean} [options.columnMajor=true] - Whether `values` contains the matrix in a column-major order.
  * @param {boolean} [options.forceInteger=false] - Whether to coerce `values` to integers via truncation.
+ * @param {boolean} [options.singlePrecision=false] - Whether to store non-integer values in single precision (i.e., as 32-bit floats) to reduce memory usage.
+ * All values are still reported as 64-bit floats by the ScranMatrix, though some precision will be lost.
+ * Only used if `values` does not contain an integer type and `forceInteger = false`.
  *
  * @return {ScranMatrix} Matrix containing dense data.
  */
 export function initializeDenseMatrixFromDenseArray(numberOfRows, numberOfColumns, values, options = {}) {
-    const { columnMajor = true, forceInteger = false, ...others } = options;
+    const { columnMajor = true, forceInteger = false, singlePrecision = false, ...others } = options;
     utils.checkOtherOptions(others);
 
     var val_data; 
@@ -36,7 +39,8 @@ export function initializeDenseMatrixFromDenseArray(numberOfRows, numberOfColumn
                 val_data.offset, 
                 val_data.constructor.className.replace("Wasm", ""),
                 columnMajor,
-                forceInteger
+                forceInteger,
+                singlePrecision
             ),
             ScranMatrix
         );
@@ -66,11 +70,14 @@ export function initializeDenseMatrixFromDenseArray(numberOfRows, numberOfColumn
  * @param {boolean} [options.layered=true] - Whether to create a layered sparse matrix, see [**tatami_layered**](https://github.com/tatami-inc/tatami_layered) for more details.
  * Only used if `values` contains an integer type and/or `forceInteger = true`.
  * Setting `layered = true` assumes that `values` contains only non-negative integers.
+ * @param {boolean} [options.singlePrecision=false] - Whether to store non-integer values in single precision (i.e., as 32-bit floats) to reduce memory usage.
+ * All values are still reported as 64-bit floats by the ScranMatrix, though some precision will be lost.
+ * Only used if `values` does not contain an integer type and `forceInteger = false`.
  *
  * @return {ScranMatrix} Matrix containing sparse data.
  */
 export function initializeSparseMatrixFromDenseArray(numberOfRows, numberOfColumns, values, options = {}) {
-    const { columnMajor = true, forceInteger = true, layered = true, ...others } = options;
+    const { columnMajor = true, forceInteger = true, layered = true, singlePrecision = false, ...others } = options;
     utils.checkOtherOptions(others);
 
     var val_data; 
@@ -90,7 +97,8 @@ export function initializeSparseMatrixFromDenseArray(numberOfRows, numberOfColum
                 val_data.constructor.className.replace("Wasm", ""),
                 columnMajor,
                 forceInteger,
-                layered
+                layered,
+                singlePrecision
             ),
             ScranMatrix
         );
@@ -124,11 +132,14 @@ export function initializeSparseMatrixFromDenseArray(numberOfRows, numberOfColum
  * @param {boolean} [options.layered=true] - Whether to create a layered sparse matrix, see [**tatami_layered**](https://github.com/tatami-inc/tatami_layered) for more details.
  * Only used if `values` contains an integer type and/or `forceInteger = true`.
  * Setting to `true` assumes that `values` contains only non-negative integers.
+ * @param {boolean} [options.singlePrecision=false] - Whether to store non-integer values in single precision (i.e., as 32-bit floats) to reduce memory usage.
+ * All values are still reported as 64-bit floats by the ScranMatrix, though some precision will be lost.
+ * Only used if `values` does not contain an integer type and `forceInteger = false`.
  *
  * @return {ScranMatrix} Matrix containing sparse data.
  */ 
 export function initializeSparseMatrixFromSparseArrays(numberOfRows, numberOfColumns, values, indices, pointers, options = {}) {
-    const { byRow = true, forceInteger = true, layered = true, ...others } = options;
+    const { byRow = true, forceInteger = true, layered = true, singlePrecision = false, ...others } = options;
     utils.checkOtherOptions(others);
 
     var val_data;
@@ -160,7 +171,8 @@ export function initializeSparseMatrixFromSparseArrays(numberOfRows, numberOfCol
                 indp_data.constructor.className.replace("Wasm", ""), 
                 byRow,
                 forceInteger,
-                layered
+                layered,
+                singlePrecision
             ),
             ScranMatrix
         );
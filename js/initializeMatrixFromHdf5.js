@@ -2,16 +2,17 @@ import * as gc from "./gc.js";
 import * as wasm from "./wasm.js";
 import * as utils from "./utils.js"; 
 import { ScranMatrix } from "./ScranMatrix.js";
+import { MultiMatrix } from "./MultiMatrix.js";
 
 export function initializeMatrixFromHdf5(file, name, options = {}) {
-    const { forceInteger = true, forceSparse = true, layered = true, subsetRow = null, subsetColumn = null, ...others } = options;
+    const { forceInteger = true, forceSparse = true, layered = true, singlePrecision = false, subsetRow = null, subsetColumn = null, fileBacked = false, cacheSize = 100000000, cachePolicy = "predictive", numberOfThreads = null, minimumColumnTotal = null, columnTotalType = "nonzero", ...others } = options;
     utils.checkOtherOptions(others);
 
     const details = extractHdf5MatrixDetails(file, name);
     if (details.format == "dense") {
-        return initializeSparseMatrixFromHdf5Dataset(file, name, { forceInteger, forceSparse, layered, subsetRow, subsetColumn });
+        return initializeSparseMatrixFromHdf5Dataset(file, name, { forceInteger, forceSparse, layered, singlePrecision, subsetRow, subsetColumn, fileBacked, cacheSize, cachePolicy, numberOfThreads });
     } else {
-        return initializeSparseMatrixFromHdf5Group(file, name, details.rows, details.columns, (details.format == "csr"), { forceInteger, layered, subsetRow, subsetColumn });
+        return initializeSparseMatrixFromHdf5Group(file, name, details.rows, details.columns, (details.format == "csr"), { forceInteger, layered, singlePrecision, subsetRow, subsetColumn, fileBacked, cacheSize, cachePolicy, numberOfThreads, minimumColumnTotal, columnTotalType });
     }
 }
 
@@ -82,16 +83,32 @@ function processSubsets(subsetRow, subsetColumn, FUN) {
  * Only used if a sparse matrix is created (i.e., `forceSparse = true` or `name` refers to a HDF5 group)
  * and the matrix contents are integer (i.e., the relevant HDF5 dataset is of an integer type or `forceInteger = true`).
  * Setting to `true` assumes that the matrix contains only non-negative integers.
+ * @param {boolean} [options.singlePrecision=false] - Whether to store non-integer values in single precision (i.e., as 32-bit floats) to reduce memory usage.
+ * All values are still reported as 64-bit floats by the ScranMatrix, though some precision will be lost.
+ * Only used if the relevant HDF5 dataset does not contain an integer type and `forceInteger = false`.
  * @param {?(Array|TypedArray|Int32WasmArray)} [options.subsetRow=null] - Row indices to extract.
  * All indices must be non-negative integers less than the number of rows in the sparse matrix.
  * @param {?(Array|TypedArray|Int32WasmArray)} [options.subsetColumn=null] - Column indices to extract.
  * All indices must be non-negative integers less than the number of columns in the sparse matrix.
+ * @param {boolean} [options.fileBacked=false] - Whether to return a file-backed matrix, where rows and columns are read from the file on demand.
+ * This avoids loading the entire matrix into memory, at the cost of slower access.
+ * If `true`, `forceSparse` and `layered` are ignored; integer status and `singlePrecision` only affect the type used for caching.
+ * This is most useful in Node.js with a `NODERAWFS`-style filesystem, as files in the browser's virtual filesystem are already in memory.
+ * @param {number} [options.cacheSize=100000000] - Size of the chunk cache in bytes, when `fileBacked = true`.
+ * @param {string} [options.cachePolicy="predictive"] - Caching policy when `fileBacked = true`.
+ * This can be `"predictive"`, to prefetch chunks for rows/columns that will be accessed later (e.g., during consecutive access by most functions);
+ * `"lru"`, to cache the most recently used chunks without any prediction;
+ * or `"none"`, to disable the cache such that each row/column is read directly from the file.
+ * The effectiveness of each policy can be assessed with {@linkcode ScranMatrix#fileAccessStatistics fileAccessStatistics}.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use when realizing an in-memory matrix.
+ * If `null`, defaults to {@linkcode maximumThreads}.
  *
- * @return {ScranMatrix} In-memory matrix.
+ * @return {ScranMatrix} In-memory or file-backed matrix.
  */
 export function initializeMatrixFromHdf5Dataset(file, name, options = {}) {
-    const { transposed = true, forceInteger = true, forceSparse = true, layered = true, subsetRow = null, subsetColumn = null, ...others } = options;
+    const { transposed = true, forceInteger = true, forceSparse = true, layered = true, singlePrecision = false, subsetRow = null, subsetColumn = null, fileBacked = false, cacheSize = 100000000, cachePolicy = "predictive", numberOfThreads = null, ...others } = options;
     utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
 
     return processSubsets(
         subsetRow,
@@ -104,12 +121,17 @@ export function initializeMatrixFromHdf5Dataset(file, name, options = {}) {
                 forceInteger,
                 forceSparse,
                 layered,
+                singlePrecision,
                 use_row_subset,
                 row_offset,
                 row_length,
                 use_col_subset,
                 col_offset,
-                col_length
+                col_length,
+                fileBacked,
+                cacheSize,
+                cachePolicy,
+                nthreads
             );
         }
     );
@@ -134,21 +156,64 @@ export const initializeSparseMatrixFromHdf5Dataset = initializeMatrixFromHdf5Dat
  * @param {boolean} [options.layered=true] - Whether to create a layered sparse matrix, see [**tatami_layered**](https://github.com/tatami-inc/tatami_layered) for more details.
  * Only used if the relevant HDF5 dataset contains an integer type and/or `forceInteger = true`.
  * Setting to `true` assumes that the matrix contains only non-negative integers.
+ * @param {boolean} [options.singlePrecision=false] - Whether to store non-integer values in single precision (i.e., as 32-bit floats) to reduce memory usage.
+ * All values are still reported as 64-bit floats by the ScranMatrix, though some precision will be lost.
+ * Only used if the relevant HDF5 dataset does not contain an integer type and `forceInteger = false`.
  * @param {?(Array|TypedArray|Int32WasmArray)} [options.subsetRow=null] - Row indices to extract.
  * All indices must be non-negative integers less than the number of rows in the sparse matrix.
  * @param {?(Array|TypedArray|Int32WasmArray)} [options.subsetColumn=null] - Column indices to extract.
  * All indices must be non-negative integers less than the number of columns in the sparse matrix.
+ * @param {boolean} [options.fileBacked=false] - Whether to return a file-backed matrix, where rows and columns are read from the file on demand.
+ * This avoids loading the entire matrix into memory, at the cost of slower access.
+ * If `true`, `layered` is ignored; integer status and `singlePrecision` only affect the type used for caching.
+ * @param {number} [options.cacheSize=100000000] - Size of the chunk cache in bytes, when `fileBacked = true`.
+ * @param {string} [options.cachePolicy="predictive"] - Caching policy when `fileBacked = true`.
+ * This can be `"predictive"`, to prefetch chunks for rows/columns that will be accessed later (e.g., during consecutive access by most functions);
+ * `"lru"`, to cache the most recently used chunks without any prediction;
+ * or `"none"`, to disable the cache such that each row/column is read directly from the file.
+ * The effectiveness of each policy can be assessed with {@linkcode ScranMatrix#fileAccessStatistics fileAccessStatistics}.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use when loading an in-memory matrix.
+ * If greater than 1, the deflate-compressed chunks of `data` and `indices` are read from the file and inflated in parallel.
+ * This is only used for CSR matrices with `layered = false`, where the loaded matrix can be returned without another copy;
+ * it is not used when `subsetRow` or `subsetColumn` are supplied, or if the datasets use other filters.
+ * If `null`, defaults to {@linkcode maximumThreads}.
+ * @param {?number} [options.minimumColumnTotal=null] - Minimum column total, see {@linkcode computeHdf5ColumnTotals}.
+ * If supplied, only columns with totals greater than or equal to this value are loaded, e.g., to skip empty barcodes in raw 10X HDF5 files.
+ * If `subsetColumn` is also supplied, columns in `subsetColumn` that do not meet this threshold are removed.
+ * The indices of the retained columns can be obtained by calling {@linkcode computeHdf5ColumnTotals} directly and passing the filtered indices to `subsetColumn`.
+ * @param {string} [options.columnTotalType="nonzero"] - Type of column total to compute when `minimumColumnTotal` is supplied, see {@linkcode computeHdf5ColumnTotals}.
  *
- * @return {ScranMatrix} In-memory matrix containing sparse data.
+ * @return {ScranMatrix} In-memory or file-backed matrix containing sparse data.
  */
 export function initializeSparseMatrixFromHdf5Group(file, name, numberOfRows, numberOfColumns, byRow, options = {}) {
-    const { forceInteger = true, layered = true, subsetRow = null, subsetColumn = null, ...others } = options;
+    let { forceInteger = true, layered = true, singlePrecision = false, subsetRow = null, subsetColumn = null, fileBacked = false, cacheSize = 100000000, cachePolicy = "predictive", numberOfThreads = null, minimumColumnTotal = null, columnTotalType = "nonzero", ...others } = options;
     utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
 
     if (typeof name == "string") {
         name = { data: name + "/data", indices: name + "/indices", indptr: name + "/indptr" };
     }
 
+    if (minimumColumnTotal !== null) {
+        const totals = computeHdf5ColumnTotals(file, name, numberOfRows, numberOfColumns, byRow, { type: columnTotalType });
+        const keep = [];
+        if (subsetColumn === null) {
+            for (var c = 0; c < numberOfColumns; c++) {
+                if (totals[c] >= minimumColumnTotal) {
+                    keep.push(c);
+                }
+            }
+        } else {
+            const candidates = (typeof subsetColumn.array == "function" ? subsetColumn.array() : subsetColumn);
+            for (const c of candidates) {
+                if (totals[c] >= minimumColumnTotal) {
+                    keep.push(c);
+                }
+            }
+        }
+        subsetColumn = keep;
+    }
+
     return processSubsets(
         subsetRow,
         subsetColumn, 
@@ -163,17 +228,184 @@ export function initializeSparseMatrixFromHdf5Group(file, name, numberOfRows, nu
                 !byRow,
                 forceInteger,
                 layered, 
+                singlePrecision,
                 use_row_subset,
                 row_offset,
                 row_length,
                 use_col_subset,
                 col_offset,
-                col_length
+                col_length,
+                fileBacked,
+                cacheSize,
+                cachePolicy,
+                nthreads
             );
         }
     );
 }
 
+/**
+ * Compute the total for each column of a sparse matrix in a HDF5 group, without loading the matrix into memory.
+ * This is typically used to identify non-empty barcodes in raw 10X HDF5 files before loading them with `subsetColumn`.
+ *
+ * @param {string} file Path to the HDF5 file.
+ * For browsers, the file should have been saved to the virtual filesystem.
+ * @param {string|object} name - Name of the HDF5 group containing the matrix, see {@linkcode initializeSparseMatrixFromHdf5Group} for details.
+ * @param {number} numberOfRows - Number of rows in the sparse matrix.
+ * @param {number} numberOfColumns - Number of columns in the sparse matrix.
+ * @param {boolean} byRow - Whether the matrix is in the compressed sparse row format.
+ * @param {object} [options={}] - Optional parameters.
+ * @param {string} [options.type="nonzero"] - Type of total to compute.
+ * This can be `"nonzero"`, for the number of non-zero elements in each column;
+ * or `"sum"`, for the sum of values in each column.
+ * For compressed sparse column matrices, `"nonzero"` only requires the `indptr` dataset,
+ * while `"sum"` requires a single pass through the `data` dataset.
+ * For compressed sparse row matrices, the `indices` dataset (and `data`, for `"sum"`) must be read in its entirety.
+ *
+ * @return {Float64Array} Array of length equal to `numberOfColumns`, containing the total for each column.
+ */
+export function computeHdf5ColumnTotals(file, name, numberOfRows, numberOfColumns, byRow, options = {}) {
+    const { type = "nonzero", ...others } = options;
+    utils.checkOtherOptions(others);
+    utils.matchOptions("type", type, [ "nonzero", "sum" ]);
+
+    if (typeof name == "string") {
+        name = { data: name + "/data", indices: name + "/indices", indptr: name + "/indptr" };
+    }
+
+    let output;
+    try {
+        output = utils.createFloat64WasmArray(numberOfColumns);
+        wasm.call(module => module.compute_hdf5_sparse_column_totals(
+            file,
+            name.data,
+            name.indices,
+            name.indptr,
+            numberOfColumns,
+            !byRow,
+            type == "sum",
+            output.offset
+        ));
+    } catch (e) {
+        utils.free(output);
+        throw e;
+    }
+
+    return utils.toTypedArray(output, false, true);
+}
+
+/**
+ * Initialize one {@link ScranMatrix} per modality from a sparse matrix in a HDF5 group, e.g., for CITE-seq or CRISPR data in 10X HDF5 files.
+ * All modalities are filled in a single pass through the `data` and `indices` datasets, without creating the combined matrix.
+ * For CSC matrices, `indices` is also scanned beforehand to count the non-zero elements in each modality.
+ * The loaded values and indices of all modalities are held in memory until each modality is realized in turn.
+ *
+ * @param {string} file Path to the HDF5 file.
+ * For browsers, the file should have been saved to the virtual filesystem.
+ * @param {string|object} name - Name of the HDF5 group containing the matrix, see {@linkcode initializeSparseMatrixFromHdf5Group} for details.
+ * @param {number} numberOfRows - Number of rows in the sparse matrix.
+ * @param {number} numberOfColumns - Number of columns in the sparse matrix.
+ * @param {boolean} byRow - Whether the matrix is in the compressed sparse row format.
+ * @param {Array} modalities - Array of length equal to `numberOfRows`, containing the name of the modality for each row (e.g., from `features/feature_type` in 10X HDF5 files).
+ * Rows with `null` modalities are discarded.
+ * @param {object} [options={}] - Optional parameters.
+ * @param {boolean} [options.forceInteger=true] - Whether to coerce all elements to integers via truncation.
+ * @param {boolean} [options.layered=true] - Whether to create layered sparse matrices, see {@linkcode initializeSparseMatrixFromHdf5Group} for details.
+ * @param {boolean} [options.singlePrecision=false] - Whether to store non-integer values in single precision, see {@linkcode initializeSparseMatrixFromHdf5Group} for details.
+ * @param {Array} [options.dense=[]] - Names of modalities to be stored as dense matrices, e.g., for ADT data where most values are non-zero.
+ * @param {boolean} [options.createMultiMatrix=false] - Whether the output should be returned as a {@linkplain MultiMatrix}.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use when realizing each matrix.
+ * If `null`, defaults to {@linkcode maximumThreads}.
+ *
+ * @return {object|MultiMatrix} Object where each key is a modality name and each value is a ScranMatrix containing the rows for that modality.
+ * Rows are reported in the same order as in the original matrix.
+ * Alternatively, this is wrapped in a MultiMatrix if `createMultiMatrix = true`.
+ */
+export function splitSparseMatrixFromHdf5Group(file, name, numberOfRows, numberOfColumns, byRow, modalities, options = {}) {
+    const { forceInteger = true, layered = true, singlePrecision = false, dense = [], createMultiMatrix = false, numberOfThreads = null, ...others } = options;
+    utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
+
+    if (typeof name == "string") {
+        name = { data: name + "/data", indices: name + "/indices", indptr: name + "/indptr" };
+    }
+    if (modalities.length != numberOfRows) {
+        throw new Error("length of 'modalities' should be equal to the number of rows");
+    }
+
+    let levels = [];
+    let mapping = new Map;
+    let codes;
+    let wasm_dense;
+    let raw;
+    let output = {};
+    let stuff;
+
+    try {
+        codes = utils.createInt32WasmArray(numberOfRows);
+        const carr = codes.array();
+        for (var r = 0; r < numberOfRows; r++) {
+            const mod = modalities[r];
+            if (mod === null) {
+                carr[r] = -1;
+                continue;
+            }
+            if (!mapping.has(mod)) {
+                mapping.set(mod, levels.length);
+                levels.push(mod);
+            }
+            carr[r] = mapping.get(mod);
+        }
+
+        wasm_dense = utils.createUint8WasmArray(levels.length);
+        wasm_dense.set(levels.map(l => dense.indexOf(l) >= 0 ? 1 : 0));
+
+        raw = wasm.call(module => module.initialize_from_hdf5_sparse_by_modality(
+            file,
+            name.data,
+            name.indices,
+            name.indptr,
+            numberOfRows,
+            numberOfColumns,
+            !byRow,
+            codes.offset,
+            levels.length,
+            wasm_dense.offset,
+            forceInteger,
+            layered,
+            singlePrecision,
+            nthreads
+        ));
+
+        for (var m = 0; m < levels.length; m++) {
+            output[levels[m]] = gc.call(module => raw.matrix(m), ScranMatrix);
+        }
+
+        if (createMultiMatrix) {
+            stuff = new MultiMatrix({ store: output });
+        }
+
+    } catch (e) {
+        for (const v of Object.values(output)) {
+            v.free();
+        }
+        throw e;
+
+    } finally {
+        utils.free(codes);
+        utils.free(wasm_dense);
+        if (raw) {
+            raw.delete();
+        }
+    }
+
+    if (createMultiMatrix) {
+        return stuff;
+    } else {
+        return output;
+    }
+}
+
 export function extractHdf5MatrixDetails(file, name) { 
     return wasm.call(module => module.extract_hdf5_matrix_details(file, name));
 }
@@ -1,8 +1,60 @@
 import * as gc from "./gc.js";
 import * as wasm from "./wasm.js";
 import * as utils from "./utils.js"; 
+import * as wa from "wasmarrays.js";
 import { ScranMatrix } from "./ScranMatrix.js";
 
+function wasmifySubset(subset, asMask) {
+    if (subset === null) {
+        return { indices: null, maskLength: -1 };
+    }
+
+    // Plain arrays of booleans are always treated as masks, other arrays are only treated as masks if requested.
+    if (asMask === null) {
+        asMask = Array.isArray(subset) && subset.length > 0 && typeof subset[0] === "boolean";
+    }
+    if (!asMask) {
+        return { indices: utils.wasmifyArray(subset, "Int32WasmArray"), maskLength: -1 };
+    }
+
+    // Converting a boolean mask into indices of the retained elements.
+    // The length of the mask is checked against the dimensions in the file once the header is parsed.
+    let values = (subset instanceof wa.WasmArray ? subset.array() : subset);
+    let indices = [];
+    values.forEach((x, i) => {
+        if (x) {
+            indices.push(i);
+        }
+    });
+    return { indices: utils.wasmifyArray(indices, "Int32WasmArray"), maskLength: values.length };
+}
+
+function callWithSubsets(subsetRow, subsetColumn, subsetAsMask, FUN) {
+    let wasm_row;
+    let wasm_column;
+    try {
+        wasm_row = wasmifySubset(subsetRow, subsetAsMask);
+        wasm_column = wasmifySubset(subsetColumn, subsetAsMask);
+        return FUN(
+            wasm_row.indices !== null,
+            wasm_row.indices === null ? 0 : wasm_row.indices.offset,
+            wasm_row.indices === null ? 0 : wasm_row.indices.length,
+            wasm_row.maskLength,
+            wasm_column.indices !== null,
+            wasm_column.indices === null ? 0 : wasm_column.indices.offset,
+            wasm_column.indices === null ? 0 : wasm_column.indices.length,
+            wasm_column.maskLength
+        );
+    } finally {
+        if (wasm_row) {
+            utils.free(wasm_row.indices);
+        }
+        if (wasm_column) {
+            utils.free(wasm_column.indices);
+        }
+    }
+}
+
 /** 
  * Initialize a sparse matrix from a buffer containing a MatrixMarket file.
  *
@@ -15,12 +67,29 @@ import { ScranMatrix } from "./ScranMatrix.js";
  * @param {?boolean} [options.compression="unknown"] - Whether the buffer is Gzip-compressed (`"gzip"`) or uncompressed (`"none"`).
  * If `"unknown"`, we detect this automatically from the magic number in the header.
  * @param {boolean} [options.layered=true] - Whether to create a layered sparse matrix, see [**tatami_layered**](https://github.com/tatami-inc/tatami_layered) for more details.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use.
+ * If `null`, defaults to {@linkcode maximumThreads}.
+ * For general coordinate matrices, multiple threads are used to parse uncompressed buffers in parallel,
+ * to inflate BGZF-compressed buffers in parallel, or to inflate other Gzip-compressed buffers and files in a separate thread from the parsing.
+ * @param {?(Array|TypedArray|WasmArray)} [options.subsetRow=null] - Row indices to extract.
+ * Alternatively, a boolean mask of length equal to the number of rows, where truthy values indicate the rows to extract, see `subsetAsMask`.
+ * All rows are extracted if `null`.
+ * @param {?(Array|TypedArray|WasmArray)} [options.subsetColumn=null] - Column indices to extract.
+ * Alternatively, a boolean mask of length equal to the number of columns, where truthy values indicate the columns to extract, see `subsetAsMask`.
+ * All columns are extracted if `null`.
+ * @param {?boolean} [options.subsetAsMask=null] - Whether `subsetRow` and `subsetColumn` are boolean masks.
+ * If `null`, only plain arrays of booleans are treated as masks, and all other arrays are treated as indices.
+ * This should be set to `true` for masks in TypedArrays or WasmArrays, e.g., the Uint8Array from {@linkcode SuggestRnaQcFiltersResults#filter filter}.
+ * An error is raised if the length of a mask is not equal to the number of rows or columns in the file.
+ * For general coordinate matrices, triplets outside of the subsets are discarded during parsing, so memory usage scales with the size of the subsetted matrix.
+ * The order of indices is respected in the output matrix.
  *
  * @return {ScranMatrix} Matrix containing sparse data.
  */
 export function initializeSparseMatrixFromMatrixMarket(x, options = {}) {
-    const { compression = "unknown", layered = true, ...others } = options;
+    const { compression = "unknown", layered = true, numberOfThreads = null, subsetRow = null, subsetColumn = null, subsetAsMask = null, ...others } = options;
     utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
 
     var buf_data;
     var output;
@@ -28,15 +97,15 @@ export function initializeSparseMatrixFromMatrixMarket(x, options = {}) {
     try {
         if (typeof x !== "string") {
             buf_data = utils.wasmifyArray(x, "Uint8WasmArray");
-            output = gc.call(
-                module => module.initialize_from_mtx_buffer(buf_data.offset, buf_data.length, compression, layered),
+            output = callWithSubsets(subsetRow, subsetColumn, subsetAsMask, (...subsets) => gc.call(
+                module => module.initialize_from_mtx_buffer(buf_data.offset, buf_data.length, compression, layered, ...subsets, nthreads),
                 ScranMatrix
-            );
+            ));
         } else {
-            output = gc.call(
-                module => module.initialize_from_mtx_file(x, compression, layered),
+            output = callWithSubsets(subsetRow, subsetColumn, subsetAsMask, (...subsets) => gc.call(
+                module => module.initialize_from_mtx_file(x, compression, layered, ...subsets, nthreads),
                 ScranMatrix
-            );
+            ));
         }
 
     } catch(e) {
@@ -83,3 +152,113 @@ export function extractMatrixMarketDimensions(x, options = {}) {
 
     return output;
 }
+
+/**
+ * Loader for a MatrixMarket file that is supplied in pieces, typically created by {@linkcode createMatrixMarketStreamLoader}.
+ * This avoids holding the entire (possibly compressed) file in memory alongside the parsed matrix.
+ * @hideconstructor
+ */
+export class MatrixMarketStreamLoader {
+    #id;
+    #loader;
+
+    constructor(id, raw) {
+        this.#id = id;
+        this.#loader = raw;
+        return;
+    }
+
+    /**
+     * @param {Uint8WasmArray|Array|TypedArray} chunk - Byte array containing the next piece of the MatrixMarket file.
+     * Pieces may be split at arbitrary positions, e.g., in the middle of a line or of a Gzip member.
+     *
+     * @return The contents of `chunk` are parsed.
+     */
+    feed(chunk) {
+        let chunk_data;
+        try {
+            chunk_data = utils.wasmifyArray(chunk, "Uint8WasmArray");
+            wasm.call(module => this.#loader.feed(chunk_data.offset, chunk_data.length));
+        } finally {
+            utils.free(chunk_data);
+        }
+        return;
+    }
+
+    /**
+     * @return {ScranMatrix} Matrix containing the sparse data from all pieces.
+     * No further pieces can be supplied after this method is called.
+     */
+    finish() {
+        return gc.call(module => this.#loader.finish(), ScranMatrix);
+    }
+
+    /**
+     * @return Frees the memory allocated on the Wasm heap for this object.
+     * This invalidates this object and all references to it.
+     */
+    free() {
+        if (this.#loader !== null) {
+            gc.release(this.#id);
+            this.#loader = null;
+        }
+        return;
+    }
+}
+
+/**
+ * Create a loader for a MatrixMarket file that is supplied in pieces, e.g., from a `ReadableStream` or from slices of a `File`.
+ * Only general coordinate matrices are supported.
+ *
+ * @param {object} [options={}] - Optional parameters.
+ * @param {?boolean} [options.compression="unknown"] - Whether the file is Gzip-compressed (`"gzip"`) or uncompressed (`"none"`).
+ * If `"unknown"`, we detect this automatically from the magic number in the first piece.
+ * @param {boolean} [options.layered=true] - Whether to create a layered sparse matrix, see [**tatami_layered**](https://github.com/tatami-inc/tatami_layered) for more details.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use when creating the matrix in {@linkcode MatrixMarketStreamLoader#finish finish}.
+ * If `null`, defaults to {@linkcode maximumThreads}.
+ * @param {?(Array|TypedArray|WasmArray)} [options.subsetRow=null] - Row indices to extract.
+ * Alternatively, a boolean mask of length equal to the number of rows, where truthy values indicate the rows to extract, see `subsetAsMask`.
+ * All rows are extracted if `null`.
+ * @param {?(Array|TypedArray|WasmArray)} [options.subsetColumn=null] - Column indices to extract.
+ * Alternatively, a boolean mask of length equal to the number of columns, where truthy values indicate the columns to extract, see `subsetAsMask`.
+ * All columns are extracted if `null`.
+ * @param {?boolean} [options.subsetAsMask=null] - Whether `subsetRow` and `subsetColumn` are boolean masks, see {@linkcode initializeSparseMatrixFromMatrixMarket} for details.
+ * Triplets outside of the subsets are discarded as each piece is parsed.
+ *
+ * @return {MatrixMarketStreamLoader} Loader for the MatrixMarket file.
+ */
+export function createMatrixMarketStreamLoader(options = {}) {
+    const { compression = "unknown", layered = true, numberOfThreads = null, subsetRow = null, subsetColumn = null, subsetAsMask = null, ...others } = options;
+    utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
+    return callWithSubsets(subsetRow, subsetColumn, subsetAsMask, (...subsets) => gc.call(
+        module => new module.MtxStreamLoader(compression, layered, ...subsets, nthreads),
+        MatrixMarketStreamLoader
+    ));
+}
+
+/**
+ * Initialize a sparse matrix from a `ReadableStream` of a MatrixMarket file, e.g., from the body of a `fetch()` response.
+ * This is a convenience wrapper around {@linkcode createMatrixMarketStreamLoader}.
+ *
+ * @param {ReadableStream} stream - Stream of bytes from a MatrixMarket file, possibly Gzip-compressed.
+ * @param {object} [options={}] - Further options to pass to {@linkcode createMatrixMarketStreamLoader}.
+ *
+ * @return {ScranMatrix} Matrix containing sparse data.
+ */
+export async function initializeSparseMatrixFromMatrixMarketStream(stream, options = {}) {
+    let loader = createMatrixMarketStreamLoader(options);
+    try {
+        let reader = stream.getReader();
+        while (true) {
+            const { done, value } = await reader.read();
+            if (done) {
+                break;
+            }
+            loader.feed(value);
+        }
+        return loader.finish();
+    } finally {
+        loader.free();
+    }
+}
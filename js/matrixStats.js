@@ -62,3 +62,104 @@ export function rowSums(x, options = {}) {
 export function columnSums(x, options = {}) {
     return matrix_sums(x, false, options);
 }
+
+const available_statistics = [ "sum", "mean", "variance", "detected", "min", "max", "median" ];
+
+/**
+ * Compute multiple statistics for each row or column of a {@link ScranMatrix} in a single pass.
+ * This is more efficient than computing each statistic separately, as each row/column only needs to be extracted once;
+ * especially for file-backed matrices or those with many delayed operations.
+ *
+ * @param {ScranMatrix} x - A matrix.
+ * @param {object} [options={}] - Optional parameters.
+ * @param {boolean} [options.row=true] - Whether to compute statistics for each row.
+ * If `false`, statistics are computed for each column.
+ * @param {Array} [options.statistics=["sum", "mean", "variance", "detected", "min", "max", "median"]] - Names of the statistics to compute.
+ * Each name should be one of `"sum"`, `"mean"`, `"variance"` (sample variance), `"detected"` (number of non-zero values), `"min"`, `"max"` or `"median"`.
+ * @param {?(Int32Array|Int32WasmArray)} [options.groups=null] - Array containing the group assignment for each column (if `row = true`) or row (otherwise).
+ * This should contain integers in \[0, `numberOfGroups`), in which case the statistics are computed separately for each group.
+ * If `null`, all columns/rows are treated as a single group.
+ * @param {?number} [options.numberOfGroups=null] - Number of groups.
+ * If `null`, this is set to the largest value in `groups` plus 1.
+ * Ignored if `groups = null`.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use.
+ * If `null`, defaults to {@linkcode maximumThreads}.
+ *
+ * @return {object} Object where each key is the name of a requested statistic and each value is a Float64Array.
+ * If `groups = null`, each array has length equal to the number of rows (if `row = true`) or columns (otherwise).
+ * Otherwise, each array has length equal to the product of the number of rows/columns and `numberOfGroups`,
+ * where the statistics for group `g` are stored at offset `g` times the number of rows/columns.
+ * For groups with no entries, all statistics other than `sum` and `detected` are set to NaN, as is the `variance` for groups with only one entry.
+ */
+export function matrixStats(x, options = {}) {
+    let { row = true, statistics = available_statistics, groups = null, numberOfGroups = null, numberOfThreads = null, ...others } = options;
+    utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
+
+    for (const s of statistics) {
+        if (available_statistics.indexOf(s) < 0) {
+            throw new Error("unknown statistic '" + s + "'");
+        }
+    }
+
+    let dim = (row ? x.numberOfRows() : x.numberOfColumns());
+    let otherdim = (row ? x.numberOfColumns() : x.numberOfRows());
+    let group_data = null;
+    let buffers = {};
+    let output = {};
+
+    try {
+        let ngroups = 1;
+        if (groups !== null) {
+            group_data = utils.wasmifyArray(groups, "Int32WasmArray");
+            if (group_data.length != otherdim) {
+                throw new Error("length of 'groups' should be equal to the number of " + (row ? "columns" : "rows"));
+            }
+
+            let garr = group_data.array();
+            let maxed = garr.reduce((a, b) => Math.max(a, b), -1);
+            if (numberOfGroups === null) {
+                numberOfGroups = maxed + 1;
+            }
+            if (maxed >= numberOfGroups || garr.some(g => g < 0)) {
+                throw new Error("'groups' should contain integers in [0, numberOfGroups)");
+            }
+            ngroups = numberOfGroups;
+        }
+
+        for (const s of statistics) {
+            if (!(s in buffers)) {
+                buffers[s] = utils.createFloat64WasmArray(dim * ngroups);
+            }
+        }
+
+        let offset = s => (s in buffers ? buffers[s].offset : 0);
+        wasm.call(module => module.matrix_stats(
+            x.matrix,
+            row,
+            group_data !== null,
+            (group_data !== null ? group_data.offset : 0),
+            ngroups,
+            offset("sum"),
+            offset("mean"),
+            offset("variance"),
+            offset("detected"),
+            offset("min"),
+            offset("max"),
+            offset("median"),
+            nthreads
+        ));
+
+        for (const [k, v] of Object.entries(buffers)) {
+            output[k] = v.slice();
+        }
+
+    } finally {
+        utils.free(group_data);
+        for (const v of Object.values(buffers)) {
+            utils.free(v);
+        }
+    }
+
+    return output;
+}
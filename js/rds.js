@@ -1,6 +1,7 @@
 import * as utils from "./utils.js";
 import * as wasm from "./wasm.js";
 import * as gc from "./gc.js";
+import * as sp from "./stringPool.js";
 
 /**
  * Base class for RDS objects.
@@ -168,6 +169,14 @@ export class RdsStringVector extends RdsVector {
     values() {
         return wasm.call(mod => this.object.string_vector());
     }
+
+    /**
+     * @return {StringPool} String pool containing the values of the string vector.
+     * This is more efficient than {@linkcode RdsStringVector#values values} for large vectors.
+     */
+    stringPool() {
+        return sp.extractStringPool(wasm.call(mod => this.object.string_pool()));
+    }
 }
 
 /**
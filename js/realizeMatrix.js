@@ -0,0 +1,52 @@
+import * as utils from "./utils.js";
+import * as wasm from "./wasm.js";
+
+/**
+ * Realize a {@linkplain ScranMatrix} into contiguous compressed sparse or dense storage.
+ * This collapses any delayed operations (e.g., from {@linkcode subsetColumns}, {@linkcode cbind}, {@linkcode normalizeCounts} or {@linkcode delayedArithmetic})
+ * so that their cost is only paid once, rather than in every downstream step that iterates over the matrix.
+ *
+ * @param {ScranMatrix} x - The matrix of interest.
+ * @param {object} [options={}] - Optional parameters.
+ * @param {?boolean} [options.sparse=null] - Whether to realize `x` into a compressed sparse matrix.
+ * If `false`, a dense matrix is created instead.
+ * If `null`, this is set to `x.isSparse()`.
+ * @param {boolean} [options.layered=false] - Whether to create a layered sparse matrix, see [**tatami_layered**](https://github.com/tatami-inc/tatami_layered) for more details.
+ * Only used if `sparse = true`.
+ * This should only be set to `true` if `x` contains non-negative integers, e.g., a subset of a count matrix.
+ * @param {boolean} [options.singlePrecision=false] - Whether to store the realized values in single precision (i.e., as 32-bit floats) to reduce memory usage.
+ * Ignored if `layered = true`.
+ * @param {boolean} [options.inPlace=false] - Whether to modify `x` in place.
+ * If `false`, a new ScranMatrix is returned.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use.
+ * If `null`, defaults to {@linkcode maximumThreads}.
+ *
+ * @return {ScranMatrix} A ScranMatrix containing the realized contents of `x`.
+ * If `inPlace = true`, this is a reference to `x`, otherwise it is a new ScranMatrix.
+ */
+export function realizeMatrix(x, options = {}) {
+    const { sparse = null, layered = false, singlePrecision = false, inPlace = false, numberOfThreads = null, ...others } = options;
+    utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
+
+    let xcopy;
+    let target;
+
+    try {
+        if (inPlace) {
+            target = x;
+        } else {
+            xcopy = x.clone();
+            target = xcopy;
+        }
+
+        let use_sparse = (sparse === null ? x.isSparse() : sparse);
+        wasm.call(module => module.realize_matrix(target.matrix, use_sparse, layered, singlePrecision, nthreads));
+
+    } catch (e) {
+        utils.free(xcopy);
+        throw e;
+    }
+
+    return target;
+}
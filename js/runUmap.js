@@ -82,6 +82,18 @@ export class UmapStatus {
         return utils.extractXY(this.numberOfCells(), this.#coordinates.array()); 
     }
 
+    /**
+     * @return {object} Object describing the memory used by this object on the Wasm heap.
+     * This contains `owned`, the number of bytes that will be released by {@linkcode UmapStatus#free free};
+     * and `shared`, the number of bytes that are shared with other objects (always zero here).
+     * The bytes used by the algorithm status are measured from the heap at initialization and should be treated as approximate.
+     */
+    memoryUsage() {
+        let usage = this.#status.memory_usage();
+        usage.owned += this.#coordinates.array().byteLength;
+        return usage;
+    }
+
     /**
      * @return Frees the memory allocated on the Wasm heap for this object.
      * This invalidates this object and all references to it.
@@ -142,6 +142,15 @@ export class ScoreMarkersResults {
         return utils.possibleCopy(wasm.call(_ => this.#results.delta_detected(group, summary)), copy);
     }
 
+    /**
+     * @return {object} Object describing the memory used by these results on the Wasm heap.
+     * This contains `owned`, the number of bytes that will be released by {@linkcode ScoreMarkersResults#free free};
+     * and `shared`, the number of bytes that are shared with other objects (always zero here).
+     */
+    memoryUsage() {
+        return this.#results.memory_usage();
+    }
+
     /**
      * @return Frees the memory allocated on the Wasm heap for this object.
      * This invalidates this object and all references to it.
@@ -0,0 +1,76 @@
+import * as utils from "./utils.js";
+
+/**
+ * A string pool is a compact representation of an array of strings, used to transfer large numbers of strings (e.g., barcodes or gene IDs) to and from the Wasm heap.
+ * It is an object containing:
+ *
+ * - `bytes`: a Uint8Array containing the UTF-8 encoded bytes of all strings, concatenated together.
+ * - `offsets`: a Uint32Array of length equal to the number of strings plus 1.
+ *   String `i` is stored in `bytes.subarray(offsets[i], offsets[i + 1])`.
+ *
+ * @typedef StringPool
+ * @type {object}
+ */
+
+/**
+ * @param {StringPool} pool - A string pool, e.g., from {@linkcode H5DataSet#stringPool H5DataSet.stringPool} or {@linkcode RdsStringVector#stringPool RdsStringVector.stringPool}.
+ * @return {Array} Array of strings in `pool`.
+ */
+export function decodeStringPool(pool) {
+    const { bytes, offsets } = pool;
+    const decoder = new TextDecoder;
+    const n = offsets.length - 1;
+    let output = new Array(n);
+    for (var i = 0; i < n; i++) {
+        output[i] = decoder.decode(bytes.subarray(offsets[i], offsets[i + 1]));
+    }
+    return output;
+}
+
+/**
+ * @param {Array} x - Array of strings.
+ * @return {StringPool} String pool containing the strings in `x`.
+ */
+export function encodeStringPool(x) {
+    const encoder = new TextEncoder;
+    let offsets = new Uint32Array(x.length + 1);
+    let encoded = new Array(x.length);
+    for (var i = 0; i < x.length; i++) {
+        encoded[i] = encoder.encode(x[i]);
+        offsets[i + 1] = offsets[i] + encoded[i].length;
+    }
+
+    let bytes = new Uint8Array(offsets[x.length]);
+    for (var i = 0; i < x.length; i++) {
+        bytes.set(encoded[i], offsets[i]);
+    }
+    return { bytes, offsets };
+}
+
+export function isStringPool(x) {
+    return x instanceof Object && "bytes" in x && "offsets" in x;
+}
+
+// Copies the contents of a StringPool object from the Wasm heap, as the
+// views are invalidated once the object is deleted.
+export function extractStringPool(raw) {
+    try {
+        return { bytes: raw.bytes().slice(), offsets: raw.offsets().slice() };
+    } finally {
+        raw.delete();
+    }
+}
+
+// Calls 'fun' with the offsets and lengths of the WasmArrays containing the pool.
+export function wasmifyStringPool(pool, fun) {
+    let wasm_bytes;
+    let wasm_offsets;
+    try {
+        wasm_bytes = utils.wasmifyArray(pool.bytes, "Uint8WasmArray");
+        wasm_offsets = utils.wasmifyArray(pool.offsets, "Uint32WasmArray");
+        return fun(wasm_bytes.offset, wasm_bytes.length, wasm_offsets.offset, wasm_offsets.length - 1);
+    } finally {
+        utils.free(wasm_bytes);
+        utils.free(wasm_offsets);
+    }
+}
@@ -100,6 +100,15 @@ export class SuggestRnaQcFiltersResults {
         return internal.applyFilter(this.#results, metrics, block, asTypedArray, buffer); 
     }
 
+    /**
+     * @return {object} Object describing the memory used by these results on the Wasm heap.
+     * This contains `owned`, the number of bytes that will be released by {@linkcode SuggestRnaQcFiltersResults#free free};
+     * and `shared`, the number of bytes that are shared with other objects (always zero here).
+     */
+    memoryUsage() {
+        return this.#results.memory_usage();
+    }
+
     /**
      * @return Frees the memory allocated on the Wasm heap for this object.
      * This invalidates this object and all references to it.
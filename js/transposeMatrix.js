@@ -10,18 +10,25 @@ import * as wasm from "./wasm.js";
  * This should have length equal to the product of `numberOfRows` and `numberOfColumns`.
  * @param {object} [options={}] - Optional parameters.
  * @param {boolean} [options.columnMajor=true] - Whether `values` contains the matrix in a column-major order.
- * @param {boolean} [options.asTypedArray=true] - Whether to return a Float64Array.
- * If `false`, a Float64WasmArray is returned instead.
- * @param {?Float64WasmArray} [options.buffer=null] - Buffer in which to store the output size factors.
- * Length should be equal to that of `values`.
+ * @param {boolean} [options.singlePrecision=false] - Whether to transpose the matrix in single precision.
+ * If `true`, `values` is converted to a Float32WasmArray (if it is not already one) and the output is a Float32Array or Float32WasmArray.
+ * This is useful for embeddings, e.g., from {@linkcode runUmap}.
+ * @param {boolean} [options.asTypedArray=true] - Whether to return a Float64Array (or Float32Array, if `singlePrecision = true`).
+ * If `false`, a Float64WasmArray (or Float32WasmArray) is returned instead.
+ * @param {?(Float64WasmArray|Float32WasmArray)} [options.buffer=null] - Buffer in which to store the output size factors.
+ * Length should be equal to that of `values`, and it should be a Float32WasmArray if `singlePrecision = true`.
  * If `null`, an array is allocated by the function.
+ * @param {?number} [options.numberOfThreads=null] - Number of threads to use.
+ * If `null`, defaults to {@linkcode maximumThreads}.
  *
- * @return {Float64Array|Float64WasmArray} Array containing the transposed contents of `values`.
+ * @return {Float64Array|Float64WasmArray|Float32Array|Float32WasmArray} Array containing the transposed contents of `values`.
  * If `buffer` is supplied, the function returns `buffer` if `asTypedArray = false`, or a view on `buffer` if `asTypedArray = true`.
  */
 export function transposeMatrix(numberOfRows, numberOfColumns, values, options = {}) {
-    let { columnMajor = true, asTypedArray = true, buffer = null, ...others } = options;
+    let { columnMajor = true, singlePrecision = false, asTypedArray = true, buffer = null, numberOfThreads = null, ...others } = options;
     utils.checkOtherOptions(others);
+    let nthreads = utils.chooseNumberOfThreads(numberOfThreads);
+    let array_type = (singlePrecision ? "Float32WasmArray" : "Float64WasmArray");
 
     let local_buffer = null;
     let input_buffer = null;
@@ -31,14 +38,16 @@ export function transposeMatrix(numberOfRows, numberOfColumns, values, options =
 
     try {
         if (buffer === null) {
-            local_buffer = utils.createFloat64WasmArray(values.length);
+            local_buffer = (singlePrecision ? utils.createFloat32WasmArray(values.length) : utils.createFloat64WasmArray(values.length));
             buffer = local_buffer;
         } else if (buffer.length != values.length) {
             throw new Error("'buffer' should have length equal to the product of 'numberOfRows' and 'numberOfColumns'");
+        } else if (buffer.constructor.className != array_type) {
+            throw new Error("'buffer' should be a " + array_type);
         }
 
-        input_buffer = utils.wasmifyArray(values, "Float64WasmArray");
-        wasm.call(module => module.transpose_matrix(numberOfRows, numberOfColumns, input_buffer.offset, columnMajor, buffer.offset));
+        input_buffer = utils.wasmifyArray(values, array_type);
+        wasm.call(module => module.transpose_matrix(numberOfRows, numberOfColumns, input_buffer.offset, columnMajor, buffer.offset, singlePrecision, nthreads));
 
     } catch(e) {
         utils.free(local_buffer);
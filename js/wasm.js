@@ -4,17 +4,32 @@ import * as afile from "./abstract/file.js";
 
 const cache = {};
 
+// Smallest module using a SIMD128 instruction, see https://github.com/GoogleChromeLabs/wasm-feature-detect.
+const simd_probe = new Uint8Array([0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11]);
+
+function supportsSimd() {
+    try {
+        return WebAssembly.validate(simd_probe);
+    } catch (e) {
+        return false;
+    }
+}
+
 /**
  * @param {object} [options={}] - Optional parameters.
  * @param {number} [options.numberOfThreads=4] - Number of threads to use for calculations.
  * This will spin up the requested number of Web Workers during module initialization.
+ * @param {?boolean} [options.simd=null] - Whether to load the Wasm build that uses SIMD128 instructions.
+ * If `null`, the SIMD build is used if the runtime supports it and the build is available, otherwise the baseline build is used.
+ * If `true`, the SIMD build is always used, which will fail on runtimes without SIMD support or if the package was compiled without the SIMD build.
+ * If `false`, the baseline build is always used.
  * @param {boolean} [options.localFile=false] - Deprecated and ignored.
  *
  * @return {boolean}
  * The Wasm bindings are initialized and `true` is returned.
  * If the bindings were already initialized (e.g., by a previous call), nothing is done and `false` is returned.
  */
-export async function initialize({ numberOfThreads = 4, localFile = false } = {}) {
+export async function initialize({ numberOfThreads = 4, simd = null, localFile = false } = {}) {
     if ("module" in cache) {
         return false;
     }
@@ -23,12 +38,41 @@ export async function initialize({ numberOfThreads = 4, localFile = false } = {}
         scran_custom_nthreads: numberOfThreads
     };
 
-    cache.module = await loadScran(options);
+    const auto_simd = (simd === null);
+    if (auto_simd) {
+        simd = supportsSimd();
+    }
+
+    // The SIMD glue is only imported when needed, so that it is not loaded
+    // on runtimes without SIMD support and it can be omitted from the build.
+    let loader = loadScran;
+    if (simd) {
+        try {
+            loader = (await import("./wasm/scran.simd.js")).default;
+        } catch (e) {
+            if (!auto_simd) {
+                throw e;
+            }
+            simd = false;
+        }
+    }
+
+    cache.module = await loader(options);
+    cache.simd = simd;
     cache.space = register(cache.module);
 
     return true;
 }
 
+/**
+ * Whether the SIMD build of the Wasm module was loaded by {@linkcode initialize}.
+ *
+ * @return {boolean} Whether SIMD128 instructions are used in the current module.
+ */
+export function usesSimd() {
+    return cache.simd;
+}
+
 /**
  * Maximum number of threads available for computation.
  * This depends on the value specified during module initialization in {@linkcode initialize}. 
@@ -80,6 +124,7 @@ export function wasmArraySpace() {
 export function terminate() {
     cache.module.PThread.terminateAllThreads();
     delete cache.module;
+    delete cache.simd;
     return;
 }
 
@@ -89,3 +134,33 @@ export function terminate() {
 export function heapSize() {
     return buffer().byteLength;
 }
+
+/**
+ * @return {object} Object containing allocator statistics for the Wasm heap, typically used for diagnostic reporting:
+ *
+ * - `live`: number of bytes in allocated blocks.
+ * - `fragmented`: number of bytes in free blocks that are held by the allocator.
+ *   As the Wasm heap can never shrink, these bytes are only available for future allocations on the Wasm heap.
+ * - `peak`: maximum number of bytes obtained by the allocator over the lifetime of the module.
+ * - `scratch`: number of bytes in the scratch buffers that are reused across calls, see {@linkcode releaseScratchSpace}.
+ *
+ * Comparing `live` to {@linkcode heapSize} indicates whether a large heap is caused by live objects or by fragmentation.
+ */
+export function heapUsage() {
+    return call(module => module.heap_usage());
+}
+
+/**
+ * Release the scratch buffers on the Wasm heap.
+ * These buffers hold small transient arrays like the subsetting indices in {@linkcode runPca} and {@linkcode scoreGsdecon}, and the group sizes in {@linkcode aggregateAcrossCells}.
+ * Larger temporaries like the centered or residual matrices in {@linkcode runPca} are allocated by the underlying libraries and are not pooled.
+ * The copy of the nearest neighbors in {@linkcode initializeUmap} is also not pooled, as it is owned by the UMAP status until the run is finished;
+ * its size is reported by {@linkcode UmapStatus#memoryUsage memoryUsage} instead.
+ * Each buffer is kept at the largest size required by any call so that it can be reused by later calls without fragmenting the heap.
+ * Releasing the buffers is useful at the end of an analysis, after which they will be re-allocated on demand.
+ *
+ * @return {number} Number of bytes that were released.
+ */
+export function releaseScratchSpace() {
+    return call(module => module.release_scratch());
+}
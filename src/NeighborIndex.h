@@ -6,8 +6,10 @@
 #include <vector>
 
 #include "utils.h"
+#include "memory_usage.h"
 
 #include "knncolle/knncolle.hpp"
+#include "knncolle_annoy/knncolle_annoy.hpp"
 
 class NeighborIndex {
 private:
@@ -29,7 +31,42 @@ public:
     }
 };
 
-std::unique_ptr<knncolle::Builder<std::int32_t, double, double, knncolle::SimpleMatrix<std::int32_t, double> > > create_builder(bool);
+inline std::unique_ptr<knncolle::Builder<std::int32_t, double, double, knncolle::SimpleMatrix<std::int32_t, double> > > create_builder(bool approximate) {
+    if (approximate) {
+        knncolle_annoy::AnnoyOptions opt;
+        return std::make_unique<
+            knncolle_annoy::AnnoyBuilder<
+                std::int32_t,
+                double,
+                double,
+                Annoy::Euclidean,
+                /* AnnoyIndex_ = */ std::int32_t,
+                /* AnnoyData_ = */ float,
+                /* AnnoyRng_ = */ Annoy::Kiss64Random,
+                /* AnnoyThreadPolicy_ = */ Annoy::AnnoyIndexSingleThreadedBuildPolicy,
+                /* Matrix_ = */ knncolle::SimpleMatrix<std::int32_t, double>
+            >
+        >(opt);
+    } else {
+        return std::make_unique<
+            knncolle::VptreeBuilder<
+                std::int32_t,
+                double,
+                double,
+                knncolle::SimpleMatrix<std::int32_t, double>,
+                knncolle::EuclideanDistance<double, double>
+            >
+        >(
+            std::make_shared<knncolle::EuclideanDistance<double, double> >()
+        );
+    }
+}
+
+// 'ptr' contains a column-major matrix where each column is an observation.
+inline NeighborIndex build_neighbor_index(const double* ptr, std::size_t nr, std::int32_t nc, bool approximate) {
+    auto builder = create_builder(approximate);
+    return NeighborIndex(builder->build_unique(knncolle::SimpleMatrix<std::int32_t, double>(nr, nc, ptr)));
+}
 
 class NeighborResults { 
     typedef std::vector<std::vector<std::pair<std::int32_t, double> > > Neighbors;
@@ -77,6 +114,12 @@ public:
         return my_neighbors;
     }
 
+    MemoryUsage memory_usage() const {
+        MemoryUsage output;
+        output.owned = nested_vector_bytes(my_neighbors);
+        return output;
+    }
+
 public:
     JsFakeInt js_size(JsFakeInt truncate_raw) const {
         std::size_t out = 0;
@@ -134,4 +177,24 @@ public:
     }
 };
 
+inline NeighborResults find_nearest_neighbors(const NeighborIndex& index, int k, int nthreads) {
+    return NeighborResults(knncolle::find_nearest_neighbors(*(index.ptr()), k, nthreads));
+}
+
+inline NeighborResults truncate_nearest_neighbors(const NeighborResults& input, int k) {
+    NeighborResults output;
+    const auto nobs = input.neighbors().size();
+    auto& out_neighbors = output.neighbors();
+    sanisizer::resize(out_neighbors, nobs);
+
+    auto& in_neighbors = input.neighbors();
+    for (I<decltype(nobs)> i = 0; i < nobs; ++i) {
+        const auto& current = in_neighbors[i];
+        auto& curout = out_neighbors[i];
+        const auto size = sanisizer::min(current.size(), k);
+        curout.insert(curout.end(), current.begin(), current.begin() + size);
+    }
+    return output;
+}
+
 #endif
@@ -1,6 +1,76 @@
 #include <emscripten/bind.h>
 
+#include <cstdint>
+
 #include "NumericMatrix.h"
+#include "format_memory_usage.h"
+#include "utils.h"
+
+class SparseExtractionResults {
+public:
+    SparseExtractionResults(NumericMatrix::SparseVectors store) : my_store(std::move(store)) {}
+
+private:
+    NumericMatrix::SparseVectors my_store;
+
+public:
+    emscripten::val js_values() const {
+        return emscripten::val(emscripten::typed_memory_view(my_store.values.size(), my_store.values.data()));
+    }
+
+    emscripten::val js_indices() const {
+        return emscripten::val(emscripten::typed_memory_view(my_store.indices.size(), my_store.indices.data()));
+    }
+
+    emscripten::val js_counts() const {
+        return emscripten::val(emscripten::typed_memory_view(my_store.counts.size(), my_store.counts.data()));
+    }
+};
+
+SparseExtractionResults js_sparse_row(NumericMatrix& mat, JsFakeInt r_raw) {
+    return SparseExtractionResults(mat.fetch_sparse<true>(js2int<MatrixIndex>(r_raw)));
+}
+
+SparseExtractionResults js_sparse_column(NumericMatrix& mat, JsFakeInt c_raw) {
+    return SparseExtractionResults(mat.fetch_sparse<false>(js2int<MatrixIndex>(c_raw)));
+}
+
+SparseExtractionResults js_sparse_rows(const NumericMatrix& mat, JsFakeInt indices_raw, JsFakeInt nindices_raw, JsFakeInt nthreads_raw) {
+    const auto indices = reinterpret_cast<const MatrixIndex*>(js2int<std::uintptr_t>(indices_raw));
+    return SparseExtractionResults(mat.fetch_sparse_multiple<true>(indices, js2int<MatrixIndex>(nindices_raw), js2int<int>(nthreads_raw)));
+}
+
+SparseExtractionResults js_sparse_columns(const NumericMatrix& mat, JsFakeInt indices_raw, JsFakeInt nindices_raw, JsFakeInt nthreads_raw) {
+    const auto indices = reinterpret_cast<const MatrixIndex*>(js2int<std::uintptr_t>(indices_raw));
+    return SparseExtractionResults(mat.fetch_sparse_multiple<false>(indices, js2int<MatrixIndex>(nindices_raw), js2int<int>(nthreads_raw)));
+}
+
+emscripten::val js_numeric_matrix_memory_usage(const NumericMatrix& mat) {
+    return format_memory_usage(mat.memory_usage());
+}
+
+emscripten::val js_numeric_matrix_file_access_statistics(const NumericMatrix& mat) {
+    const auto& counters = mat.file_access_counters();
+    if (!counters) {
+        return emscripten::val::null();
+    }
+
+    auto output = emscripten::val::object();
+    output.set("fetches", int2js(counters->fetches.load()));
+    output.set("hits", int2js(counters->hits.load()));
+    output.set("misses", int2js(counters->misses.load()));
+    output.set("chunksRead", int2js(counters->chunks.load()));
+    output.set("bytesCompressed", int2js(counters->compressed_bytes.load()));
+    output.set("bytesDecompressed", int2js(counters->decompressed_bytes.load()));
+    return output;
+}
+
+void js_numeric_matrix_reset_file_access_statistics(const NumericMatrix& mat) {
+    const auto& counters = mat.file_access_counters();
+    if (counters) {
+        counters->reset();
+    }
+}
 
 EMSCRIPTEN_BINDINGS(NumericMatrix) {
     emscripten::class_<NumericMatrix>("NumericMatrix")
@@ -8,7 +78,24 @@ EMSCRIPTEN_BINDINGS(NumericMatrix) {
         .function("ncol", &NumericMatrix::js_ncol, emscripten::return_value_policy::take_ownership())
         .function("row", &NumericMatrix::js_row, emscripten::return_value_policy::take_ownership())
         .function("column", &NumericMatrix::js_column, emscripten::return_value_policy::take_ownership())
+        .function("rows", &NumericMatrix::js_rows, emscripten::return_value_policy::take_ownership())
+        .function("columns", &NumericMatrix::js_columns, emscripten::return_value_policy::take_ownership())
         .function("sparse", &NumericMatrix::js_sparse, emscripten::return_value_policy::take_ownership())
+        .function("storage_savings", &NumericMatrix::js_storage_savings, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &js_numeric_matrix_memory_usage, emscripten::return_value_policy::take_ownership())
+        .function("file_access_statistics", &js_numeric_matrix_file_access_statistics, emscripten::return_value_policy::take_ownership())
+        .function("reset_file_access_statistics", &js_numeric_matrix_reset_file_access_statistics, emscripten::return_value_policy::take_ownership())
         .function("clone", &NumericMatrix::js_clone, emscripten::return_value_policy::take_ownership())
         ;
+
+    emscripten::class_<SparseExtractionResults>("SparseExtractionResults")
+        .function("values", &SparseExtractionResults::js_values, emscripten::return_value_policy::take_ownership())
+        .function("indices", &SparseExtractionResults::js_indices, emscripten::return_value_policy::take_ownership())
+        .function("counts", &SparseExtractionResults::js_counts, emscripten::return_value_policy::take_ownership())
+        ;
+
+    emscripten::function("sparse_row", &js_sparse_row, emscripten::return_value_policy::take_ownership());
+    emscripten::function("sparse_column", &js_sparse_column, emscripten::return_value_policy::take_ownership());
+    emscripten::function("sparse_rows", &js_sparse_rows, emscripten::return_value_policy::take_ownership());
+    emscripten::function("sparse_columns", &js_sparse_columns, emscripten::return_value_policy::take_ownership());
 }
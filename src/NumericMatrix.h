@@ -2,10 +2,16 @@
 #define NUMERIC_MATRIX_H
 
 #include <memory>
+#include <vector>
+#include <algorithm>
+#include <optional>
 #include <cstdint>
+#include <cstddef>
 
 #include "tatami/tatami.hpp"
 #include "utils.h"
+#include "memory_usage.h"
+#include "file_access_counters.h"
 
 typedef double MatrixValue;
 typedef std::int32_t MatrixIndex;
@@ -23,8 +29,14 @@ public:
 
     void reset_ptr(std::shared_ptr<const tatami::NumericMatrix> p) {
         my_ptr = std::move(p);
+        my_storage_savings = 0;
+        my_isometric_seed.reset();
+        my_isometric_operations.clear();
+        my_subset_chain = SubsetChain();
         my_by_row.reset();
         my_by_column.reset();
+        my_sparse_by_row.reset();
+        my_sparse_by_column.reset();
     }
 
 public:
@@ -43,7 +55,8 @@ public:
 public:
     // Not thread-safe! by_row and by_column are initialized
     // on demand when particular rows and columns are requested
-    // in Javascript. Don't use these functions from C++.
+    // in Javascript. Don't use these functions from C++;
+    // see js_rows() and js_columns() for thread-safe versions.
     void js_row(JsFakeInt r_raw, JsFakeInt values_raw) {
         const auto values = js2int<std::uintptr_t>(values_raw);
         MatrixValue* buffer = reinterpret_cast<MatrixValue*>(values);
@@ -66,15 +79,266 @@ public:
         return;
     }
 
+public:
+    // Thread-safe alternatives to js_row() and js_column() for fetching
+    // multiple vectors at once. Each thread creates its own oracle-aware
+    // extractor for its share of the requested indices, so that the
+    // underlying matrix can prefetch as needed. The i-th vector is stored
+    // contiguously at 'values + i * ncol' (for rows) or 'values + i * nrow'
+    // (for columns).
+    void js_rows(JsFakeInt indices_raw, JsFakeInt nindices_raw, JsFakeInt values_raw, JsFakeInt nthreads_raw) const {
+        fetch_multiple<true>(indices_raw, nindices_raw, values_raw, nthreads_raw);
+    }
+
+    void js_columns(JsFakeInt indices_raw, JsFakeInt nindices_raw, JsFakeInt values_raw, JsFakeInt nthreads_raw) const {
+        fetch_multiple<false>(indices_raw, nindices_raw, values_raw, nthreads_raw);
+    }
+
+private:
+    template<bool row_>
+    void fetch_multiple(JsFakeInt indices_raw, JsFakeInt nindices_raw, JsFakeInt values_raw, JsFakeInt nthreads_raw) const {
+        const auto indices = reinterpret_cast<const MatrixIndex*>(js2int<std::uintptr_t>(indices_raw));
+        const auto nindices = js2int<MatrixIndex>(nindices_raw);
+        check_subset_indices<row_>(indices, nindices, row_ ? my_ptr->nrow() : my_ptr->ncol());
+
+        MatrixValue* buffer = reinterpret_cast<MatrixValue*>(js2int<std::uintptr_t>(values_raw));
+        const std::size_t extent = (row_ ? my_ptr->ncol() : my_ptr->nrow());
+
+        tatami::parallelize([&](int, MatrixIndex start, MatrixIndex length) {
+            auto oracle = std::make_shared<tatami::FixedViewOracle<MatrixIndex> >(indices + start, length);
+            auto ext = my_ptr->dense(row_, std::move(oracle), tatami::Options());
+            for (MatrixIndex i = start, end = start + length; i < end; ++i) {
+                auto current = buffer + static_cast<std::size_t>(i) * extent;
+                auto out = ext->fetch(indices[i], current);
+                tatami::copy_n(out, extent, current);
+            }
+        }, nindices, js2int<int>(nthreads_raw));
+    }
+
+public:
+    // Non-zero entries from one or more rows/columns. The entries for the
+    // i-th requested vector occupy the next 'counts[i]' elements of 'values'
+    // and 'indices', after those of all preceding vectors.
+    struct SparseVectors {
+        std::vector<MatrixValue> values;
+        std::vector<MatrixIndex> indices;
+        std::vector<MatrixIndex> counts;
+    };
+
+    // Not thread-safe, for the same reasons as js_row() and js_column().
+    template<bool row_>
+    SparseVectors fetch_sparse(MatrixIndex i) {
+        auto& ext = (row_ ? my_sparse_by_row : my_sparse_by_column);
+        if (!ext) {
+            ext = my_ptr->sparse(row_, tatami::Options());
+        }
+
+        const auto extent = (row_ ? my_ptr->ncol() : my_ptr->nrow());
+        auto vbuffer = sanisizer::create<std::vector<MatrixValue> >(extent);
+        auto ibuffer = sanisizer::create<std::vector<MatrixIndex> >(extent);
+        auto range = ext->fetch(i, vbuffer.data(), ibuffer.data());
+
+        SparseVectors output;
+        output.values.insert(output.values.end(), range.value, range.value + range.number);
+        output.indices.insert(output.indices.end(), range.index, range.index + range.number);
+        output.counts.push_back(range.number);
+        return output;
+    }
+
+    // Thread-safe, see js_rows() and js_columns().
+    template<bool row_>
+    SparseVectors fetch_sparse_multiple(const MatrixIndex* indices, MatrixIndex nindices, int nthreads) const {
+        check_subset_indices<row_>(indices, nindices, row_ ? my_ptr->nrow() : my_ptr->ncol());
+        const auto extent = (row_ ? my_ptr->ncol() : my_ptr->nrow());
+
+        // Each thread processes a contiguous and increasing range of the
+        // requested indices, so we can just concatenate the per-thread
+        // results in order of the thread IDs.
+        SparseVectors output;
+        sanisizer::resize(output.counts, nindices);
+        auto partial = sanisizer::create<std::vector<SparseVectors> >(std::max(nthreads, 1));
+
+        tatami::parallelize([&](int t, MatrixIndex start, MatrixIndex length) {
+            auto vbuffer = sanisizer::create<std::vector<MatrixValue> >(extent);
+            auto ibuffer = sanisizer::create<std::vector<MatrixIndex> >(extent);
+            auto oracle = std::make_shared<tatami::FixedViewOracle<MatrixIndex> >(indices + start, length);
+            auto ext = my_ptr->sparse(row_, std::move(oracle), tatami::Options());
+
+            auto& current = partial[t];
+            for (MatrixIndex i = start, end = start + length; i < end; ++i) {
+                auto range = ext->fetch(indices[i], vbuffer.data(), ibuffer.data());
+                current.values.insert(current.values.end(), range.value, range.value + range.number);
+                current.indices.insert(current.indices.end(), range.index, range.index + range.number);
+                output.counts[i] = range.number;
+            }
+        }, nindices, nthreads);
+
+        std::size_t total = 0;
+        for (const auto& current : partial) {
+            total += current.values.size();
+        }
+        output.values.reserve(total);
+        output.indices.reserve(total);
+        for (auto& current : partial) {
+            output.values.insert(output.values.end(), current.values.begin(), current.values.end());
+            output.indices.insert(output.indices.end(), current.indices.begin(), current.indices.end());
+        }
+
+        return output;
+    }
+
+public:
+    // Records of the storage that is referenced by this matrix, e.g., the
+    // compressed sparse arrays created by the initialization functions.
+    // Each record is shared between all NumericMatrix instances that
+    // reference the same storage, so a record with a use count of 1 is only
+    // owned by this instance. Unlike the other metadata, these records are
+    // not cleared by reset_ptr() as the new pointer usually wraps the old
+    // one; callers that replace the storage should call set_storage().
+    struct StorageRecord {
+        StorageRecord(std::size_t bytes) : bytes(bytes) {}
+        std::size_t bytes;
+    };
+
+    const std::vector<std::shared_ptr<const StorageRecord> >& storage() const {
+        return my_storage;
+    }
+
+    void set_storage(std::vector<std::shared_ptr<const StorageRecord> > storage) {
+        my_storage = std::move(storage);
+    }
+
+    void add_storage(std::size_t bytes) {
+        my_storage.push_back(std::make_shared<const StorageRecord>(bytes));
+    }
+
+    void add_storage(const NumericMatrix& other) {
+        for (const auto& rec : other.my_storage) {
+            if (std::find(my_storage.begin(), my_storage.end(), rec) == my_storage.end()) {
+                my_storage.push_back(rec);
+            }
+        }
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage output;
+        for (const auto& rec : my_storage) {
+            if (rec.use_count() == 1) {
+                output.owned += rec->bytes;
+            } else {
+                output.shared += rec->bytes;
+            }
+        }
+        return output;
+    }
+
+public:
+    // Number of bytes saved by choosing narrower storage types when the
+    // matrix was loaded, see read_utils.h. This is only informative and
+    // is reset whenever the underlying pointer is replaced.
+    void set_storage_savings(std::size_t saved) {
+        my_storage_savings = saved;
+    }
+
+    std::size_t storage_savings() const {
+        return my_storage_savings;
+    }
+
+    JsFakeInt js_storage_savings() const {
+        return int2js(my_storage_savings);
+    }
+
+public:
+    // Chain of delayed isometric operations that were used to create the
+    // current matrix from 'seed', see delayed.cpp. This allows subsequent
+    // operations to be fused into the existing chain instead of adding
+    // another layer of wrappers. Both are cleared by reset_ptr().
+    typedef tatami::DelayedUnaryIsometricOperationHelper<MatrixValue, MatrixValue, MatrixIndex> IsometricOperation;
+
+    const std::shared_ptr<const tatami::NumericMatrix>& isometric_seed() const {
+        return my_isometric_seed;
+    }
+
+    const std::vector<std::shared_ptr<const IsometricOperation> >& isometric_operations() const {
+        return my_isometric_operations;
+    }
+
+    void set_isometric_chain(std::shared_ptr<const tatami::NumericMatrix> seed, std::vector<std::shared_ptr<const IsometricOperation> > operations) {
+        my_isometric_seed = std::move(seed);
+        my_isometric_operations = std::move(operations);
+    }
+
+public:
+    // Row and column subsets that were applied to 'seed' to create the
+    // current matrix, see subset.cpp. This allows subsequent subsets to be
+    // composed with the existing indices rather than adding another layer.
+    // An absent vector means that all rows/columns are used. The storage
+    // savings of the seed are restored if all subsets are removed.
+    struct SubsetChain {
+        std::shared_ptr<const tatami::NumericMatrix> seed;
+        std::size_t seed_storage_savings = 0;
+        std::optional<std::vector<MatrixIndex> > rows, columns;
+    };
+
+    const SubsetChain& subset_chain() const {
+        return my_subset_chain;
+    }
+
+    void set_subset_chain(SubsetChain chain) {
+        my_subset_chain = std::move(chain);
+    }
+
+public:
+    // Counters for accesses to the file that backs this matrix, if any, see
+    // hdf5_instrumentation.h. Like the storage records, these are not
+    // cleared by reset_ptr() as the new pointer usually wraps the old one.
+    const std::shared_ptr<FileAccessCounters>& file_access_counters() const {
+        return my_file_access_counters;
+    }
+
+    void set_file_access_counters(std::shared_ptr<FileAccessCounters> counters) {
+        my_file_access_counters = std::move(counters);
+    }
+
 public:
     NumericMatrix js_clone() const {
-        return NumericMatrix(my_ptr);
+        NumericMatrix output(my_ptr);
+        output.my_storage_savings = my_storage_savings;
+        output.my_storage = my_storage;
+        output.my_file_access_counters = my_file_access_counters;
+        output.my_isometric_seed = my_isometric_seed;
+        output.my_isometric_operations = my_isometric_operations;
+        output.my_subset_chain = my_subset_chain;
+        return output;
     }
 
 private:
     std::shared_ptr<const tatami::Matrix<MatrixValue, MatrixIndex> > my_ptr;
 
+    std::size_t my_storage_savings = 0;
+
+    std::vector<std::shared_ptr<const StorageRecord> > my_storage;
+
+    std::shared_ptr<FileAccessCounters> my_file_access_counters;
+
+    std::shared_ptr<const tatami::NumericMatrix> my_isometric_seed;
+    std::vector<std::shared_ptr<const IsometricOperation> > my_isometric_operations;
+
+    SubsetChain my_subset_chain;
+
     std::unique_ptr<tatami::MyopicDenseExtractor<MatrixValue, MatrixIndex> > my_by_row, my_by_column;
+
+    std::unique_ptr<tatami::MyopicSparseExtractor<MatrixValue, MatrixIndex> > my_sparse_by_row, my_sparse_by_column;
 };
 
+// Runs 'fun' to create a NumericMatrix with new storage, and records the
+// number of bytes that were retained on the heap as its storage.
+template<class Function_>
+NumericMatrix track_storage(Function_ fun) {
+    HeapTracker tracker;
+    NumericMatrix output = fun();
+    output.add_storage(tracker.retained());
+    return output;
+}
+
 #endif
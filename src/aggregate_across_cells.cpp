@@ -1,10 +1,12 @@
 #include <emscripten/bind.h>
 
 #include <cstdint>
+#include <algorithm>
 
 #include "NumericMatrix.h"
+#include "aggregate_across_cells.h"
+#include "format_memory_usage.h"
 
-#include "tatami_stats/tatami_stats.hpp"
 #include "scran_aggregate/scran_aggregate.hpp"
 
 class AggregateAcrossCellsResults {
@@ -25,6 +27,12 @@ public:
         return int2js(my_store.sums.size());
     }
 
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        usage.owned = nested_vector_bytes(my_store.sums) + nested_vector_bytes(my_store.detected);
+        return format_memory_usage(usage);
+    }
+
     emscripten::val js_group_sums(JsFakeInt i_raw) const {
         const auto i = js2int<std::size_t>(i_raw);
         return emscripten::val(emscripten::typed_memory_view(my_ngenes, my_store.sums[i].data()));
@@ -53,25 +61,8 @@ public:
 };
 
 AggregateAcrossCellsResults js_aggregate_across_cells(const NumericMatrix& mat, JsFakeInt factor_raw, bool average, JsFakeInt nthreads_raw) {
-    scran_aggregate::AggregateAcrossCellsOptions aopt;
-    aopt.num_threads = js2int<int>(nthreads_raw);
     auto fptr = reinterpret_cast<const std::int32_t*>(js2int<std::uintptr_t>(factor_raw));
-    auto store = scran_aggregate::aggregate_across_cells<double, double>(*(mat.ptr()), fptr, aopt);
-
-    if (average) {
-        auto sizes = tatami_stats::tabulate_groups(fptr, mat.ptr()->ncol());
-        const auto ngroups = sizes.size();
-        for (I<decltype(ngroups)> i = 0; i < ngroups; ++i) {
-            double denom = 1.0 / sizes[i];
-            for (auto& x : store.sums[i]) {
-                x *= denom;
-            }
-            for (auto& x : store.detected[i]) {
-                x *= denom;
-            }
-        }
-    }
-
+    auto store = aggregate_across_cells(mat, fptr, average, js2int<int>(nthreads_raw));
     return AggregateAcrossCellsResults(mat.ptr()->nrow(), std::move(store));
 }
 
@@ -85,5 +76,6 @@ EMSCRIPTEN_BINDINGS(aggregate_across_cells) {
         .function("all_detected", &AggregateAcrossCellsResults::js_all_detected, emscripten::return_value_policy::take_ownership())
         .function("num_genes", &AggregateAcrossCellsResults::js_num_genes, emscripten::return_value_policy::take_ownership())
         .function("num_groups", &AggregateAcrossCellsResults::js_num_groups, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &AggregateAcrossCellsResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 }
@@ -0,0 +1,41 @@
+#ifndef AGGREGATE_ACROSS_CELLS_H
+#define AGGREGATE_ACROSS_CELLS_H
+
+#include <algorithm>
+#include <cstdint>
+
+#include "NumericMatrix.h"
+#include "scratch.h"
+#include "utils.h"
+
+#include "scran_aggregate/scran_aggregate.hpp"
+
+// If 'average = true', the sums and detected counts are divided by the number of cells in each group.
+inline scran_aggregate::AggregateAcrossCellsResults<double, double> aggregate_across_cells(const NumericMatrix& mat, const std::int32_t* factor, bool average, int nthreads) {
+    scran_aggregate::AggregateAcrossCellsOptions aopt;
+    aopt.num_threads = nthreads;
+    auto store = scran_aggregate::aggregate_across_cells<double, double>(*(mat.ptr()), factor, aopt);
+
+    if (average) {
+        const auto ngroups = store.sums.size();
+        const auto NC = mat.ptr()->ncol();
+        auto sizes = scratch_arena().get<MatrixIndex>(ScratchSlot::GROUP_SIZES, ngroups);
+        std::fill_n(sizes, ngroups, 0);
+        for (I<decltype(NC)> c = 0; c < NC; ++c) {
+            ++(sizes[factor[c]]);
+        }
+        for (I<decltype(ngroups)> i = 0; i < ngroups; ++i) {
+            double denom = 1.0 / sizes[i];
+            for (auto& x : store.sums[i]) {
+                x *= denom;
+            }
+            for (auto& x : store.detected[i]) {
+                x *= denom;
+            }
+        }
+    }
+
+    return store;
+}
+
+#endif
@@ -6,6 +6,11 @@
 #include "scran_graph_cluster/scran_graph_cluster.hpp"
 
 #include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "NeighborIndex.h"
+#include "memory_usage.h"
 
 struct BuildSnnGraphResult {
     BuildSnnGraphResult(scran_graph_cluster::BuildSnnGraphResults<igraph_integer_t, igraph_real_t> g) : 
@@ -15,6 +20,32 @@ struct BuildSnnGraphResult {
 
     raiigraph::Graph graph;
     std::vector<igraph_real_t> weights;
+
+    // igraph stores the 'from' and 'to' vectors and their sorted indices for
+    // each edge, plus two cumulative offset vectors for the vertices.
+    MemoryUsage memory_usage() const {
+        MemoryUsage output;
+        const std::size_t nedges = graph.ecount(), nvertices = graph.vcount();
+        output.owned = vector_bytes(weights) + (nedges * 4 + (nvertices + 1) * 2) * sizeof(igraph_integer_t);
+        return output;
+    }
 };
 
+inline BuildSnnGraphResult build_snn_graph(const NeighborResults& neighbors, const std::string& scheme, int nthreads) {
+    scran_graph_cluster::BuildSnnGraphOptions opt;
+    opt.num_threads = nthreads;
+
+    if (scheme == "rank") {
+        opt.weighting_scheme = scran_graph_cluster::SnnWeightScheme::RANKED;
+    } else if (scheme == "number") {
+        opt.weighting_scheme = scran_graph_cluster::SnnWeightScheme::NUMBER;
+    } else if (scheme == "jaccard") {
+        opt.weighting_scheme = scran_graph_cluster::SnnWeightScheme::JACCARD;
+    } else {
+        throw std::runtime_error("no known weighting scheme '" + scheme + "'");
+    }
+
+    return BuildSnnGraphResult(scran_graph_cluster::build_snn_graph(neighbors.neighbors(), opt));
+}
+
 #endif
@@ -3,13 +3,104 @@
 #include <cstdint>
 #include <vector>
 #include <stdexcept>
+#include <memory>
+#include <type_traits>
 
 #include "NumericMatrix.h"
+#include "read_utils.h"
 #include "utils.h"
 
 #include "tatami/tatami.hpp"
 
-NumericMatrix js_cbind(JsFakeInt n_raw, JsFakeInt mats_raw) {
+// Physically combines sparse matrices into a single compressed sparse matrix,
+// where the combined dimension is the primary dimension (i.e., CSC for cbind,
+// CSR for rbind). This means that each input's contents can be directly
+// copied into a contiguous region of the combined storage.
+template<bool row_>
+NumericMatrix bind_sparse_physically(const std::vector<std::shared_ptr<const tatami::Matrix<double, std::int32_t> > >& collected, int nthreads) {
+    MatrixIndex primary = 0;
+    for (const auto& current : collected) {
+        primary = sanisizer::sum<MatrixIndex>(primary, row_ ? current->nrow() : current->ncol());
+    }
+    const MatrixIndex secondary = (row_ ? collected.front()->ncol() : collected.front()->nrow());
+
+    auto pointers = sanisizer::create<std::vector<std::size_t> >(sanisizer::sum<std::size_t>(primary, 1));
+    {
+        std::size_t offset = 0;
+        for (const auto& current : collected) {
+            tatami::count_compressed_sparse_non_zeros(current.get(), row_, pointers.data() + offset + 1, nthreads);
+            offset += (row_ ? current->nrow() : current->ncol());
+        }
+    }
+    for (MatrixIndex p = 0; p < primary; ++p) {
+        pointers[p + 1] += pointers[p];
+    }
+    const std::size_t nnz = pointers.back();
+
+    auto choice = choose_sparse_storage(NarrowValue::NONE, secondary, nnz);
+    NumericMatrix output = dispatch_sparse_storage<double>(choice, [&](auto value, auto index, auto pointer) -> NumericMatrix {
+        auto values = sanisizer::create<std::vector<I<decltype(value)> > >(nnz);
+        auto indices = sanisizer::create<std::vector<I<decltype(index)> > >(nnz);
+
+        // Each input is filled at the positions specified by its slice of
+        // the combined pointers, so no further adjustment is needed.
+        std::size_t offset = 0;
+        for (const auto& current : collected) {
+            tatami::fill_compressed_sparse_contents(current.get(), row_, pointers.data() + offset, values.data(), indices.data(), nthreads);
+            offset += (row_ ? current->nrow() : current->ncol());
+        }
+
+        typedef std::conditional_t<
+            row_,
+            tatami::CompressedSparseRowMatrix<MatrixValue, MatrixIndex, I<decltype(values)>, I<decltype(indices)>, std::vector<I<decltype(pointer)> > >,
+            tatami::CompressedSparseColumnMatrix<MatrixValue, MatrixIndex, I<decltype(values)>, I<decltype(indices)>, std::vector<I<decltype(pointer)> > >
+        > Combined;
+
+        return NumericMatrix(
+            std::make_shared<Combined>(
+                (row_ ? primary : secondary),
+                (row_ ? secondary : primary),
+                std::move(values),
+                std::move(indices),
+                std::vector<I<decltype(pointer)> >(pointers.begin(), pointers.end())
+            )
+        );
+    });
+
+    output.set_storage_savings(sparse_storage_savings<double>(choice, primary, nnz));
+    return output;
+}
+
+template<bool row_>
+NumericMatrix bind_matrices(const std::vector<const NumericMatrix*>& inputs, std::vector<std::shared_ptr<const tatami::Matrix<double, std::int32_t> > > collected, bool physical, int nthreads) {
+    if (physical) {
+        bool all_sparse = true;
+        for (const auto& current : collected) {
+            if (!current->sparse()) {
+                all_sparse = false;
+                break;
+            }
+        }
+
+        // Dense inputs are still combined with a delayed bind, as a physical
+        // copy would not reduce the cost of extraction by much.
+        if (all_sparse) {
+            return track_storage([&]() -> NumericMatrix {
+                return bind_sparse_physically<row_>(collected, nthreads);
+            });
+        }
+    }
+
+    NumericMatrix output(
+        std::make_shared<tatami::DelayedBind<double, std::int32_t> >(std::move(collected), row_)
+    );
+    for (auto mptr : inputs) {
+        output.add_storage(*mptr);
+    }
+    return output;
+}
+
+NumericMatrix js_cbind(JsFakeInt n_raw, JsFakeInt mats_raw, bool physical, JsFakeInt nthreads_raw) {
     const auto mat_ptrs = convert_array_of_offsets<const NumericMatrix*>(n_raw, mats_raw);
     const auto n = mat_ptrs.size();
     if (n == 0) {
@@ -31,12 +122,10 @@ NumericMatrix js_cbind(JsFakeInt n_raw, JsFakeInt mats_raw) {
         collected.push_back(current);
     }
 
-    return NumericMatrix(
-        std::make_shared<tatami::DelayedBind<double, std::int32_t> >(std::move(collected), false)
-    );
+    return bind_matrices<false>(mat_ptrs, std::move(collected), physical, js2int<int>(nthreads_raw));
 }
 
-NumericMatrix js_rbind(JsFakeInt n_raw, JsFakeInt mats_raw) {
+NumericMatrix js_rbind(JsFakeInt n_raw, JsFakeInt mats_raw, bool physical, JsFakeInt nthreads_raw) {
     const auto mat_ptrs = convert_array_of_offsets<const NumericMatrix*>(n_raw, mats_raw);
     const auto n = mat_ptrs.size();
     if (n == 0) {
@@ -58,9 +147,7 @@ NumericMatrix js_rbind(JsFakeInt n_raw, JsFakeInt mats_raw) {
         collected.push_back(current);
     }
 
-    return NumericMatrix(
-        std::make_shared<tatami::DelayedBind<double, std::int32_t> >(std::move(collected), true)
-    );
+    return bind_matrices<true>(mat_ptrs, std::move(collected), physical, js2int<int>(nthreads_raw));
 }
 
 EMSCRIPTEN_BINDINGS(cbind) {
@@ -5,6 +5,7 @@
 #include <cstdint>
 
 #include "build_snn_graph.h"
+#include "cluster_graph.h"
 #include "utils.h"
 
 #include "scran_graph_cluster/scran_graph_cluster.hpp"
@@ -55,9 +56,7 @@ public:
 };
 
 ClusterMultilevelResult js_cluster_multilevel(const BuildSnnGraphResult& graph, double resolution) {
-    scran_graph_cluster::ClusterMultilevelOptions opt;
-    opt.resolution = resolution;
-    auto output = scran_graph_cluster::cluster_multilevel(graph.graph, graph.weights, opt);
+    auto output = cluster_multilevel(graph, resolution);
     return ClusterMultilevelResult(std::move(output));
 }
 
@@ -96,9 +95,7 @@ public:
 };
 
 ClusterWalktrapResult js_cluster_walktrap(const BuildSnnGraphResult& graph, JsFakeInt steps_raw) {
-    scran_graph_cluster::ClusterWalktrapOptions opt;
-    opt.steps = js2int<igraph_int_t>(steps_raw);
-    auto output = scran_graph_cluster::cluster_walktrap(graph.graph, graph.weights, opt);
+    auto output = cluster_walktrap(graph, js2int<igraph_int_t>(steps_raw));
     return ClusterWalktrapResult(std::move(output));
 }
 
@@ -123,20 +120,7 @@ public:
 };
 
 ClusterLeidenResult js_cluster_leiden(const BuildSnnGraphResult& graph, double resolution, std::string objective) {
-    scran_graph_cluster::ClusterLeidenOptions opt;
-    opt.resolution = resolution;
-
-    if (objective == "modularity") {
-        opt.objective = IGRAPH_LEIDEN_OBJECTIVE_MODULARITY;
-    } else if (objective == "cpm") {
-        opt.objective = IGRAPH_LEIDEN_OBJECTIVE_CPM;
-    } else if (objective == "er") {
-        opt.objective = IGRAPH_LEIDEN_OBJECTIVE_ER;
-    } else {
-        throw std::runtime_error("unknown objective '" + objective + "'");
-    }
-
-    auto output = scran_graph_cluster::cluster_leiden(graph.graph, graph.weights, opt);
+    auto output = cluster_leiden(graph, resolution, objective);
     return ClusterLeidenResult(std::move(output));
 }
 
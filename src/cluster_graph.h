@@ -0,0 +1,40 @@
+#ifndef CLUSTER_GRAPH_H
+#define CLUSTER_GRAPH_H
+
+#include <string>
+#include <stdexcept>
+
+#include "build_snn_graph.h"
+
+#include "scran_graph_cluster/scran_graph_cluster.hpp"
+
+inline scran_graph_cluster::ClusterMultilevelResults cluster_multilevel(const BuildSnnGraphResult& graph, double resolution) {
+    scran_graph_cluster::ClusterMultilevelOptions opt;
+    opt.resolution = resolution;
+    return scran_graph_cluster::cluster_multilevel(graph.graph, graph.weights, opt);
+}
+
+inline scran_graph_cluster::ClusterWalktrapResults cluster_walktrap(const BuildSnnGraphResult& graph, igraph_int_t steps) {
+    scran_graph_cluster::ClusterWalktrapOptions opt;
+    opt.steps = steps;
+    return scran_graph_cluster::cluster_walktrap(graph.graph, graph.weights, opt);
+}
+
+inline scran_graph_cluster::ClusterLeidenResults cluster_leiden(const BuildSnnGraphResult& graph, double resolution, const std::string& objective) {
+    scran_graph_cluster::ClusterLeidenOptions opt;
+    opt.resolution = resolution;
+
+    if (objective == "modularity") {
+        opt.objective = IGRAPH_LEIDEN_OBJECTIVE_MODULARITY;
+    } else if (objective == "cpm") {
+        opt.objective = IGRAPH_LEIDEN_OBJECTIVE_CPM;
+    } else if (objective == "er") {
+        opt.objective = IGRAPH_LEIDEN_OBJECTIVE_ER;
+    } else {
+        throw std::runtime_error("unknown objective '" + objective + "'");
+    }
+
+    return scran_graph_cluster::cluster_leiden(graph.graph, graph.weights, opt);
+}
+
+#endif
@@ -1,11 +1,12 @@
 #include <emscripten/bind.h>
 
-#include <algorithm>
-#include <memory>
+#include <string>
 #include <cstdint>
 #include <cstddef>
 
 #include "utils.h"
+#include "cluster_kmeans.h"
+#include "format_memory_usage.h"
 
 #include "kmeans/kmeans.hpp"
 
@@ -47,6 +48,12 @@ public:
         return int2js(my_store.details.status);
     }
 
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        usage.owned = vector_bytes(my_store.clusters) + vector_bytes(my_store.centers) + vector_bytes(my_store.details.sizes);
+        return format_memory_usage(usage);
+    }
+
     emscripten::val js_centers() const {
         const auto& s = my_store.centers;
         return emscripten::val(emscripten::typed_memory_view(s.size(), s.data()));
@@ -67,51 +74,23 @@ ClusterKmeansResult js_cluster_kmeans(
     JsFakeInt refine_hw_iterations_raw,
     JsFakeInt nthreads_raw
 ) {
-    kmeans::SimpleMatrix<std::int32_t, double> smat(
+    ClusterKmeansOptions opt;
+    opt.init_method = std::move(init_method);
+    opt.init_seed = js2int<std::uint64_t>(init_seed_raw);
+    opt.init_varpart_size_adjust = init_varpart_size_adjust;
+    opt.init_varpart_optimized = init_varpart_optimized;
+    opt.refine_method = std::move(refine_method);
+    opt.refine_lloyd_iterations = js2int<int>(refine_lloyd_iterations_raw);
+    opt.refine_hw_iterations = js2int<int>(refine_hw_iterations_raw);
+    opt.num_threads = js2int<int>(nthreads_raw);
+
+    auto output = cluster_kmeans(
+        reinterpret_cast<const double*>(js2int<std::uintptr_t>(mat_raw)),
         js2int<std::size_t>(nr_raw),
         js2int<std::int32_t>(nc_raw),
-        reinterpret_cast<const double*>(js2int<std::uintptr_t>(mat_raw))
+        js2int<std::int32_t>(k_raw),
+        opt
     );
-
-    std::unique_ptr<kmeans::Initialize<std::int32_t, double, std::int32_t, double, I<decltype(smat)> > > iptr;
-    if (init_method == "random") {
-        auto iptr2 = new kmeans::InitializeRandom<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
-        iptr.reset(iptr2);
-        iptr2->get_options().seed = js2int<std::uint64_t>(init_seed_raw);
-
-    } else if (init_method == "kmeans++") {
-        auto iptr2 = new kmeans::InitializeKmeanspp<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
-        iptr.reset(iptr2);
-        iptr2->get_options().seed = js2int<std::uint64_t>(init_seed_raw);
-        iptr2->get_options().num_threads = js2int<int>(nthreads_raw);
-
-    } else if (init_method == "var-part") {
-        auto iptr2 = new kmeans::InitializeVariancePartition<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
-        iptr.reset(iptr2);
-        iptr2->get_options().size_adjustment = init_varpart_size_adjust;
-        iptr2->get_options().optimize_partition = init_varpart_optimized;
-
-    } else {
-        throw std::runtime_error("unknown initialization method '" + init_method + "'");
-    }
-
-    std::unique_ptr<kmeans::Refine<std::int32_t, double, std::int32_t, double, I<decltype(smat)> > > rptr;
-    if (refine_method == "lloyd") {
-        auto rptr2 = new kmeans::RefineLloyd<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
-        rptr.reset(rptr2);
-        rptr2->get_options().max_iterations = js2int<int>(refine_lloyd_iterations_raw);
-        rptr2->get_options().num_threads = js2int<int>(nthreads_raw);
-
-    } else if (refine_method == "hartigan-wong") {
-        auto rptr2 = new kmeans::RefineHartiganWong<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
-        rptr.reset(rptr2);
-        rptr2->get_options().max_iterations = js2int<int>(refine_hw_iterations_raw);
-
-    } else {
-        throw std::runtime_error("unknown refinement method '" + refine_method + "'");
-    }
-
-    auto output = kmeans::compute(smat, *iptr, *rptr, js2int<std::int32_t>(k_raw));
     return ClusterKmeansResult(std::move(output));
 }
 
@@ -126,5 +105,6 @@ EMSCRIPTEN_BINDINGS(cluster_kmeans) {
         .function("centers", &ClusterKmeansResult::js_centers, emscripten::return_value_policy::take_ownership())
         .function("iterations", &ClusterKmeansResult::js_iterations, emscripten::return_value_policy::take_ownership())
         .function("status", &ClusterKmeansResult::js_status, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &ClusterKmeansResult::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 }
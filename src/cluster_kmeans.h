@@ -0,0 +1,70 @@
+#ifndef CLUSTER_KMEANS_H
+#define CLUSTER_KMEANS_H
+
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+#include "utils.h"
+
+#include "kmeans/kmeans.hpp"
+
+struct ClusterKmeansOptions {
+    std::string init_method = "var-part";
+    std::uint64_t init_seed = 5768;
+    double init_varpart_size_adjust = 1;
+    bool init_varpart_optimized = true;
+    std::string refine_method = "hartigan-wong";
+    int refine_lloyd_iterations = 100;
+    int refine_hw_iterations = 10;
+    int num_threads = 1;
+};
+
+// 'ptr' contains a column-major matrix where each column is an observation.
+inline kmeans::Results<std::int32_t, std::int32_t, double> cluster_kmeans(const double* ptr, std::size_t nr, std::int32_t nc, std::int32_t k, const ClusterKmeansOptions& options) {
+    kmeans::SimpleMatrix<std::int32_t, double> smat(nr, nc, ptr);
+
+    std::unique_ptr<kmeans::Initialize<std::int32_t, double, std::int32_t, double, I<decltype(smat)> > > iptr;
+    if (options.init_method == "random") {
+        auto iptr2 = new kmeans::InitializeRandom<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
+        iptr.reset(iptr2);
+        iptr2->get_options().seed = options.init_seed;
+
+    } else if (options.init_method == "kmeans++") {
+        auto iptr2 = new kmeans::InitializeKmeanspp<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
+        iptr.reset(iptr2);
+        iptr2->get_options().seed = options.init_seed;
+        iptr2->get_options().num_threads = options.num_threads;
+
+    } else if (options.init_method == "var-part") {
+        auto iptr2 = new kmeans::InitializeVariancePartition<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
+        iptr.reset(iptr2);
+        iptr2->get_options().size_adjustment = options.init_varpart_size_adjust;
+        iptr2->get_options().optimize_partition = options.init_varpart_optimized;
+
+    } else {
+        throw std::runtime_error("unknown initialization method '" + options.init_method + "'");
+    }
+
+    std::unique_ptr<kmeans::Refine<std::int32_t, double, std::int32_t, double, I<decltype(smat)> > > rptr;
+    if (options.refine_method == "lloyd") {
+        auto rptr2 = new kmeans::RefineLloyd<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
+        rptr.reset(rptr2);
+        rptr2->get_options().max_iterations = options.refine_lloyd_iterations;
+        rptr2->get_options().num_threads = options.num_threads;
+
+    } else if (options.refine_method == "hartigan-wong") {
+        auto rptr2 = new kmeans::RefineHartiganWong<std::int32_t, double, std::int32_t, double, I<decltype(smat)> >;
+        rptr.reset(rptr2);
+        rptr2->get_options().max_iterations = options.refine_hw_iterations;
+
+    } else {
+        throw std::runtime_error("unknown refinement method '" + options.refine_method + "'");
+    }
+
+    return kmeans::compute(smat, *iptr, *rptr, k);
+}
+
+#endif
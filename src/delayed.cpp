@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <cstddef>
 #include <stdexcept>
+#include <memory>
+#include <optional>
 
 #include "NumericMatrix.h"
 #include "utils.h"
@@ -12,6 +14,133 @@
 #include "tatami/tatami.hpp"
 #include "sanisizer/sanisizer.hpp"
 
+// Applies a chain of isometric operations in a single pass, so that each
+// extracted vector only goes through one layer of virtual calls and buffer
+// copies. Each operation is applied in place on the output of the previous.
+class FusedIsometricOperation final : public NumericMatrix::IsometricOperation {
+public:
+    FusedIsometricOperation(std::vector<std::shared_ptr<const NumericMatrix::IsometricOperation> > operations) : my_operations(std::move(operations)) {
+        bool still_zero = true;
+        for (const auto& op : my_operations) {
+            // Once a non-sparse operation has been applied, structural zeros
+            // are no longer zero and are subject to all of the dependencies
+            // of the subsequent operations.
+            if (still_zero) {
+                my_zero_depends_on_row = my_zero_depends_on_row || op->zero_depends_on_row();
+                my_zero_depends_on_column = my_zero_depends_on_column || op->zero_depends_on_column();
+            } else {
+                my_zero_depends_on_row = my_zero_depends_on_row || op->zero_depends_on_row() || op->non_zero_depends_on_row();
+                my_zero_depends_on_column = my_zero_depends_on_column || op->zero_depends_on_column() || op->non_zero_depends_on_column();
+            }
+
+            // Conservatively, a non-zero might become zero at any step, so
+            // it is affected by all dependencies.
+            my_non_zero_depends_on_row = my_non_zero_depends_on_row || op->zero_depends_on_row() || op->non_zero_depends_on_row();
+            my_non_zero_depends_on_column = my_non_zero_depends_on_column || op->zero_depends_on_column() || op->non_zero_depends_on_column();
+
+            my_sparse = my_sparse && op->is_sparse();
+            still_zero = still_zero && op->is_sparse();
+
+            if (!my_nrow.has_value()) {
+                my_nrow = op->nrow();
+            }
+            if (!my_ncol.has_value()) {
+                my_ncol = op->ncol();
+            }
+        }
+    }
+
+private:
+    std::vector<std::shared_ptr<const NumericMatrix::IsometricOperation> > my_operations;
+    bool my_zero_depends_on_row = false, my_zero_depends_on_column = false;
+    bool my_non_zero_depends_on_row = false, my_non_zero_depends_on_column = false;
+    bool my_sparse = true;
+    std::optional<std::int32_t> my_nrow, my_ncol;
+
+public:
+    std::optional<std::int32_t> nrow() const override {
+        return my_nrow;
+    }
+
+    std::optional<std::int32_t> ncol() const override {
+        return my_ncol;
+    }
+
+    bool zero_depends_on_row() const override {
+        return my_zero_depends_on_row;
+    }
+
+    bool zero_depends_on_column() const override {
+        return my_zero_depends_on_column;
+    }
+
+    bool non_zero_depends_on_row() const override {
+        return my_non_zero_depends_on_row;
+    }
+
+    bool non_zero_depends_on_column() const override {
+        return my_non_zero_depends_on_column;
+    }
+
+    bool is_sparse() const override {
+        return my_sparse;
+    }
+
+public:
+    void dense(bool row, std::int32_t i, std::int32_t start, std::int32_t length, const double* input, double* output) const override {
+        my_operations.front()->dense(row, i, start, length, input, output);
+        for (std::size_t o = 1, end = my_operations.size(); o < end; ++o) {
+            my_operations[o]->dense(row, i, start, length, output, output);
+        }
+    }
+
+    void dense(bool row, std::int32_t i, const std::vector<std::int32_t>& indices, const double* input, double* output) const override {
+        my_operations.front()->dense(row, i, indices, input, output);
+        for (std::size_t o = 1, end = my_operations.size(); o < end; ++o) {
+            my_operations[o]->dense(row, i, indices, output, output);
+        }
+    }
+
+    void sparse(bool row, std::int32_t i, std::int32_t number, const double* input_value, const std::int32_t* index, double* output_value) const override {
+        my_operations.front()->sparse(row, i, number, input_value, index, output_value);
+        for (std::size_t o = 1, end = my_operations.size(); o < end; ++o) {
+            my_operations[o]->sparse(row, i, number, output_value, index, output_value);
+        }
+    }
+
+    double fill(bool row, std::int32_t i) const override {
+        // This is only called if the transformed zero does not depend on
+        // the other dimension, so any position can be used for the later
+        // operations; we just use the first.
+        double output = my_operations.front()->fill(row, i);
+        for (std::size_t o = 1, end = my_operations.size(); o < end; ++o) {
+            my_operations[o]->dense(row, i, 0, 1, &output, &output);
+        }
+        return output;
+    }
+};
+
+// If 'x' was itself created by this function, the new operation is fused with
+// the existing chain and applied to the original seed matrix.
+void add_isometric_operation(NumericMatrix& x, std::shared_ptr<const NumericMatrix::IsometricOperation> operation) {
+    auto seed = x.isometric_seed();
+    auto operations = x.isometric_operations();
+    if (!seed) {
+        seed = x.ptr();
+    }
+    operations.push_back(std::move(operation));
+
+    std::shared_ptr<const NumericMatrix::IsometricOperation> combined;
+    if (operations.size() == 1) {
+        combined = operations.front();
+    } else {
+        combined = std::make_shared<FusedIsometricOperation>(operations);
+    }
+
+    x.reset_ptr(std::make_shared<tatami::DelayedUnaryIsometricOperation<double, double, std::int32_t> >(seed, std::move(combined)));
+    x.set_isometric_chain(std::move(seed), std::move(operations));
+}
+
 void js_delayed_arithmetic_scalar(NumericMatrix& x, std::string op, bool right, double val) {
     std::shared_ptr<tatami::DelayedUnaryIsometricOperationHelper<double, double, std::int32_t> > operation;
 
@@ -35,7 +164,7 @@ void js_delayed_arithmetic_scalar(NumericMatrix& x, std::string op, bool right,
         throw std::runtime_error("unknown arithmetic operation '" + op + "'");
     }
 
-    x.reset_ptr(std::make_shared<tatami::DelayedUnaryIsometricOperation<double, double, std::int32_t> >(std::move(x.ptr()), std::move(operation)));
+    add_isometric_operation(x, std::move(operation));
 }
 
 void js_delayed_arithmetic_vector(NumericMatrix& x, std::string op, bool right, JsFakeInt margin_raw, JsFakeInt ptr_raw, JsFakeInt n_raw) {
@@ -71,7 +200,7 @@ void js_delayed_arithmetic_vector(NumericMatrix& x, std::string op, bool right,
         throw std::runtime_error("unknown arithmetic operation '" + op + "'");
     }
 
-    x.reset_ptr(std::make_shared<tatami::DelayedUnaryIsometricOperation<double, double, std::int32_t> >(std::move(x.ptr()), std::move(operation)));
+    add_isometric_operation(x, std::move(operation));
 }
 
 void js_delayed_math(NumericMatrix& x, std::string op, double base) {
@@ -97,7 +226,7 @@ void js_delayed_math(NumericMatrix& x, std::string op, double base) {
         throw std::runtime_error("unknown math operation '" + op + "'");
     }
 
-    x.reset_ptr(std::make_shared<tatami::DelayedUnaryIsometricOperation<double, double, std::int32_t> >(std::move(x.ptr()), std::move(operation)));
+    add_isometric_operation(x, std::move(operation));
 }
 
 void js_transpose(NumericMatrix& x) {
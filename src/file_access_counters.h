@@ -0,0 +1,30 @@
+#ifndef FILE_ACCESS_COUNTERS_H
+#define FILE_ACCESS_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Counters for accesses to a file-backed matrix. 'fetches' is the number of
+// rows/columns that were requested, of which 'hits' were served from the
+// cache and 'misses' required reading chunks from the file. 'chunks' is the
+// (estimated) number of chunks that were inflated to serve the misses,
+// containing 'compressed_bytes' that were inflated into 'decompressed_bytes'.
+struct FileAccessCounters {
+    std::atomic<std::uint64_t> fetches{0};
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> chunks{0};
+    std::atomic<std::uint64_t> compressed_bytes{0};
+    std::atomic<std::uint64_t> decompressed_bytes{0};
+
+    void reset() {
+        fetches = 0;
+        hits = 0;
+        misses = 0;
+        chunks = 0;
+        compressed_bytes = 0;
+        decompressed_bytes = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef FORMAT_MEMORY_USAGE_H
+#define FORMAT_MEMORY_USAGE_H
+
+#include <emscripten/val.h>
+
+#include "memory_usage.h"
+#include "utils.h"
+
+inline emscripten::val format_memory_usage(const MemoryUsage& usage) {
+    auto output = emscripten::val::object();
+    output.set("owned", int2js(usage.owned));
+    output.set("shared", int2js(usage.shared));
+    return output;
+}
+
+#endif
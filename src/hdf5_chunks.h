@@ -0,0 +1,309 @@
+#ifndef HDF5_CHUNKS_H
+#define HDF5_CHUNKS_H
+
+#include <vector>
+#include <memory>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include "zlib.h"
+#include "H5Cpp.h"
+#include "subpar/subpar.hpp"
+
+// Parallel reader for 1-dimensional chunked datasets, e.g., the 'data' and
+// 'indices' of a compressed sparse matrix. HDF5 inflates each chunk in the
+// calling thread, so instead we locate the chunks with the HDF5 library,
+// read the raw (compressed) bytes of each chunk from the file in a separate
+// thread, and inflate them in parallel. Only datasets with the deflate and
+// shuffle filters and little-endian integer or float types are supported;
+// callers should fall back to the HDF5 library for anything else.
+
+struct RawChunkLocation {
+    hsize_t offset;
+    haddr_t address;
+    hsize_t size;
+    unsigned filter_mask;
+};
+
+struct ChunkedDatasetLayout {
+    hsize_t extent = 0;
+    hsize_t chunk_length = 0;
+    std::size_t type_size = 0;
+    H5T_class_t type_class = H5T_NO_CLASS;
+    bool is_signed = false;
+    std::vector<H5Z_filter_t> filters;
+    std::vector<RawChunkLocation> chunks;
+    hsize_t base_address = 0;
+};
+
+// Must be called from the main thread as it uses the HDF5 library.
+inline bool inspect_chunked_dataset(const H5::H5File& file, const H5::DataSet& dataset, ChunkedDatasetLayout& layout) {
+    auto space = dataset.getSpace();
+    if (space.getSimpleExtentNdims() != 1) {
+        return false;
+    }
+    space.getSimpleExtentDims(&(layout.extent));
+
+    auto plist = dataset.getCreatePlist();
+    if (plist.getLayout() != H5D_CHUNKED) {
+        return false;
+    }
+    plist.getChunk(1, &(layout.chunk_length));
+
+    const int nfilters = plist.getNfilters();
+    for (int f = 0; f < nfilters; ++f) {
+        unsigned flags;
+        std::size_t nelmts = 0;
+        unsigned filter_config;
+        char name[64];
+        auto id = plist.getFilter(f, flags, nelmts, NULL, sizeof(name), name, filter_config);
+        if (id != H5Z_FILTER_DEFLATE && id != H5Z_FILTER_SHUFFLE) {
+            return false;
+        }
+        layout.filters.push_back(id);
+    }
+
+    auto dtype = dataset.getDataType();
+    layout.type_class = dtype.getClass();
+    layout.type_size = dtype.getSize();
+    if (layout.type_class == H5T_INTEGER) {
+        auto itype = dataset.getIntType();
+        if (itype.getOrder() != H5T_ORDER_LE) {
+            return false;
+        }
+        layout.is_signed = (itype.getSign() != H5T_SGN_NONE);
+        if (layout.type_size != 1 && layout.type_size != 2 && layout.type_size != 4 && layout.type_size != 8) {
+            return false;
+        }
+    } else if (layout.type_class == H5T_FLOAT) {
+        auto ftype = dataset.getFloatType();
+        if (ftype.getOrder() != H5T_ORDER_LE || (layout.type_size != 4 && layout.type_size != 8)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    layout.base_address = file.getCreatePlist().getUserblock();
+
+#if H5_VERSION_GE(1, 14, 1)
+    // Iterating once over the chunk index, as H5Dget_chunk_info() is linear in the chunk index.
+    auto add_chunk = [](const hsize_t* offset, unsigned filter_mask, haddr_t addr, hsize_t size, void* data) -> int {
+        static_cast<std::vector<RawChunkLocation>*>(data)->push_back(RawChunkLocation{ offset[0], addr, size, filter_mask });
+        return H5_ITER_CONT;
+    };
+    if (H5Dchunk_iter(dataset.getId(), H5P_DEFAULT, add_chunk, &(layout.chunks)) < 0) {
+        return false;
+    }
+#else
+    hsize_t nchunks = 0;
+    if (H5Dget_num_chunks(dataset.getId(), space.getId(), &nchunks) < 0) {
+        return false;
+    }
+    layout.chunks.reserve(nchunks);
+    for (hsize_t c = 0; c < nchunks; ++c) {
+        RawChunkLocation loc;
+        if (H5Dget_chunk_info(dataset.getId(), space.getId(), c, &(loc.offset), &(loc.filter_mask), &(loc.address), &(loc.size)) < 0) {
+            return false;
+        }
+        layout.chunks.push_back(loc);
+    }
+#endif
+
+    // Reading the chunks in file order to avoid seeking back and forth.
+    std::sort(layout.chunks.begin(), layout.chunks.end(), [](const RawChunkLocation& l, const RawChunkLocation& r) -> bool { return l.address < r.address; });
+    return true;
+}
+
+template<typename Output_, typename Stored_>
+void convert_chunk_elements(const unsigned char* raw, std::size_t n, Output_* output) {
+    for (std::size_t i = 0; i < n; ++i) {
+        Stored_ val;
+        std::memcpy(&val, raw + i * sizeof(Stored_), sizeof(Stored_)); // assuming a little-endian host, as is the case for Wasm.
+        output[i] = val;
+    }
+}
+
+template<typename Output_>
+void convert_chunk_elements(const unsigned char* raw, std::size_t n, const ChunkedDatasetLayout& layout, Output_* output) {
+    if (layout.type_class == H5T_FLOAT) {
+        if (layout.type_size == 4) {
+            convert_chunk_elements<Output_, float>(raw, n, output);
+        } else {
+            convert_chunk_elements<Output_, double>(raw, n, output);
+        }
+    } else if (layout.is_signed) {
+        switch (layout.type_size) {
+            case 1: convert_chunk_elements<Output_, std::int8_t>(raw, n, output); break;
+            case 2: convert_chunk_elements<Output_, std::int16_t>(raw, n, output); break;
+            case 4: convert_chunk_elements<Output_, std::int32_t>(raw, n, output); break;
+            default: convert_chunk_elements<Output_, std::int64_t>(raw, n, output); break;
+        }
+    } else {
+        switch (layout.type_size) {
+            case 1: convert_chunk_elements<Output_, std::uint8_t>(raw, n, output); break;
+            case 2: convert_chunk_elements<Output_, std::uint16_t>(raw, n, output); break;
+            case 4: convert_chunk_elements<Output_, std::uint32_t>(raw, n, output); break;
+            default: convert_chunk_elements<Output_, std::uint64_t>(raw, n, output); break;
+        }
+    }
+}
+
+// Reverses the filters for a single chunk, using 'work' as scratch space.
+// Filters are applied in order when writing, so we undo them in reverse.
+inline void decode_raw_chunk(std::vector<unsigned char>& raw, unsigned filter_mask, const ChunkedDatasetLayout& layout, std::vector<unsigned char>& work) {
+    const std::size_t full_bytes = layout.chunk_length * layout.type_size;
+    for (std::size_t f = layout.filters.size(); f > 0; --f) {
+        if (filter_mask & (1u << (f - 1))) {
+            continue; // filter was skipped for this chunk.
+        }
+
+        work.resize(full_bytes);
+        if (layout.filters[f - 1] == H5Z_FILTER_DEFLATE) {
+            uLongf outsize = full_bytes;
+            if (uncompress(work.data(), &outsize, raw.data(), raw.size()) != Z_OK) {
+                throw std::runtime_error("failed to inflate a chunk of the HDF5 dataset");
+            }
+            work.resize(outsize);
+        } else {
+            // Unshuffling the bytes, see H5Zshuffle.c. Any leftover bytes that
+            // don't form a complete element are left as-is.
+            const std::size_t size = layout.type_size;
+            const std::size_t nelements = raw.size() / size;
+            for (std::size_t b = 0; b < size; ++b) {
+                auto src = raw.data() + b * nelements;
+                for (std::size_t i = 0; i < nelements; ++i) {
+                    work[i * size + b] = src[i];
+                }
+            }
+            std::copy(raw.begin() + nelements * size, raw.end(), work.begin() + nelements * size);
+            work.resize(raw.size());
+        }
+        raw.swap(work);
+    }
+}
+
+// Reads the raw chunks in a separate thread while the current thread
+// inflates batches of chunks in parallel. Each chunk is written directly to
+// its position in 'output', so the order of completion does not matter.
+template<typename Output_>
+void read_chunked_dataset_parallel(const std::string& path, const ChunkedDatasetLayout& layout, Output_* output, int nthreads) {
+    std::fill_n(output, layout.extent, 0); // unallocated chunks contain the (zero) fill value.
+    if (layout.chunks.empty()) {
+        return;
+    }
+
+    struct Batch {
+        std::size_t first, last;
+        std::vector<std::vector<unsigned char> > raw;
+    };
+
+    std::mutex mut;
+    std::condition_variable cv;
+    std::deque<Batch> filled;
+    bool finished = false, cancelled = false;
+    std::exception_ptr error;
+    constexpr std::size_t max_batches = 2;
+    const std::size_t batch_size = static_cast<std::size_t>(nthreads) * 4;
+
+    std::thread reader([&]() -> void {
+        try {
+            auto handle = std::fopen(path.c_str(), "rb");
+            if (!handle) {
+                throw std::runtime_error("failed to open file at '" + path + "'");
+            }
+            std::unique_ptr<std::FILE, decltype(&std::fclose)> guard(handle, &std::fclose);
+
+            const std::size_t nchunks = layout.chunks.size();
+            for (std::size_t first = 0; first < nchunks; first += batch_size) {
+                Batch batch;
+                batch.first = first;
+                batch.last = std::min(first + batch_size, nchunks);
+                for (auto c = batch.first; c < batch.last; ++c) {
+                    const auto& loc = layout.chunks[c];
+                    std::vector<unsigned char> raw(loc.size);
+                    if (std::fseek(handle, layout.base_address + loc.address, SEEK_SET) != 0 || std::fread(raw.data(), 1, raw.size(), handle) != raw.size()) {
+                        throw std::runtime_error("failed to read a chunk of the HDF5 dataset");
+                    }
+                    batch.raw.push_back(std::move(raw));
+                }
+
+                std::unique_lock lck(mut);
+                cv.wait(lck, [&]() -> bool { return cancelled || filled.size() < max_batches; });
+                if (cancelled) {
+                    return;
+                }
+                filled.push_back(std::move(batch));
+                cv.notify_all();
+            }
+
+            std::unique_lock lck(mut);
+            finished = true;
+            cv.notify_all();
+        } catch (...) {
+            std::unique_lock lck(mut);
+            error = std::current_exception();
+            finished = true;
+            cv.notify_all();
+        }
+    });
+
+    try {
+        while (1) {
+            Batch batch;
+            {
+                std::unique_lock lck(mut);
+                cv.wait(lck, [&]() -> bool { return finished || !filled.empty(); });
+                if (filled.empty()) {
+                    if (error) {
+                        std::rethrow_exception(error);
+                    }
+                    break;
+                }
+                batch = std::move(filled.front());
+                filled.pop_front();
+                cv.notify_all();
+            }
+
+            subpar::parallelize_range(nthreads, batch.raw.size(), [&](int, std::size_t start, std::size_t length) -> void {
+                std::vector<unsigned char> work;
+                for (auto b = start, end = start + length; b < end; ++b) {
+                    const auto& loc = layout.chunks[batch.first + b];
+                    auto& raw = batch.raw[b];
+                    decode_raw_chunk(raw, loc.filter_mask, layout, work);
+                    if (loc.offset >= layout.extent) {
+                        continue;
+                    }
+                    const std::size_t n = std::min(layout.chunk_length, layout.extent - loc.offset);
+                    if (raw.size() < n * layout.type_size) {
+                        throw std::runtime_error("chunk of the HDF5 dataset is smaller than expected");
+                    }
+                    convert_chunk_elements(raw.data(), n, layout, output + loc.offset);
+                    std::vector<unsigned char>().swap(raw);
+                }
+            });
+        }
+    } catch (...) {
+        {
+            std::unique_lock lck(mut);
+            cancelled = true;
+            cv.notify_all();
+        }
+        reader.join();
+        throw;
+    }
+
+    reader.join();
+}
+
+#endif
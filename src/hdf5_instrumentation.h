@@ -0,0 +1,481 @@
+#ifndef HDF5_INSTRUMENTATION_H
+#define HDF5_INSTRUMENTATION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+#include "H5Cpp.h"
+#include "tatami/tatami.hpp"
+
+#include "utils.h"
+#include "NumericMatrix.h"
+#include "file_access_counters.h"
+#include "hdf5_serialize.h"
+
+/**********************************/
+
+// Chunks that are read from the file to serve a cache miss. We can't see
+// inside tatami_hdf5's cache, so we estimate these from the chunk layout,
+// assuming that a miss reads all chunks overlapping the requested
+// row/column. Only Deflate-compressed chunks are counted.
+struct ChunkReadCounts {
+    std::uint64_t chunks = 0;
+    std::uint64_t compressed_bytes = 0;
+    std::uint64_t decompressed_bytes = 0;
+
+    ChunkReadCounts& operator+=(const ChunkReadCounts& other) {
+        chunks += other.chunks;
+        compressed_bytes += other.compressed_bytes;
+        decompressed_bytes += other.decompressed_bytes;
+        return *this;
+    }
+};
+
+class FileChunkLayout {
+public:
+    virtual ~FileChunkLayout() = default;
+
+    virtual ChunkReadCounts count(bool row, MatrixIndex i) const = 0;
+};
+
+struct DatasetChunks {
+    std::vector<hsize_t> dims;
+    std::vector<hsize_t> chunk_dims;
+    std::vector<hsize_t> grid;
+    std::size_t chunk_bytes = 0;
+
+    // Stored size of each chunk in the row-major grid of chunks. This is
+    // zero for chunks that are not allocated or were not Deflate-compressed.
+    std::vector<hsize_t> stored;
+};
+
+inline DatasetChunks inspect_dataset_chunks(const H5::DataSet& dhandle) {
+    DatasetChunks output;
+    auto space = dhandle.getSpace();
+    const int ndims = space.getSimpleExtentNdims();
+    output.dims.resize(ndims);
+    space.getSimpleExtentDims(output.dims.data());
+
+    auto plist = dhandle.getCreatePlist();
+    if (plist.getLayout() != H5D_CHUNKED) {
+        return output;
+    }
+    output.chunk_dims.resize(ndims);
+    plist.getChunk(ndims, output.chunk_dims.data());
+
+    std::size_t deflate_position = 0;
+    bool has_deflate = false;
+    const int nfilters = plist.getNfilters();
+    for (int f = 0; f < nfilters; ++f) {
+        unsigned flags;
+        std::size_t nelmts = 0;
+        unsigned filter_config;
+        char name[64];
+        if (plist.getFilter(f, flags, nelmts, NULL, sizeof(name), name, filter_config) == H5Z_FILTER_DEFLATE) {
+            deflate_position = f;
+            has_deflate = true;
+        }
+    }
+    if (!has_deflate) {
+        return output;
+    }
+
+    output.grid.resize(ndims);
+    std::size_t nchunks = 1;
+    output.chunk_bytes = dhandle.getDataType().getSize();
+    for (int d = 0; d < ndims; ++d) {
+        output.grid[d] = (output.chunk_dims[d] ? (output.dims[d] + output.chunk_dims[d] - 1) / output.chunk_dims[d] : 0);
+        nchunks *= output.grid[d];
+        output.chunk_bytes *= output.chunk_dims[d];
+    }
+    output.stored.resize(nchunks);
+
+    auto add_chunk = [&](const hsize_t* offset, unsigned filter_mask, hsize_t size) -> void {
+        if (filter_mask & (1u << deflate_position)) {
+            return;
+        }
+        std::size_t position = 0;
+        for (int d = 0; d < ndims; ++d) {
+            position = position * output.grid[d] + offset[d] / output.chunk_dims[d];
+        }
+        if (position < nchunks) {
+            output.stored[position] = size;
+        }
+    };
+
+#if H5_VERSION_GE(1, 14, 1)
+    // Iterating once over the chunk index, as H5Dget_chunk_info() is linear in the chunk index.
+    typedef I<decltype(add_chunk)> Adder;
+    auto callback = [](const hsize_t* offset, unsigned filter_mask, haddr_t, hsize_t size, void* data) -> int {
+        (*static_cast<Adder*>(data))(offset, filter_mask, size);
+        return H5_ITER_CONT;
+    };
+    if (H5Dchunk_iter(dhandle.getId(), H5P_DEFAULT, callback, &add_chunk) < 0) {
+        throw std::runtime_error("failed to iterate over the chunks of an HDF5 dataset");
+    }
+#else
+    hsize_t nallocated = 0;
+    if (H5Dget_num_chunks(dhandle.getId(), space.getId(), &nallocated) < 0) {
+        throw std::runtime_error("failed to count the chunks of an HDF5 dataset");
+    }
+    std::vector<hsize_t> offset(ndims);
+    for (hsize_t c = 0; c < nallocated; ++c) {
+        unsigned filter_mask;
+        haddr_t address;
+        hsize_t size;
+        if (H5Dget_chunk_info(dhandle.getId(), space.getId(), c, offset.data(), &filter_mask, &address, &size) < 0) {
+            throw std::runtime_error("failed to retrieve chunk information from an HDF5 dataset");
+        }
+        add_chunk(offset.data(), filter_mask, size);
+    }
+#endif
+
+    return output;
+}
+
+// For a dense dataset, a miss reads all chunks in the slab of chunks that
+// contains the requested row/column. We precompute the totals for each slab.
+class DenseChunkLayout final : public FileChunkLayout {
+public:
+    DenseChunkLayout(const std::string& path, const std::string& name, bool trans) : my_trans(trans) {
+        H5::H5File handle(path, H5F_ACC_RDONLY);
+        const auto chunks = inspect_dataset_chunks(handle.openDataSet(name));
+        if (chunks.stored.empty() || chunks.dims.size() != 2) {
+            return;
+        }
+
+        my_chunk_dims = chunks.chunk_dims;
+        for (int d = 0; d < 2; ++d) {
+            my_slabs[d].resize(chunks.grid[d]);
+        }
+        for (hsize_t c0 = 0; c0 < chunks.grid[0]; ++c0) {
+            for (hsize_t c1 = 0; c1 < chunks.grid[1]; ++c1) {
+                const auto stored = chunks.stored[c0 * chunks.grid[1] + c1];
+                if (stored) {
+                    ChunkReadCounts current;
+                    current.chunks = 1;
+                    current.compressed_bytes = stored;
+                    current.decompressed_bytes = chunks.chunk_bytes;
+                    my_slabs[0][c0] += current;
+                    my_slabs[1][c1] += current;
+                }
+            }
+        }
+    }
+
+    ChunkReadCounts count(bool row, MatrixIndex i) const {
+        // Rows of the matrix are the first dimension of the dataset, unless it is transposed.
+        const int dim = (row != my_trans ? 0 : 1);
+        const auto& slabs = my_slabs[dim];
+        if (slabs.empty()) {
+            return ChunkReadCounts();
+        }
+        return slabs[static_cast<hsize_t>(i) / my_chunk_dims[dim]];
+    }
+
+private:
+    bool my_trans;
+    std::vector<hsize_t> my_chunk_dims;
+    std::vector<ChunkReadCounts> my_slabs[2];
+};
+
+// For a compressed sparse matrix, a miss in the primary dimension reads the
+// chunks of 'data' and 'indices' that overlap the requested row/column, while
+// a miss in the secondary dimension needs to read all of the chunks.
+class SparseChunkLayout final : public FileChunkLayout {
+public:
+    SparseChunkLayout(const std::string& path, const std::string& data_name, const std::string& indices_name, const std::string& indptr_name, bool csc) : my_csc(csc) {
+        H5::H5File handle(path, H5F_ACC_RDONLY);
+
+        auto iphandle = handle.openDataSet(indptr_name);
+        hsize_t nptrs;
+        iphandle.getSpace().getSimpleExtentDims(&nptrs);
+        my_indptr.resize(nptrs);
+        iphandle.read(my_indptr.data(), H5::PredType::NATIVE_HSIZE);
+
+        add_dataset(inspect_dataset_chunks(handle.openDataSet(data_name)));
+        add_dataset(inspect_dataset_chunks(handle.openDataSet(indices_name)));
+    }
+
+    ChunkReadCounts count(bool row, MatrixIndex i) const {
+        if (row == my_csc) {
+            return my_total;
+        }
+
+        ChunkReadCounts output;
+        const auto start = my_indptr[i], end = my_indptr[i + 1];
+        if (start == end) {
+            return output;
+        }
+        for (const auto& current : my_datasets) {
+            // Cumulative sums are stored so that the counts for any run of chunks can be computed in constant time.
+            const auto first = start / current.chunk_length, last = (end - 1) / current.chunk_length + 1;
+            output.chunks += current.cumulative[last].chunks - current.cumulative[first].chunks;
+            output.compressed_bytes += current.cumulative[last].compressed_bytes - current.cumulative[first].compressed_bytes;
+            output.decompressed_bytes += current.cumulative[last].decompressed_bytes - current.cumulative[first].decompressed_bytes;
+        }
+        return output;
+    }
+
+private:
+    bool my_csc;
+    std::vector<hsize_t> my_indptr;
+
+    struct Dataset {
+        hsize_t chunk_length;
+        std::vector<ChunkReadCounts> cumulative;
+    };
+    std::vector<Dataset> my_datasets;
+    ChunkReadCounts my_total;
+
+    void add_dataset(const DatasetChunks& chunks) {
+        if (chunks.stored.empty() || chunks.dims.size() != 1) {
+            return;
+        }
+
+        Dataset current;
+        current.chunk_length = chunks.chunk_dims[0];
+        current.cumulative.resize(chunks.stored.size() + 1);
+        for (std::size_t c = 0, end = chunks.stored.size(); c < end; ++c) {
+            ChunkReadCounts counts;
+            if (chunks.stored[c]) {
+                counts.chunks = 1;
+                counts.compressed_bytes = chunks.stored[c];
+                counts.decompressed_bytes = chunks.chunk_bytes;
+            }
+            current.cumulative[c + 1] = current.cumulative[c];
+            current.cumulative[c + 1] += counts;
+        }
+
+        my_total += current.cumulative.back();
+        my_datasets.push_back(std::move(current));
+    }
+};
+
+/**********************************/
+
+// Caching policies for file-backed matrices. PREDICTIVE uses the oracles
+// supplied by the caller (e.g., for consecutive access in tatami::parallelize)
+// to prefetch chunks that will be needed later; LRU ignores the oracles and
+// caches the most recently used chunks; and NONE disables the cache.
+enum class FileCachePolicy : char { PREDICTIVE, LRU, NONE };
+
+inline FileCachePolicy translate_file_cache_policy(const std::string& policy) {
+    if (policy == "lru") {
+        return FileCachePolicy::LRU;
+    } else if (policy == "none") {
+        return FileCachePolicy::NONE;
+    } else if (policy != "predictive") {
+        throw std::runtime_error("unknown cache policy '" + policy + "'");
+    }
+    return FileCachePolicy::PREDICTIVE;
+}
+
+// A fetch is a miss if tatami_hdf5 had to call into the HDF5 library to
+// serve it, see hdf5_serialize.h; otherwise it was served from the cache.
+template<class Fetch_>
+auto count_file_access(FileAccessCounters& counters, const FileChunkLayout& layout, bool row, MatrixIndex i, Fetch_ fetch) {
+    const auto before = hdf5_library_calls();
+    auto output = fetch();
+
+    ++counters.fetches;
+    if (hdf5_library_calls() == before) {
+        ++counters.hits;
+    } else {
+        ++counters.misses;
+        const auto read = layout.count(row, i);
+        counters.chunks += read.chunks;
+        counters.compressed_bytes += read.compressed_bytes;
+        counters.decompressed_bytes += read.decompressed_bytes;
+    }
+    return output;
+}
+
+// Oracular extractors ignore the index passed to fetch(), so we need to
+// follow the oracle ourselves to know which row/column was requested.
+template<bool oracle_>
+class FetchedIndexTracker {
+public:
+    FetchedIndexTracker(tatami::MaybeOracle<oracle_, MatrixIndex> oracle) : my_oracle(std::move(oracle)) {}
+
+    MatrixIndex next(MatrixIndex i) {
+        if constexpr(oracle_) {
+            return my_oracle->get(my_used++);
+        } else {
+            return i;
+        }
+    }
+
+private:
+    tatami::MaybeOracle<oracle_, MatrixIndex> my_oracle;
+    typename std::conditional<oracle_, tatami::PredictionIndex, bool>::type my_used = 0;
+};
+
+struct FileAccessRecorder {
+    std::shared_ptr<FileAccessCounters> counters;
+    std::shared_ptr<const FileChunkLayout> layout;
+};
+
+template<bool oracle_>
+class InstrumentedDenseExtractor final : public tatami::DenseExtractor<oracle_, MatrixValue, MatrixIndex> {
+public:
+    InstrumentedDenseExtractor(std::unique_ptr<tatami::DenseExtractor<oracle_, MatrixValue, MatrixIndex> > inner, FileAccessRecorder recorder, bool row, tatami::MaybeOracle<oracle_, MatrixIndex> oracle) :
+        my_inner(std::move(inner)), my_recorder(std::move(recorder)), my_row(row), my_tracker(std::move(oracle)) {}
+
+    const MatrixValue* fetch(MatrixIndex i, MatrixValue* buffer) {
+        return count_file_access(*(my_recorder.counters), *(my_recorder.layout), my_row, my_tracker.next(i), [&]() -> const MatrixValue* { return my_inner->fetch(i, buffer); });
+    }
+
+private:
+    std::unique_ptr<tatami::DenseExtractor<oracle_, MatrixValue, MatrixIndex> > my_inner;
+    FileAccessRecorder my_recorder;
+    bool my_row;
+    FetchedIndexTracker<oracle_> my_tracker;
+};
+
+template<bool oracle_>
+class InstrumentedSparseExtractor final : public tatami::SparseExtractor<oracle_, MatrixValue, MatrixIndex> {
+public:
+    InstrumentedSparseExtractor(std::unique_ptr<tatami::SparseExtractor<oracle_, MatrixValue, MatrixIndex> > inner, FileAccessRecorder recorder, bool row, tatami::MaybeOracle<oracle_, MatrixIndex> oracle) :
+        my_inner(std::move(inner)), my_recorder(std::move(recorder)), my_row(row), my_tracker(std::move(oracle)) {}
+
+    tatami::SparseRange<MatrixValue, MatrixIndex> fetch(MatrixIndex i, MatrixValue* vbuffer, MatrixIndex* ibuffer) {
+        return count_file_access(*(my_recorder.counters), *(my_recorder.layout), my_row, my_tracker.next(i), [&]() -> tatami::SparseRange<MatrixValue, MatrixIndex> { return my_inner->fetch(i, vbuffer, ibuffer); });
+    }
+
+private:
+    std::unique_ptr<tatami::SparseExtractor<oracle_, MatrixValue, MatrixIndex> > my_inner;
+    FileAccessRecorder my_recorder;
+    bool my_row;
+    FetchedIndexTracker<oracle_> my_tracker;
+};
+
+// Wrapper around a file-backed matrix that counts the accesses by all of its
+// extractors. If oracles are not used, oracular extractors are emulated with
+// myopic extractors so that the underlying matrix falls back to LRU caching.
+class InstrumentedFileMatrix final : public tatami::NumericMatrix {
+public:
+    InstrumentedFileMatrix(std::shared_ptr<const tatami::NumericMatrix> inner, FileAccessRecorder recorder, bool use_oracle) :
+        my_inner(std::move(inner)), my_recorder(std::move(recorder)), my_use_oracle(use_oracle) {}
+
+private:
+    std::shared_ptr<const tatami::NumericMatrix> my_inner;
+    FileAccessRecorder my_recorder;
+    bool my_use_oracle;
+
+    typedef std::shared_ptr<const tatami::Oracle<MatrixIndex> > OraclePtr;
+
+    template<bool oracle_>
+    std::unique_ptr<tatami::DenseExtractor<oracle_, MatrixValue, MatrixIndex> > wrap(std::unique_ptr<tatami::DenseExtractor<oracle_, MatrixValue, MatrixIndex> > ext, bool row, tatami::MaybeOracle<oracle_, MatrixIndex> oracle) const {
+        return std::make_unique<InstrumentedDenseExtractor<oracle_> >(std::move(ext), my_recorder, row, oracle);
+    }
+
+    template<bool oracle_>
+    std::unique_ptr<tatami::SparseExtractor<oracle_, MatrixValue, MatrixIndex> > wrap(std::unique_ptr<tatami::SparseExtractor<oracle_, MatrixValue, MatrixIndex> > ext, bool row, tatami::MaybeOracle<oracle_, MatrixIndex> oracle) const {
+        return std::make_unique<InstrumentedSparseExtractor<oracle_> >(std::move(ext), my_recorder, row, oracle);
+    }
+
+public:
+    MatrixIndex nrow() const {
+        return my_inner->nrow();
+    }
+
+    MatrixIndex ncol() const {
+        return my_inner->ncol();
+    }
+
+    bool is_sparse() const {
+        return my_inner->is_sparse();
+    }
+
+    double is_sparse_proportion() const {
+        return my_inner->is_sparse_proportion();
+    }
+
+    bool prefer_rows() const {
+        return my_inner->prefer_rows();
+    }
+
+    double prefer_rows_proportion() const {
+        return my_inner->prefer_rows_proportion();
+    }
+
+    bool uses_oracle(bool row) const {
+        return my_use_oracle && my_inner->uses_oracle(row);
+    }
+
+public:
+    std::unique_ptr<tatami::MyopicDenseExtractor<MatrixValue, MatrixIndex> > dense(bool row, const tatami::Options& opt) const {
+        return wrap<false>(my_inner->dense(row, opt), row, false);
+    }
+
+    std::unique_ptr<tatami::MyopicDenseExtractor<MatrixValue, MatrixIndex> > dense(bool row, MatrixIndex block_start, MatrixIndex block_length, const tatami::Options& opt) const {
+        return wrap<false>(my_inner->dense(row, block_start, block_length, opt), row, false);
+    }
+
+    std::unique_ptr<tatami::MyopicDenseExtractor<MatrixValue, MatrixIndex> > dense(bool row, tatami::VectorPtr<MatrixIndex> indices_ptr, const tatami::Options& opt) const {
+        return wrap<false>(my_inner->dense(row, std::move(indices_ptr), opt), row, false);
+    }
+
+    std::unique_ptr<tatami::MyopicSparseExtractor<MatrixValue, MatrixIndex> > sparse(bool row, const tatami::Options& opt) const {
+        return wrap<false>(my_inner->sparse(row, opt), row, false);
+    }
+
+    std::unique_ptr<tatami::MyopicSparseExtractor<MatrixValue, MatrixIndex> > sparse(bool row, MatrixIndex block_start, MatrixIndex block_length, const tatami::Options& opt) const {
+        return wrap<false>(my_inner->sparse(row, block_start, block_length, opt), row, false);
+    }
+
+    std::unique_ptr<tatami::MyopicSparseExtractor<MatrixValue, MatrixIndex> > sparse(bool row, tatami::VectorPtr<MatrixIndex> indices_ptr, const tatami::Options& opt) const {
+        return wrap<false>(my_inner->sparse(row, std::move(indices_ptr), opt), row, false);
+    }
+
+public:
+    std::unique_ptr<tatami::OracularDenseExtractor<MatrixValue, MatrixIndex> > dense(bool row, OraclePtr oracle, const tatami::Options& opt) const {
+        if (!my_use_oracle) {
+            return std::make_unique<tatami::PseudoOracularDenseExtractor<MatrixValue, MatrixIndex> >(std::move(oracle), dense(row, opt));
+        }
+        return wrap<true>(my_inner->dense(row, oracle, opt), row, oracle);
+    }
+
+    std::unique_ptr<tatami::OracularDenseExtractor<MatrixValue, MatrixIndex> > dense(bool row, OraclePtr oracle, MatrixIndex block_start, MatrixIndex block_length, const tatami::Options& opt) const {
+        if (!my_use_oracle) {
+            return std::make_unique<tatami::PseudoOracularDenseExtractor<MatrixValue, MatrixIndex> >(std::move(oracle), dense(row, block_start, block_length, opt));
+        }
+        return wrap<true>(my_inner->dense(row, oracle, block_start, block_length, opt), row, oracle);
+    }
+
+    std::unique_ptr<tatami::OracularDenseExtractor<MatrixValue, MatrixIndex> > dense(bool row, OraclePtr oracle, tatami::VectorPtr<MatrixIndex> indices_ptr, const tatami::Options& opt) const {
+        if (!my_use_oracle) {
+            return std::make_unique<tatami::PseudoOracularDenseExtractor<MatrixValue, MatrixIndex> >(std::move(oracle), dense(row, std::move(indices_ptr), opt));
+        }
+        return wrap<true>(my_inner->dense(row, oracle, std::move(indices_ptr), opt), row, oracle);
+    }
+
+    std::unique_ptr<tatami::OracularSparseExtractor<MatrixValue, MatrixIndex> > sparse(bool row, OraclePtr oracle, const tatami::Options& opt) const {
+        if (!my_use_oracle) {
+            return std::make_unique<tatami::PseudoOracularSparseExtractor<MatrixValue, MatrixIndex> >(std::move(oracle), sparse(row, opt));
+        }
+        return wrap<true>(my_inner->sparse(row, oracle, opt), row, oracle);
+    }
+
+    std::unique_ptr<tatami::OracularSparseExtractor<MatrixValue, MatrixIndex> > sparse(bool row, OraclePtr oracle, MatrixIndex block_start, MatrixIndex block_length, const tatami::Options& opt) const {
+        if (!my_use_oracle) {
+            return std::make_unique<tatami::PseudoOracularSparseExtractor<MatrixValue, MatrixIndex> >(std::move(oracle), sparse(row, block_start, block_length, opt));
+        }
+        return wrap<true>(my_inner->sparse(row, oracle, block_start, block_length, opt), row, oracle);
+    }
+
+    std::unique_ptr<tatami::OracularSparseExtractor<MatrixValue, MatrixIndex> > sparse(bool row, OraclePtr oracle, tatami::VectorPtr<MatrixIndex> indices_ptr, const tatami::Options& opt) const {
+        if (!my_use_oracle) {
+            return std::make_unique<tatami::PseudoOracularSparseExtractor<MatrixValue, MatrixIndex> >(std::move(oracle), sparse(row, std::move(indices_ptr), opt));
+        }
+        return wrap<true>(my_inner->sparse(row, oracle, std::move(indices_ptr), opt), row, oracle);
+    }
+};
+
+#endif
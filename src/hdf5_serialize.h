@@ -0,0 +1,32 @@
+#ifndef HDF5_SERIALIZE_H
+#define HDF5_SERIALIZE_H
+
+#include <mutex>
+#include <cstdint>
+
+// Lock for all calls into the HDF5 library by tatami_hdf5, as the library is
+// not thread-safe. This also counts the calls made by the current thread,
+// which is used by hdf5_instrumentation.h to detect cache misses in the
+// file-backed matrices; cache hits are served without touching the library.
+// This must be included before any inclusion of tatami_hdf5.
+
+inline std::uint64_t& hdf5_library_calls() {
+    thread_local std::uint64_t calls = 0;
+    return calls;
+}
+
+inline std::mutex& hdf5_library_mutex() {
+    static std::mutex mut;
+    return mut;
+}
+
+template<class Function_>
+void serialize_hdf5_library(Function_ fun) {
+    std::lock_guard<std::mutex> lck(hdf5_library_mutex());
+    ++hdf5_library_calls();
+    fun();
+}
+
+#define TATAMI_HDF5_PARALLEL_LOCK serialize_hdf5_library
+
+#endif
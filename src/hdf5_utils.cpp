@@ -7,8 +7,10 @@
 #include <algorithm>
 #include <unordered_map>
 #include <iostream>
+#include <cstring>
 
 #include "utils.h"
+#include "string_pool.h"
 
 #include "H5Cpp.h"
 
@@ -491,14 +493,12 @@ emscripten::val extract_compound_values(const Handle_& handle) {
     return comp_data;
 }
 
-template<class Reader_, class Handle_>
-emscripten::val extract_string_values(const Handle_& handle) {
+template<class Reader_, class Handle_, class Function_>
+void visit_string_values(const Handle_& handle, Function_ fun) {
     auto dtype = handle.getDataType();
     auto dspace = handle.getSpace();
-    auto output = emscripten::val::array();
     auto full_length = get_full_length(handle);
 
-    std::string bufstr;
     if (dtype.isVariableStr()) {
         std::vector<char*> buffer(full_length);
         Reader_::read(handle, buffer.data(), dtype);
@@ -506,9 +506,7 @@ emscripten::val extract_string_values(const Handle_& handle) {
             H5Dvlen_reclaim(dtype.getId(), dspace.getId(), H5P_DEFAULT, buffer.data());
         });
         for (I<decltype(full_length)> i = 0; i < full_length; ++i) {
-            bufstr.clear();
-            bufstr.insert(0, buffer[i]);
-            output.call<void>("push", bufstr);
+            fun(buffer[i], std::strlen(buffer[i]));
         }
 
     } else {
@@ -519,13 +517,29 @@ emscripten::val extract_string_values(const Handle_& handle) {
         for (I<decltype(full_length)> i = 0; i < full_length; ++i) {
             I<decltype(strlen)> j = 0;
             for (; j < strlen && start[j] != '\0'; ++j) {}
-            bufstr.clear();
-            bufstr.insert(bufstr.end(), start, start + j);
-            output.call<void>("push", bufstr);
+            fun(start, j);
             start += strlen;
         }
     }
+}
 
+template<class Reader_, class Handle_>
+emscripten::val extract_string_values(const Handle_& handle) {
+    auto output = emscripten::val::array();
+    std::string bufstr;
+    visit_string_values<Reader_>(handle, [&](const char* ptr, std::size_t len) -> void {
+        bufstr.assign(ptr, len);
+        output.call<void>("push", bufstr);
+    });
+    return output;
+}
+
+template<class Reader_, class Handle_>
+StringPool extract_string_pool(const Handle_& handle) {
+    StringPool output(get_full_length(handle));
+    visit_string_values<Reader_>(handle, [&](const char* ptr, std::size_t len) -> void {
+        output.add(ptr, len);
+    });
     return output;
 }
 
@@ -569,6 +583,14 @@ public:
             throw std::runtime_error(e.getCDetailMsg());
         } 
     }
+
+    StringPool js_string_pool() const {
+        try {
+            return extract_string_pool<Internal>(my_dhandle);
+        } catch (H5::Exception& e) {
+            throw std::runtime_error(e.getCDetailMsg());
+        } 
+    }
 };
 
 class LoadedH5Attr {
@@ -939,20 +961,23 @@ void write_numeric_hdf5_base(Handle_& handle, const std::string& type, JsFakeInt
     }
 }
 
-template<class Writer_, class Handle_>
-void write_string_hdf5_base(Handle_& handle, const emscripten::val& data) {
+// 'visit' should call its argument with the pointer and length of each string.
+template<class Writer_, class Handle_, class Visitor_>
+void write_visited_strings_hdf5_base(Handle_& handle, Visitor_ visit) {
     auto full_length = get_full_length(handle);
     auto stype = handle.getStrType();
 
     if (stype.isVariableStr()) {
         std::vector<std::string> all_strings;
         all_strings.reserve(full_length);
+        visit([&](const char* ptr, std::size_t len) -> void {
+            all_strings.emplace_back(ptr, len);
+        });
+
         std::vector<const char*> ptrs;
         ptrs.reserve(full_length);
-
-        for (auto x : data) {
-            all_strings.emplace_back(x.template as<std::string>());
-            ptrs.emplace_back(all_strings.back().c_str());
+        for (const auto& x : all_strings) {
+            ptrs.emplace_back(x.c_str());
         }
 
         Writer_::write(handle, ptrs.data(), stype);
@@ -961,16 +986,25 @@ void write_string_hdf5_base(Handle_& handle, const emscripten::val& data) {
         auto max_len = stype.getSize();
         std::vector<char> temp(sanisizer::product<typename std::vector<char>::size_type>(max_len, full_length), '\0');
         auto it = temp.data();
-        for (auto x : data) {
-            auto current = x.template as<std::string>();
-            std::copy_n(current.data(), std::min(current.size(), max_len), it);
+        visit([&](const char* ptr, std::size_t len) -> void {
+            std::copy_n(ptr, std::min(len, max_len), it);
             it += max_len;
-        }
+        });
 
         Writer_::write(handle, temp.data(), stype);
     }
 }
 
+template<class Writer_, class Handle_>
+void write_string_hdf5_base(Handle_& handle, const emscripten::val& data) {
+    write_visited_strings_hdf5_base<Writer_>(handle, [&](auto fun) -> void {
+        for (auto x : data) {
+            auto current = x.template as<std::string>();
+            fun(current.data(), current.size());
+        }
+    });
+}
+
 template<class Writer_, class Handle_>
 void write_enum_hdf5_base(Handle_& handle, JsFakeInt data_raw) {
     const auto data = js2int<std::uintptr_t>(data_raw);
@@ -1124,6 +1158,25 @@ void js_write_string_hdf5_dataset(std::string path, std::string name, emscripten
     }
 }
 
+void js_write_string_pool_hdf5_dataset(std::string path, std::string name, JsFakeInt bytes_raw, JsFakeInt nbytes_raw, JsFakeInt offsets_raw, JsFakeInt n_raw) {
+    const auto nbytes = js2int<std::size_t>(nbytes_raw);
+    const auto n = js2int<std::size_t>(n_raw);
+    try {
+        H5::H5File handle(path, H5F_ACC_RDWR);
+        auto dhandle = handle.openDataSet(name);
+        if (get_full_length(dhandle) != n) {
+            throw std::runtime_error("number of strings in the pool should be equal to the length of the dataset");
+        }
+        write_visited_strings_hdf5_base<DataSetHandleWriter>(dhandle, [&](auto fun) -> void {
+            visit_string_pool(bytes_raw, nbytes, offsets_raw, n, [&](std::size_t, const char* ptr, std::size_t len) -> void {
+                fun(ptr, len);
+            });
+        });
+    } catch (H5::Exception& e) {
+        throw std::runtime_error(e.getCDetailMsg());
+    }
+}
+
 void js_write_enum_hdf5_dataset(std::string path, std::string name, JsFakeInt data) {
     try {
         H5::H5File handle(path, H5F_ACC_RDWR);
@@ -1292,6 +1345,7 @@ EMSCRIPTEN_BINDINGS(hdf5_utils) {
         .constructor<std::string, std::string>()
         .function("numeric_values", &LoadedH5DataSet::js_numeric_values, emscripten::return_value_policy::take_ownership())
         .function("string_values", &LoadedH5DataSet::js_string_values, emscripten::return_value_policy::take_ownership())
+        .function("string_pool", &LoadedH5DataSet::js_string_pool, emscripten::return_value_policy::take_ownership())
         .function("compound_values", &LoadedH5DataSet::js_compound_values, emscripten::return_value_policy::take_ownership())
         ;
 
@@ -1319,6 +1373,7 @@ EMSCRIPTEN_BINDINGS(hdf5_utils) {
 
    emscripten::function("write_numeric_hdf5_dataset", &js_write_numeric_hdf5_dataset, emscripten::return_value_policy::take_ownership());
    emscripten::function("write_string_hdf5_dataset", &js_write_string_hdf5_dataset, emscripten::return_value_policy::take_ownership());
+   emscripten::function("write_string_pool_hdf5_dataset", &js_write_string_pool_hdf5_dataset, emscripten::return_value_policy::take_ownership());
    emscripten::function("write_enum_hdf5_dataset", &js_write_enum_hdf5_dataset, emscripten::return_value_policy::take_ownership());
    emscripten::function("write_compound_hdf5_dataset", &js_write_compound_hdf5_dataset, emscripten::return_value_policy::take_ownership());
 
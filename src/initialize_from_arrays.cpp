@@ -66,7 +66,8 @@ NumericMatrix initialize_sparse_matrix_internal(
     JsFakeInt indptrs_raw,
     const std::string& indptrs_type,
     bool by_row,
-    bool layered
+    bool layered,
+    bool float32
 ) {
     const auto nrows = js2int<MatrixIndex>(nrows_raw);
     const auto ncols = js2int<MatrixIndex>(ncols_raw);
@@ -77,7 +78,11 @@ NumericMatrix initialize_sparse_matrix_internal(
     if (by_row && !layered) {
         // Directly creating a CSR matrix.
         auto ind = create_SomeNumericArray<std::size_t>(indptrs_raw, sanisizer::sum<std::size_t>(nrows, 1), indptrs_type);
-        return copy_into_sparse<Type_>(nrows, ncols, val, idx, ind);
+        if (float32) {
+            return copy_into_sparse<float>(nrows, ncols, val, idx, ind);
+        } else {
+            return copy_into_sparse<Type_>(nrows, ncols, val, idx, ind);
+        }
     } else {
         std::shared_ptr<tatami::Matrix<Type_, MatrixIndex> > mat;
         if (by_row) {
@@ -87,7 +92,7 @@ NumericMatrix initialize_sparse_matrix_internal(
             auto ind = create_SomeNumericArray<std::size_t>(indptrs_raw, sanisizer::sum<std::size_t>(ncols, 1), indptrs_type);
             mat.reset(new tatami::CompressedSparseColumnMatrix<Type_, MatrixIndex, I<decltype(val)>, I<decltype(idx)>, I<decltype(ind)> >(nrows, ncols, val, idx, ind));
         }
-        return sparse_from_tatami(*mat, layered);
+        return sparse_from_tatami(*mat, layered, float32);
     }
 }
 
@@ -103,13 +108,16 @@ NumericMatrix js_initialize_from_sparse_arrays(
     std::string indptrs_type,
     bool by_row,
     bool force_integer,
-    bool layered
+    bool layered,
+    bool float32
 ) {
-    if (force_integer || is_type_integer(value_type)) {
-        return initialize_sparse_matrix_internal<std::int32_t>(nrows_raw, ncols_raw, nelements_raw, values_raw, value_type, indices_raw, index_type, indptrs_raw, indptrs_type, by_row, layered);
-    } else {
-        return initialize_sparse_matrix_internal<double>(nrows_raw, ncols_raw, nelements_raw, values_raw, value_type, indices_raw, index_type, indptrs_raw, indptrs_type, by_row, false);
-    }
+    return track_storage([&]() -> NumericMatrix {
+        if (force_integer || is_type_integer(value_type)) {
+            return initialize_sparse_matrix_internal<std::int32_t>(nrows_raw, ncols_raw, nelements_raw, values_raw, value_type, indices_raw, index_type, indptrs_raw, indptrs_type, by_row, layered, false);
+        } else {
+            return initialize_sparse_matrix_internal<double>(nrows_raw, ncols_raw, nelements_raw, values_raw, value_type, indices_raw, index_type, indptrs_raw, indptrs_type, by_row, false, float32);
+        }
+    });
 }
 
 /**********************************/
@@ -121,13 +129,14 @@ NumericMatrix initialize_sparse_matrix_from_dense_vector_internal(
     JsFakeInt values_raw,
     const std::string& type,
     bool column_major,
-    bool layered
+    bool layered,
+    bool float32
 ) {
     const auto nrows = js2int<MatrixIndex>(nrows_raw);
     const auto ncols = js2int<MatrixIndex>(ncols_raw);
     auto vals = create_SomeNumericArray<Type_>(values_raw, sanisizer::product<std::size_t>(nrows, ncols), type);
     tatami::DenseMatrix<Type_, MatrixIndex, I<decltype(vals)> > mat(nrows, ncols, vals, !column_major);
-    return sparse_from_tatami(mat, layered);
+    return sparse_from_tatami(mat, layered, float32);
 }
 
 NumericMatrix js_initialize_sparse_matrix_from_dense_array(
@@ -137,16 +146,19 @@ NumericMatrix js_initialize_sparse_matrix_from_dense_array(
     std::string type,
     bool column_major,
     bool force_integer,
-    bool layered
+    bool layered,
+    bool float32
 ) {
-    if (force_integer || is_type_integer(type)) {
-        return initialize_sparse_matrix_from_dense_vector_internal<std::int32_t>(nrows_raw, ncols_raw, values_raw, type, column_major, layered);
-    } else {
-        return initialize_sparse_matrix_from_dense_vector_internal<double>(nrows_raw, ncols_raw, values_raw, type, column_major, false);
-    }
+    return track_storage([&]() -> NumericMatrix {
+        if (force_integer || is_type_integer(type)) {
+            return initialize_sparse_matrix_from_dense_vector_internal<std::int32_t>(nrows_raw, ncols_raw, values_raw, type, column_major, layered, false);
+        } else {
+            return initialize_sparse_matrix_from_dense_vector_internal<double>(nrows_raw, ncols_raw, values_raw, type, column_major, false, float32);
+        }
+    });
 }
 
-template<typename Type_>
+template<typename Type_, typename Stored_ = Type_>
 NumericMatrix initialize_dense_matrix_internal(
     JsFakeInt nrows_raw,
     JsFakeInt ncols_raw,
@@ -158,7 +170,7 @@ NumericMatrix initialize_dense_matrix_internal(
     const auto ncols = js2int<MatrixIndex>(ncols_raw);
     const auto len = sanisizer::product<std::size_t>(nrows, ncols);
     auto vals = create_SomeNumericArray<Type_>(values_raw, len, type);
-    auto tmp = sanisizer::create<std::vector<Type_> >(len);
+    auto tmp = sanisizer::create<std::vector<Stored_> >(len);
     std::copy(vals.begin(), vals.end(), tmp.begin());
     auto ptr = std::shared_ptr<const tatami::NumericMatrix>(new tatami::DenseMatrix<double, MatrixIndex, I<decltype(tmp)> >(nrows, ncols, std::move(tmp), !column_major));
     return NumericMatrix(std::move(ptr));
@@ -170,13 +182,18 @@ NumericMatrix js_initialize_dense_matrix_from_dense_array(
     JsFakeInt values_raw,
     std::string type,
     bool column_major,
-    bool force_integer
+    bool force_integer,
+    bool float32
 ) {
-    if (force_integer || is_type_integer(type)) {
-        return initialize_dense_matrix_internal<MatrixIndex>(nrows_raw, ncols_raw, values_raw, type, column_major); 
-    } else {
-        return initialize_dense_matrix_internal<double>(nrows_raw, ncols_raw, values_raw, type, column_major); 
-    }
+    return track_storage([&]() -> NumericMatrix {
+        if (force_integer || is_type_integer(type)) {
+            return initialize_dense_matrix_internal<MatrixIndex>(nrows_raw, ncols_raw, values_raw, type, column_major); 
+        } else if (float32) {
+            return initialize_dense_matrix_internal<double, float>(nrows_raw, ncols_raw, values_raw, type, column_major); 
+        } else {
+            return initialize_dense_matrix_internal<double>(nrows_raw, ncols_raw, values_raw, type, column_major); 
+        }
+    });
 }
 
 /**********************************/
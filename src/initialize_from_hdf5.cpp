@@ -6,10 +6,17 @@
 #include <stdexcept>
 #include <cstddef>
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <optional>
 
 #include "utils.h"
 #include "read_utils.h"
 #include "NumericMatrix.h"
+#include "hdf5_serialize.h"
+#include "hdf5_instrumentation.h"
+#include "hdf5_chunks.h"
 
 #include "H5Cpp.h"
 #include "tatami_hdf5/tatami_hdf5.hpp"
@@ -109,10 +116,8 @@ emscripten::val js_extract_hdf5_matrix_details(std::string path, std::string nam
 }
 
 template<typename Type_>
-NumericMatrix apply_post_processing(
-    std::shared_ptr<tatami::Matrix<Type_, MatrixIndex> > mat,
-    bool sparse,
-    bool layered, 
+std::shared_ptr<const tatami::Matrix<Type_, MatrixIndex> > apply_subsets(
+    std::shared_ptr<const tatami::Matrix<Type_, MatrixIndex> > mat,
     bool row_subset, 
     JsFakeInt row_offset_raw, 
     JsFakeInt row_length_raw,
@@ -136,13 +141,94 @@ NumericMatrix apply_post_processing(
         mat = std::move(smat);
     }
 
+    return mat;
+}
+
+template<typename Type_>
+NumericMatrix apply_post_processing(
+    std::shared_ptr<tatami::Matrix<Type_, MatrixIndex> > mat,
+    bool sparse,
+    bool layered, 
+    bool float32,
+    bool row_subset, 
+    JsFakeInt row_offset_raw, 
+    JsFakeInt row_length_raw,
+    bool col_subset, 
+    JsFakeInt col_offset_raw,
+    JsFakeInt col_length_raw,
+    int nthreads = 1
+) {
+    auto smat = apply_subsets<Type_>(std::move(mat), row_subset, row_offset_raw, row_length_raw, col_subset, col_offset_raw, col_length_raw);
     if (sparse) {
-        return sparse_from_tatami(*mat, layered);
+        return sparse_from_tatami(*smat, layered, float32, nthreads);
     } else {
-        return NumericMatrix(tatami::convert_to_dense<MatrixValue, MatrixIndex, Type_>(*mat, true, {}));
+        return dense_from_tatami(*smat, float32, nthreads);
     }
 }
 
+/**********************************/
+
+// File-backed matrices are not realized into memory; instead, each row or
+// column is read from the file on demand, using a chunk cache of the
+// specified size (in bytes) to avoid repeated reads of the same chunks.
+// Integer and single-precision values are cached with narrower types.
+
+template<class Options_>
+Options_ create_file_backed_options(JsFakeInt cache_size_raw, FileCachePolicy policy) {
+    Options_ opt;
+    if (policy == FileCachePolicy::NONE) {
+        opt.maximum_cache_size = 0;
+        opt.require_minimum_cache = false;
+    } else {
+        opt.maximum_cache_size = js2int<std::size_t>(cache_size_raw);
+    }
+    return opt;
+}
+
+template<typename Cached_>
+std::shared_ptr<const tatami::NumericMatrix> create_file_backed_dense(const std::string& path, const std::string& name, bool trans, JsFakeInt cache_size_raw, FileCachePolicy policy) {
+    auto opt = create_file_backed_options<tatami_hdf5::DenseMatrixOptions>(cache_size_raw, policy);
+    return std::make_shared<tatami_hdf5::DenseMatrix<MatrixValue, MatrixIndex, Cached_> >(path, name, trans, opt);
+}
+
+template<typename Cached_>
+std::shared_ptr<const tatami::NumericMatrix> create_file_backed_sparse(
+    const std::string& path, 
+    const std::string& data_name, 
+    const std::string& indices_name, 
+    const std::string& indptr_name, 
+    MatrixIndex nr,
+    MatrixIndex nc,
+    bool csc,
+    JsFakeInt cache_size_raw,
+    FileCachePolicy policy
+) {
+    auto opt = create_file_backed_options<tatami_hdf5::CompressedSparseMatrixOptions>(cache_size_raw, policy);
+    return std::make_shared<tatami_hdf5::CompressedSparseMatrix<MatrixValue, MatrixIndex, Cached_, MatrixIndex> >(nr, nc, path, data_name, indices_name, indptr_name, !csc, opt);
+}
+
+// Accesses are counted before any subsetting, so that the counters reflect
+// the reads from the file.
+NumericMatrix finalize_file_backed(
+    std::shared_ptr<const tatami::NumericMatrix> mat,
+    std::shared_ptr<const FileChunkLayout> layout,
+    FileCachePolicy policy,
+    bool row_subset, 
+    JsFakeInt row_offset_raw, 
+    JsFakeInt row_length_raw,
+    bool col_subset, 
+    JsFakeInt col_offset_raw,
+    JsFakeInt col_length_raw
+) {
+    auto counters = std::make_shared<FileAccessCounters>();
+    mat = std::make_shared<InstrumentedFileMatrix>(std::move(mat), FileAccessRecorder{ counters, std::move(layout) }, policy == FileCachePolicy::PREDICTIVE);
+    NumericMatrix output(apply_subsets<MatrixValue>(std::move(mat), row_subset, row_offset_raw, row_length_raw, col_subset, col_offset_raw, col_length_raw));
+    output.set_file_access_counters(std::move(counters));
+    return output;
+}
+
+/**********************************/
+
 template<typename Type_>
 NumericMatrix initialize_from_hdf5_dense_internal(
     const std::string& path, 
@@ -150,12 +236,14 @@ NumericMatrix initialize_from_hdf5_dense_internal(
     bool trans,
     bool sparse,
     bool layered, 
+    bool float32,
     bool row_subset, 
     JsFakeInt row_offset_raw, 
     JsFakeInt row_length_raw,
     bool col_subset, 
     JsFakeInt col_offset_raw,
-    JsFakeInt col_length_raw
+    JsFakeInt col_length_raw,
+    int nthreads
 ) {
     NumericMatrix mat;
 
@@ -164,12 +252,14 @@ NumericMatrix initialize_from_hdf5_dense_internal(
             std::make_shared<tatami_hdf5::DenseMatrix<Type_, std::int32_t> >(path, name, trans),
             sparse,
             layered, 
+            float32,
             row_subset, 
             row_offset_raw, 
             row_length_raw,
             col_subset, 
             col_offset_raw, 
-            col_length_raw
+            col_length_raw,
+            nthreads
         );
     } catch (H5::Exception& e) {
         throw std::runtime_error(e.getCDetailMsg());
@@ -185,53 +275,286 @@ NumericMatrix js_initialize_from_hdf5_dense(
     bool force_integer,
     bool sparse,
     bool layered, 
+    bool float32,
     bool row_subset, 
     JsFakeInt row_offset_raw, 
     JsFakeInt row_length_raw,
     bool col_subset, 
     JsFakeInt col_offset_raw,
-    JsFakeInt col_length_raw
+    JsFakeInt col_length_raw,
+    bool file_backed,
+    JsFakeInt cache_size_raw,
+    std::string cache_policy,
+    JsFakeInt nthreads_raw
 ) {
-    bool as_integer = force_integer;
-    if (!force_integer) {
-        try {
-            H5::H5File handle(path, H5F_ACC_RDONLY);
-            auto dhandle = handle.openDataSet(name);
-            as_integer = dhandle.getTypeClass() == H5T_INTEGER;
-        } catch (H5::Exception& e) {
-            throw std::runtime_error(e.getCDetailMsg());
+    return track_storage([&]() -> NumericMatrix {
+        const auto nthreads = js2int<int>(nthreads_raw);
+        bool as_integer = force_integer;
+        if (!force_integer) {
+            try {
+                H5::H5File handle(path, H5F_ACC_RDONLY);
+                auto dhandle = handle.openDataSet(name);
+                as_integer = dhandle.getTypeClass() == H5T_INTEGER;
+            } catch (H5::Exception& e) {
+                throw std::runtime_error(e.getCDetailMsg());
+            }
+        }
+
+        if (file_backed) {
+            const auto policy = translate_file_cache_policy(cache_policy);
+            try {
+                std::shared_ptr<const tatami::NumericMatrix> mat;
+                if (as_integer) {
+                    mat = create_file_backed_dense<std::int32_t>(path, name, trans, cache_size_raw, policy);
+                } else if (float32) {
+                    mat = create_file_backed_dense<float>(path, name, trans, cache_size_raw, policy);
+                } else {
+                    mat = create_file_backed_dense<double>(path, name, trans, cache_size_raw, policy);
+                }
+                auto layout = std::make_shared<DenseChunkLayout>(path, name, trans);
+                return finalize_file_backed(std::move(mat), std::move(layout), policy, row_subset, row_offset_raw, row_length_raw, col_subset, col_offset_raw, col_length_raw);
+            } catch (H5::Exception& e) {
+                throw std::runtime_error(e.getCDetailMsg());
+            }
         }
+
+        if (as_integer) {
+            return initialize_from_hdf5_dense_internal<std::int32_t>(
+                path,
+                name,
+                trans,
+                sparse,
+                layered,
+                false,
+                row_subset,
+                row_offset_raw,
+                row_length_raw,
+                col_subset,
+                col_offset_raw,
+                col_length_raw,
+                nthreads
+            );
+        } else {
+            return initialize_from_hdf5_dense_internal<double>(
+                path,
+                name,
+                trans,
+                sparse,
+                false,
+                float32,
+                row_subset,
+                row_offset_raw,
+                row_length_raw,
+                col_subset,
+                col_offset_raw,
+                col_length_raw,
+                nthreads
+            );
+        }
+    });
+}
+
+// When subsetting on the primary dimension of a compressed sparse matrix
+// (i.e., columns of a CSC matrix or rows of a CSR matrix), we read 'indptr'
+// once and only read the ranges of 'data' and 'indices' for the selected
+// primary elements. Ranges that are adjacent in the file are coalesced into
+// a single hyperslab, and all hyperslabs are read in one call per dataset.
+template<typename Type_>
+std::shared_ptr<tatami::Matrix<Type_, MatrixIndex> > load_primary_subset_from_hdf5(
+    const std::string& path, 
+    const std::string& data_name, 
+    const std::string& indices_name, 
+    const std::string& indptr_name, 
+    MatrixIndex nr,
+    MatrixIndex nc,
+    bool csc,
+    const std::int32_t* subset,
+    std::size_t subset_length
+) {
+    const auto nprimary = (csc ? nc : nr);
+    const auto nsecondary = (csc ? nr : nc);
+    if (csc) {
+        check_subset_indices<false>(subset, subset_length, nprimary);
+    } else {
+        check_subset_indices<true>(subset, subset_length, nprimary);
     }
 
-    if (as_integer) {
-        return initialize_from_hdf5_dense_internal<std::int32_t>(
-            path,
-            name,
-            trans,
-            sparse,
-            layered,
-            row_subset,
-            row_offset_raw,
-            row_length_raw,
-            col_subset,
-            col_offset_raw,
-            col_length_raw
-        );
+    H5::H5File handle(path, H5F_ACC_RDONLY);
+    auto phandle = handle.openDataSet(indptr_name);
+    auto pspace = phandle.getSpace();
+    if (pspace.getSimpleExtentNdims() != 1) {
+        throw std::runtime_error("'" + indptr_name + "' should be a 1-dimensional dataset");
+    }
+    hsize_t plen;
+    pspace.getSimpleExtentDims(&plen);
+    if (plen != static_cast<hsize_t>(nprimary) + 1) {
+        throw std::runtime_error("length of '" + indptr_name + "' should be equal to the number of " + (csc ? std::string("columns") : std::string("rows")) + " plus 1");
+    }
+    auto indptr = sanisizer::create<std::vector<hsize_t> >(plen);
+    phandle.read(indptr.data(), H5::PredType::NATIVE_HSIZE);
+
+    // Collecting the unique primary indices in increasing order, which is the order in which HDF5 returns the hyperslabs.
+    std::vector<std::int32_t> unique(subset, subset + subset_length);
+    const bool sorted_unique = std::adjacent_find(unique.begin(), unique.end(), [](std::int32_t l, std::int32_t r) -> bool { return l >= r; }) == unique.end();
+    if (!sorted_unique) {
+        std::sort(unique.begin(), unique.end());
+        unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+    }
+
+    auto dhandle = handle.openDataSet(data_name);
+    auto ihandle = handle.openDataSet(indices_name);
+    auto fspace = dhandle.getSpace();
+    fspace.selectNone();
+
+    auto loaded_ptrs = sanisizer::create<std::vector<std::size_t> >(sanisizer::sum<std::size_t>(unique.size(), 1));
+    hsize_t total = 0;
+    for (std::size_t u = 0, nunique = unique.size(); u < nunique; ) {
+        const hsize_t start = indptr[unique[u]];
+        hsize_t end = indptr[unique[u] + 1];
+        if (end < start) {
+            throw std::runtime_error("'" + indptr_name + "' should be non-decreasing");
+        }
+        loaded_ptrs[u + 1] = loaded_ptrs[u] + (end - start);
+        ++u;
+
+        // Coalescing with subsequent primary elements that are contiguous in the file.
+        while (u < nunique && indptr[unique[u]] == end) {
+            const hsize_t next_end = indptr[unique[u] + 1];
+            if (next_end < end) {
+                throw std::runtime_error("'" + indptr_name + "' should be non-decreasing");
+            }
+            loaded_ptrs[u + 1] = loaded_ptrs[u] + (next_end - end);
+            end = next_end;
+            ++u;
+        }
+
+        const hsize_t count = end - start;
+        if (count) {
+            fspace.selectHyperslab(H5S_SELECT_OR, &count, &start);
+            total += count;
+        }
+    }
+
+    auto values = sanisizer::create<std::vector<Type_> >(total);
+    auto indices = sanisizer::create<std::vector<MatrixIndex> >(total);
+    if (total) {
+        H5::DataSpace mspace(1, &total);
+        if constexpr(std::is_same<Type_, double>::value) {
+            dhandle.read(values.data(), H5::PredType::NATIVE_DOUBLE, mspace, fspace);
+        } else {
+            dhandle.read(values.data(), H5::PredType::NATIVE_INT32, mspace, fspace);
+        }
+        ihandle.read(indices.data(), H5::PredType::NATIVE_INT32, mspace, fspace);
+    }
+
+    for (auto i : indices) {
+        if (i < 0 || i >= nsecondary) {
+            throw std::runtime_error("out-of-range values in '" + indices_name + "'");
+        }
+    }
+
+    // Rearranging the loaded primary elements in the order requested by the caller, if it was not already sorted and unique.
+    std::vector<std::size_t> pointers;
+    if (sorted_unique) {
+        pointers = std::move(loaded_ptrs);
     } else {
-        return initialize_from_hdf5_dense_internal<double>(
-            path,
-            name,
-            trans,
-            sparse,
-            false,
-            row_subset,
-            row_offset_raw,
-            row_length_raw,
-            col_subset,
-            col_offset_raw,
-            col_length_raw
-        );
+        pointers.resize(sanisizer::sum<std::size_t>(subset_length, 1));
+        for (std::size_t s = 0; s < subset_length; ++s) {
+            const auto u = std::lower_bound(unique.begin(), unique.end(), subset[s]) - unique.begin();
+            pointers[s + 1] = pointers[s] + (loaded_ptrs[u + 1] - loaded_ptrs[u]);
+        }
+
+        auto reordered_values = sanisizer::create<std::vector<Type_> >(pointers.back());
+        auto reordered_indices = sanisizer::create<std::vector<MatrixIndex> >(pointers.back());
+        for (std::size_t s = 0; s < subset_length; ++s) {
+            const auto u = std::lower_bound(unique.begin(), unique.end(), subset[s]) - unique.begin();
+            std::copy(values.begin() + loaded_ptrs[u], values.begin() + loaded_ptrs[u + 1], reordered_values.begin() + pointers[s]);
+            std::copy(indices.begin() + loaded_ptrs[u], indices.begin() + loaded_ptrs[u + 1], reordered_indices.begin() + pointers[s]);
+        }
+        values.swap(reordered_values);
+        indices.swap(reordered_indices);
+    }
+
+    const MatrixIndex nsubset = subset_length;
+    return std::make_shared<tatami::CompressedSparseMatrix<Type_, MatrixIndex, std::vector<Type_>, std::vector<MatrixIndex>, std::vector<std::size_t> > >(
+        (csc ? nr : nsubset),
+        (csc ? nsubset : nc),
+        std::move(values),
+        std::move(indices),
+        std::move(pointers),
+        !csc
+    );
+}
+
+// With multiple threads, the bottleneck in loading a compressed sparse matrix
+// is the inflation of the chunks of 'data' and 'indices', which HDF5 performs
+// serially. Here, we read the raw chunks directly from the file and inflate
+// them in parallel, see hdf5_chunks.h. Returns a null pointer if either
+// dataset uses a layout or filter that we don't support, in which case the
+// caller should fall back to the HDF5 library.
+template<typename Value_, typename Stored_>
+std::shared_ptr<tatami::Matrix<Value_, MatrixIndex> > load_compressed_sparse_parallel(
+    const std::string& path, 
+    const std::string& data_name, 
+    const std::string& indices_name, 
+    const std::string& indptr_name, 
+    MatrixIndex nr,
+    MatrixIndex nc,
+    bool csc,
+    int nthreads
+) {
+    const auto nprimary = (csc ? nc : nr);
+    const auto nsecondary = (csc ? nr : nc);
+
+    H5::H5File handle(path, H5F_ACC_RDONLY);
+    ChunkedDatasetLayout data_layout, index_layout;
+    if (!inspect_chunked_dataset(handle, handle.openDataSet(data_name), data_layout)) {
+        return nullptr;
+    }
+    if (!inspect_chunked_dataset(handle, handle.openDataSet(indices_name), index_layout)) {
+        return nullptr;
+    }
+    if (data_layout.extent != index_layout.extent) {
+        throw std::runtime_error("'" + data_name + "' and '" + indices_name + "' should have the same length");
+    }
+
+    auto phandle = handle.openDataSet(indptr_name);
+    auto pspace = phandle.getSpace();
+    hsize_t plen = 0;
+    if (pspace.getSimpleExtentNdims() == 1) {
+        pspace.getSimpleExtentDims(&plen);
+    }
+    if (plen != static_cast<hsize_t>(nprimary) + 1) {
+        throw std::runtime_error("length of '" + indptr_name + "' should be equal to the number of " + (csc ? std::string("columns") : std::string("rows")) + " plus 1");
+    }
+    auto pointers = sanisizer::create<std::vector<std::size_t> >(plen);
+    phandle.read(pointers.data(), H5::PredType::NATIVE_HSIZE);
+    if (pointers.front() != 0 || pointers.back() != data_layout.extent) {
+        throw std::runtime_error("first and last values of '" + indptr_name + "' should be 0 and the length of '" + data_name + "'");
+    }
+    if (std::adjacent_find(pointers.begin(), pointers.end(), [](std::size_t l, std::size_t r) -> bool { return l > r; }) != pointers.end()) {
+        throw std::runtime_error("'" + indptr_name + "' should be non-decreasing");
+    }
+
+    auto values = sanisizer::create<std::vector<Stored_> >(data_layout.extent);
+    read_chunked_dataset_parallel(path, data_layout, values.data(), nthreads);
+    auto indices = sanisizer::create<std::vector<MatrixIndex> >(index_layout.extent);
+    read_chunked_dataset_parallel(path, index_layout, indices.data(), nthreads);
+
+    for (auto i : indices) {
+        if (i < 0 || i >= nsecondary) {
+            throw std::runtime_error("out-of-range values in '" + indices_name + "'");
+        }
     }
+
+    return std::make_shared<tatami::CompressedSparseMatrix<Value_, MatrixIndex, std::vector<Stored_>, std::vector<MatrixIndex>, std::vector<std::size_t> > >(
+        nr,
+        nc,
+        std::move(values),
+        std::move(indices),
+        std::move(pointers),
+        !csc
+    );
 }
 
 template<typename Type_>
@@ -244,23 +567,55 @@ NumericMatrix initialize_from_hdf5_sparse_internal(
     JsFakeInt nc_raw,
     bool csc,
     bool layered, 
+    bool float32,
     bool row_subset, 
     JsFakeInt row_offset_raw, 
     JsFakeInt row_length_raw,
     bool col_subset, 
     JsFakeInt col_offset_raw,
-    JsFakeInt col_length_raw
+    JsFakeInt col_length_raw,
+    int nthreads
 ) {
     NumericMatrix output;
     const auto nr = js2int<MatrixIndex>(nr_raw);
     const auto nc = js2int<MatrixIndex>(nc_raw);
 
     try {
+        // Only the secondary subset remains to be applied after pushing down the primary subset.
+        if (csc ? col_subset : row_subset) {
+            const auto offset_ptr = reinterpret_cast<const std::int32_t*>(js2int<std::uintptr_t>(csc ? col_offset_raw : row_offset_raw));
+            const auto length = js2int<std::size_t>(csc ? col_length_raw : row_length_raw);
+            auto mat = load_primary_subset_from_hdf5<Type_>(path, data_name, indices_name, indptr_name, nr, nc, csc, offset_ptr, length);
+            if (csc) {
+                return apply_post_processing(std::move(mat), true, layered, float32, row_subset, row_offset_raw, row_length_raw, false, 0, 0, nthreads);
+            } else {
+                return apply_post_processing(std::move(mat), true, layered, float32, false, 0, 0, col_subset, col_offset_raw, col_length_raw, nthreads);
+            }
+        }
+
+        // The parallel loader holds the entire matrix in memory, so we only
+        // use it when its result can be returned directly. Otherwise, the
+        // layered or transposed copy would double the peak memory usage.
+        if (nthreads > 1 && !layered && !csc && !row_subset && !col_subset) {
+            std::shared_ptr<const tatami::NumericMatrix> direct;
+            if (float32) {
+                direct = load_compressed_sparse_parallel<MatrixValue, float>(path, data_name, indices_name, indptr_name, nr, nc, csc, nthreads);
+            } else {
+                direct = load_compressed_sparse_parallel<MatrixValue, Type_>(path, data_name, indices_name, indptr_name, nr, nc, csc, nthreads);
+            }
+            if (direct) {
+                return NumericMatrix(std::move(direct));
+            }
+        }
+
         std::shared_ptr<tatami::Matrix<Type_, std::int32_t> > mat;
         if (!layered && !csc && !row_subset && !col_subset) {
             // Don't do the same with CSC matrices; there is an implicit
             // expectation that all instances of this function prefer row matrices,
             // and if we did it with CSC, we'd get a column-major matrix instead.
+            if (float32) {
+                return NumericMatrix(tatami_hdf5::load_compressed_sparse_matrix<MatrixValue, MatrixIndex, std::vector<float> >(nr, nc, path, data_name, indices_name, indptr_name, true));
+            }
             mat = tatami_hdf5::load_compressed_sparse_matrix<Type_, std::int32_t, std::vector<Type_> >(nr, nc, path, data_name, indices_name, indptr_name, true);
         } else {
             mat.reset(new tatami_hdf5::CompressedSparseMatrix<Type_, std::int32_t>(nr, nc, path, data_name, indices_name, indptr_name, !csc));
@@ -270,12 +625,14 @@ NumericMatrix initialize_from_hdf5_sparse_internal(
             std::move(mat),
             true,
             layered, 
+            float32,
             row_subset, 
             row_offset_raw, 
             row_length_raw, 
             col_subset, 
             col_offset_raw, 
-            col_length_raw
+            col_length_raw,
+            nthreads
         );
 
     } catch (H5::Exception& e) {
@@ -295,58 +652,457 @@ NumericMatrix js_initialize_from_hdf5_sparse(
     bool csc,
     bool force_integer, 
     bool layered,
+    bool float32,
     bool row_subset, 
     JsFakeInt row_offset_raw, 
     JsFakeInt row_length_raw,
     bool col_subset, 
     JsFakeInt col_offset_raw,
-    JsFakeInt col_length_raw
+    JsFakeInt col_length_raw,
+    bool file_backed,
+    JsFakeInt cache_size_raw,
+    std::string cache_policy,
+    JsFakeInt nthreads_raw
 ) {
-    bool as_integer = force_integer;
-    if (!force_integer) {
-        try {
-            H5::H5File handle(path, H5F_ACC_RDONLY);
+    return track_storage([&]() -> NumericMatrix {
+        const auto nthreads = js2int<int>(nthreads_raw);
+        bool as_integer = force_integer;
+        if (!force_integer) {
+            try {
+                H5::H5File handle(path, H5F_ACC_RDONLY);
+                auto dhandle = handle.openDataSet(data_name);
+                as_integer = dhandle.getTypeClass() == H5T_INTEGER;
+            } catch (H5::Exception& e) {
+                throw std::runtime_error(e.getCDetailMsg());
+            }
+        }
+
+        if (file_backed) {
+            const auto nr = js2int<MatrixIndex>(nr_raw);
+            const auto nc = js2int<MatrixIndex>(nc_raw);
+            const auto policy = translate_file_cache_policy(cache_policy);
+            try {
+                std::shared_ptr<const tatami::NumericMatrix> mat;
+                if (as_integer) {
+                    mat = create_file_backed_sparse<std::int32_t>(path, data_name, indices_name, indptr_name, nr, nc, csc, cache_size_raw, policy);
+                } else if (float32) {
+                    mat = create_file_backed_sparse<float>(path, data_name, indices_name, indptr_name, nr, nc, csc, cache_size_raw, policy);
+                } else {
+                    mat = create_file_backed_sparse<double>(path, data_name, indices_name, indptr_name, nr, nc, csc, cache_size_raw, policy);
+                }
+                auto layout = std::make_shared<SparseChunkLayout>(path, data_name, indices_name, indptr_name, csc);
+                return finalize_file_backed(std::move(mat), std::move(layout), policy, row_subset, row_offset_raw, row_length_raw, col_subset, col_offset_raw, col_length_raw);
+            } catch (H5::Exception& e) {
+                throw std::runtime_error(e.getCDetailMsg());
+            }
+        }
+
+        if (as_integer) {
+            return initialize_from_hdf5_sparse_internal<std::int32_t>(
+                path,
+                data_name,
+                indices_name,
+                indptr_name,
+                nr_raw,
+                nc_raw,
+                csc,
+                layered,
+                false,
+                row_subset,
+                row_offset_raw,
+                row_length_raw,
+                col_subset,
+                col_offset_raw,
+                col_length_raw,
+                nthreads
+            );
+        } else {
+            return initialize_from_hdf5_sparse_internal<double>(
+                path,
+                data_name,
+                indices_name,
+                indptr_name,
+                nr_raw,
+                nc_raw,
+                csc,
+                false,
+                float32,
+                row_subset,
+                row_offset_raw,
+                row_length_raw,
+                col_subset,
+                col_offset_raw,
+                col_length_raw,
+                nthreads
+            );
+        }
+    });
+}
+
+/**********************************/
+
+// Block size for passes through the 'data' and 'indices' datasets that do
+// not need to hold the entire dataset in memory.
+constexpr hsize_t hdf5_block_size = 1000000;
+
+template<typename Type_>
+void read_hdf5_block(const H5::DataSet& dhandle, hsize_t start, hsize_t count, Type_* buffer, const H5::PredType& type) {
+    auto fspace = dhandle.getSpace();
+    fspace.selectHyperslab(H5S_SELECT_SET, &count, &start);
+    H5::DataSpace mspace(1, &count);
+    dhandle.read(buffer, type, mspace, fspace);
+}
+
+// Computes the number of non-zero elements (or the sum of values) in each
+// column, to identify the columns to be loaded before loading the matrix.
+// For CSC matrices, the number of non-zero elements only requires 'indptr'.
+// Otherwise, 'data' and/or 'indices' are read in blocks to cap memory usage.
+void js_compute_hdf5_sparse_column_totals(
+    std::string path, 
+    std::string data_name, 
+    std::string indices_name, 
+    std::string indptr_name, 
+    JsFakeInt nc_raw,
+    bool csc,
+    bool use_sums,
+    JsFakeInt output_raw
+) {
+    const auto nc = js2int<MatrixIndex>(nc_raw);
+    const auto output = reinterpret_cast<double*>(js2int<std::uintptr_t>(output_raw));
+    std::fill_n(output, nc, 0);
+
+    try {
+        H5::H5File handle(path, H5F_ACC_RDONLY);
+        if (csc) {
+            auto phandle = handle.openDataSet(indptr_name);
+            auto pspace = phandle.getSpace();
+            hsize_t plen = 0;
+            if (pspace.getSimpleExtentNdims() == 1) {
+                pspace.getSimpleExtentDims(&plen);
+            }
+            if (plen != static_cast<hsize_t>(nc) + 1) {
+                throw std::runtime_error("length of '" + indptr_name + "' should be equal to the number of columns plus 1");
+            }
+            auto indptr = sanisizer::create<std::vector<hsize_t> >(plen);
+            phandle.read(indptr.data(), H5::PredType::NATIVE_HSIZE);
+            if (std::adjacent_find(indptr.begin(), indptr.end(), [](hsize_t l, hsize_t r) -> bool { return l > r; }) != indptr.end()) {
+                throw std::runtime_error("'" + indptr_name + "' should be non-decreasing");
+            }
+
+            if (!use_sums) {
+                for (MatrixIndex c = 0; c < nc; ++c) {
+                    output[c] = indptr[c + 1] - indptr[c];
+                }
+                return;
+            }
+
+            // Each block of 'data' covers one or more (partial) columns.
             auto dhandle = handle.openDataSet(data_name);
-            as_integer = dhandle.getTypeClass() == H5T_INTEGER;
-        } catch (H5::Exception& e) {
-            throw std::runtime_error(e.getCDetailMsg());
+            const hsize_t total = indptr.back();
+            std::vector<double> buffer(std::min(total, hdf5_block_size));
+            MatrixIndex c = 0;
+            for (hsize_t start = 0; start < total; start += hdf5_block_size) {
+                const hsize_t count = std::min(hdf5_block_size, total - start);
+                read_hdf5_block(dhandle, start, count, buffer.data(), H5::PredType::NATIVE_DOUBLE);
+                for (hsize_t i = 0; i < count; ++i) {
+                    const hsize_t pos = start + i;
+                    while (indptr[c + 1] <= pos) {
+                        ++c;
+                    }
+                    output[c] += buffer[i];
+                }
+            }
+
+        } else {
+            auto ihandle = handle.openDataSet(indices_name);
+            auto ispace = ihandle.getSpace();
+            hsize_t total = 0;
+            if (ispace.getSimpleExtentNdims() == 1) {
+                ispace.getSimpleExtentDims(&total);
+            }
+
+            std::optional<H5::DataSet> dhandle;
+            if (use_sums) {
+                dhandle = handle.openDataSet(data_name);
+            }
+
+            std::vector<MatrixIndex> ibuffer(std::min(total, hdf5_block_size));
+            std::vector<double> dbuffer(use_sums ? ibuffer.size() : 0);
+            for (hsize_t start = 0; start < total; start += hdf5_block_size) {
+                const hsize_t count = std::min(hdf5_block_size, total - start);
+                read_hdf5_block(ihandle, start, count, ibuffer.data(), H5::PredType::NATIVE_INT32);
+                if (use_sums) {
+                    read_hdf5_block(*dhandle, start, count, dbuffer.data(), H5::PredType::NATIVE_DOUBLE);
+                }
+                for (hsize_t i = 0; i < count; ++i) {
+                    const auto col = ibuffer[i];
+                    if (col < 0 || col >= nc) {
+                        throw std::runtime_error("out-of-range values in '" + indices_name + "'");
+                    }
+                    output[col] += (use_sums ? dbuffer[i] : 1);
+                }
+            }
         }
+
+    } catch (H5::Exception& e) {
+        throw std::runtime_error(e.getCDetailMsg());
     }
+}
 
-    if (as_integer) {
-        return initialize_from_hdf5_sparse_internal<std::int32_t>(
-            path,
-            data_name,
-            indices_name,
-            indptr_name,
-            nr_raw,
-            nc_raw,
-            csc,
-            layered,
-            row_subset,
-            row_offset_raw,
-            row_length_raw,
-            col_subset,
-            col_offset_raw,
-            col_length_raw
-        );
+/**********************************/
+
+// Splits a compressed sparse matrix into one matrix per modality, based on a
+// code for each row (negative codes indicate that the row should be
+// discarded). We first count the non-zero elements in each modality, and
+// then build each modality in turn from blocked reads of 'data' and
+// 'indices', so that only one modality's arrays are held in memory at any
+// time; the combined matrix is never loaded.
+class ModalityMatrices {
+public:
+    ModalityMatrices(std::vector<NumericMatrix> matrices) : my_matrices(std::move(matrices)) {}
+
+private:
+    std::vector<NumericMatrix> my_matrices;
+
+public:
+    JsFakeInt js_num_modalities() const {
+        return int2js(my_matrices.size());
+    }
+
+    NumericMatrix js_matrix(JsFakeInt i_raw) const {
+        const auto i = js2int<std::size_t>(i_raw);
+        if (i >= my_matrices.size()) {
+            throw std::runtime_error("modality index is out of range");
+        }
+        return my_matrices[i];
+    }
+};
+
+// Calls 'fun' on each position, value and index in [first, last) of 'data'
+// and 'indices', reading them in blocks. If 'dhandle' is NULL, only the
+// indices are read and the supplied values are undefined.
+template<typename Type_, class Function_>
+void scan_hdf5_sparse_range(
+    const H5::DataSet* dhandle,
+    const H5::DataSet& ihandle,
+    hsize_t first,
+    hsize_t last,
+    std::vector<Type_>& dbuffer,
+    std::vector<MatrixIndex>& ibuffer,
+    Function_ fun
+) {
+    for (hsize_t start = first; start < last; start += hdf5_block_size) {
+        const hsize_t count = std::min(hdf5_block_size, last - start);
+        if (dhandle) {
+            if constexpr(std::is_same<Type_, double>::value) {
+                read_hdf5_block(*dhandle, start, count, dbuffer.data(), H5::PredType::NATIVE_DOUBLE);
+            } else {
+                read_hdf5_block(*dhandle, start, count, dbuffer.data(), H5::PredType::NATIVE_INT32);
+            }
+        }
+        read_hdf5_block(ihandle, start, count, ibuffer.data(), H5::PredType::NATIVE_INT32);
+        for (hsize_t i = 0; i < count; ++i) {
+            fun(start + i, dbuffer[i], ibuffer[i]);
+        }
+    }
+}
+
+template<typename Type_>
+std::vector<NumericMatrix> split_hdf5_sparse_by_modality(
+    const std::string& path, 
+    const std::string& data_name, 
+    const std::string& indices_name, 
+    const std::string& indptr_name, 
+    MatrixIndex nr,
+    MatrixIndex nc,
+    bool csc,
+    const std::int32_t* codes,
+    std::size_t nmodalities,
+    const std::uint8_t* dense,
+    bool layered,
+    bool float32,
+    int nthreads
+) {
+    // Remapping each row to its position in its modality.
+    std::vector<MatrixIndex> remapped(nr), modality_nrow(nmodalities);
+    for (MatrixIndex r = 0; r < nr; ++r) {
+        const auto m = codes[r];
+        if (m >= 0) {
+            if (static_cast<std::size_t>(m) >= nmodalities) {
+                throw std::runtime_error("modality codes should be less than the number of modalities");
+            }
+            remapped[r] = modality_nrow[m];
+            ++modality_nrow[m];
+        }
+    }
+
+    const auto nprimary = (csc ? nc : nr);
+    const auto nsecondary = (csc ? nr : nc);
+
+    H5::H5File handle(path, H5F_ACC_RDONLY);
+    auto phandle = handle.openDataSet(indptr_name);
+    auto pspace = phandle.getSpace();
+    hsize_t plen = 0;
+    if (pspace.getSimpleExtentNdims() == 1) {
+        pspace.getSimpleExtentDims(&plen);
+    }
+    if (plen != static_cast<hsize_t>(nprimary) + 1) {
+        throw std::runtime_error("length of '" + indptr_name + "' should be equal to the number of " + (csc ? std::string("columns") : std::string("rows")) + " plus 1");
+    }
+    auto indptr = sanisizer::create<std::vector<hsize_t> >(plen);
+    phandle.read(indptr.data(), H5::PredType::NATIVE_HSIZE);
+    if (indptr.front() != 0 || std::adjacent_find(indptr.begin(), indptr.end(), [](hsize_t l, hsize_t r) -> bool { return l > r; }) != indptr.end()) {
+        throw std::runtime_error("'" + indptr_name + "' should be non-decreasing and start from zero");
+    }
+
+    auto dhandle = handle.openDataSet(data_name);
+    auto ihandle = handle.openDataSet(indices_name);
+    const hsize_t total = indptr.back();
+    std::vector<Type_> dbuffer(std::min(total, hdf5_block_size));
+    std::vector<MatrixIndex> ibuffer(dbuffer.size());
+
+    // Counting the non-zero elements in each primary element of each
+    // modality. For CSR matrices, this is already available from 'indptr',
+    // but for CSC matrices, we need to scan through the row indices.
+    std::vector<std::vector<std::size_t> > pointers(nmodalities);
+    for (std::size_t m = 0; m < nmodalities; ++m) {
+        pointers[m].resize(sanisizer::sum<std::size_t>(csc ? nc : modality_nrow[m], 1));
+    }
+    if (csc) {
+        MatrixIndex p = 0;
+        scan_hdf5_sparse_range<Type_>(NULL, ihandle, 0, total, dbuffer, ibuffer, [&](hsize_t pos, Type_, MatrixIndex s) -> void {
+            while (indptr[p + 1] <= pos) {
+                ++p;
+            }
+            if (s < 0 || s >= nsecondary) {
+                throw std::runtime_error("out-of-range values in '" + indices_name + "'");
+            }
+            const auto m = codes[s];
+            if (m >= 0) {
+                ++(pointers[m][p + 1]);
+            }
+        });
     } else {
-        return initialize_from_hdf5_sparse_internal<double>(
-            path,
-            data_name,
-            indices_name,
-            indptr_name,
-            nr_raw,
-            nc_raw,
-            csc,
-            false,
-            row_subset,
-            row_offset_raw,
-            row_length_raw,
-            col_subset,
-            col_offset_raw,
-            col_length_raw
+        for (MatrixIndex r = 0; r < nr; ++r) {
+            const auto m = codes[r];
+            if (m >= 0) {
+                pointers[m][remapped[r] + 1] = indptr[r + 1] - indptr[r];
+            }
+        }
+    }
+
+    // Filling all modalities in a single pass through 'data' and 'indices',
+    // using the counts to allocate exactly-sized arrays for each modality.
+    std::vector<std::vector<Type_> > values(nmodalities);
+    std::vector<std::vector<MatrixIndex> > indices(nmodalities);
+    for (std::size_t m = 0; m < nmodalities; ++m) {
+        auto& curptrs = pointers[m];
+        for (std::size_t j = 1, end = curptrs.size(); j < end; ++j) {
+            curptrs[j] += curptrs[j - 1];
+        }
+        values[m].reserve(curptrs.back());
+        indices[m].reserve(curptrs.back());
+    }
+
+    if (csc) {
+        // Elements are visited in column order, so they are already in the right order for each modality.
+        scan_hdf5_sparse_range(&dhandle, ihandle, 0, total, dbuffer, ibuffer, [&](hsize_t, Type_ val, MatrixIndex s) -> void {
+            const auto m = codes[s];
+            if (m >= 0) {
+                values[m].push_back(val);
+                indices[m].push_back(remapped[s]);
+            }
+        });
+
+    } else {
+        // Only reading the runs of consecutive rows that are retained in any modality.
+        MatrixIndex r = 0;
+        while (r < nr) {
+            if (codes[r] < 0) {
+                ++r;
+                continue;
+            }
+            const auto run_start = r;
+            while (r < nr && codes[r] >= 0) {
+                ++r;
+            }
+            MatrixIndex current = run_start;
+            scan_hdf5_sparse_range(&dhandle, ihandle, indptr[run_start], indptr[r], dbuffer, ibuffer, [&](hsize_t pos, Type_ val, MatrixIndex s) -> void {
+                while (indptr[current + 1] <= pos) {
+                    ++current;
+                }
+                if (s < 0 || s >= nsecondary) {
+                    throw std::runtime_error("out-of-range values in '" + indices_name + "'");
+                }
+                const auto m = codes[current];
+                values[m].push_back(val);
+                indices[m].push_back(s);
+            });
+        }
+    }
+
+    // Realizing each modality in turn, releasing its arrays before moving onto the next.
+    std::vector<NumericMatrix> output;
+    output.reserve(nmodalities);
+    for (std::size_t m = 0; m < nmodalities; ++m) {
+        // Constructing the temporary matrix outside of track_storage(), so that its release doesn't offset the tracked storage.
+        tatami::CompressedSparseMatrix<Type_, MatrixIndex, std::vector<Type_>, std::vector<MatrixIndex>, std::vector<std::size_t> > mat(
+            modality_nrow[m],
+            nc,
+            std::move(values[m]),
+            std::move(indices[m]),
+            std::move(pointers[m]),
+            !csc
         );
+        output.push_back(track_storage([&]() -> NumericMatrix {
+            if (dense[m]) {
+                return dense_from_tatami(mat, float32, nthreads);
+            } else {
+                return sparse_from_tatami(mat, layered, float32, nthreads);
+            }
+        }));
+    }
+
+    return output;
+}
+
+ModalityMatrices js_initialize_from_hdf5_sparse_by_modality(
+    std::string path, 
+    std::string data_name, 
+    std::string indices_name, 
+    std::string indptr_name, 
+    JsFakeInt nr_raw,
+    JsFakeInt nc_raw,
+    bool csc,
+    JsFakeInt codes_raw,
+    JsFakeInt nmodalities_raw,
+    JsFakeInt dense_raw,
+    bool force_integer, 
+    bool layered,
+    bool float32,
+    JsFakeInt nthreads_raw
+) {
+    const auto nr = js2int<MatrixIndex>(nr_raw);
+    const auto nc = js2int<MatrixIndex>(nc_raw);
+    const auto codes = reinterpret_cast<const std::int32_t*>(js2int<std::uintptr_t>(codes_raw));
+    const auto nmodalities = js2int<std::size_t>(nmodalities_raw);
+    const auto dense = reinterpret_cast<const std::uint8_t*>(js2int<std::uintptr_t>(dense_raw));
+    const auto nthreads = js2int<int>(nthreads_raw);
+
+    try {
+        bool as_integer = force_integer;
+        if (!force_integer) {
+            H5::H5File handle(path, H5F_ACC_RDONLY);
+            as_integer = handle.openDataSet(data_name).getTypeClass() == H5T_INTEGER;
+        }
+
+        if (as_integer) {
+            return ModalityMatrices(split_hdf5_sparse_by_modality<std::int32_t>(path, data_name, indices_name, indptr_name, nr, nc, csc, codes, nmodalities, dense, layered, false, nthreads));
+        } else {
+            return ModalityMatrices(split_hdf5_sparse_by_modality<double>(path, data_name, indices_name, indptr_name, nr, nc, csc, codes, nmodalities, dense, false, float32, nthreads));
+        }
+    } catch (H5::Exception& e) {
+        throw std::runtime_error(e.getCDetailMsg());
     }
 }
 
@@ -355,4 +1111,11 @@ EMSCRIPTEN_BINDINGS(read_hdf5_matrix) {
     emscripten::function("extract_hdf5_matrix_details", &js_extract_hdf5_matrix_details, emscripten::return_value_policy::take_ownership());
     emscripten::function("initialize_from_hdf5_dense", &js_initialize_from_hdf5_dense, emscripten::return_value_policy::take_ownership());
     emscripten::function("initialize_from_hdf5_sparse", &js_initialize_from_hdf5_sparse, emscripten::return_value_policy::take_ownership());
+    emscripten::function("compute_hdf5_sparse_column_totals", &js_compute_hdf5_sparse_column_totals, emscripten::return_value_policy::take_ownership());
+    emscripten::function("initialize_from_hdf5_sparse_by_modality", &js_initialize_from_hdf5_sparse_by_modality, emscripten::return_value_policy::take_ownership());
+
+    emscripten::class_<ModalityMatrices>("ModalityMatrices")
+        .function("num_modalities", &ModalityMatrices::js_num_modalities, emscripten::return_value_policy::take_ownership())
+        .function("matrix", &ModalityMatrices::js_matrix, emscripten::return_value_policy::take_ownership())
+        ;
 }
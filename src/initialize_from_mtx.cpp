@@ -2,21 +2,90 @@
 #include <emscripten/bind.h>
 
 #include <cstdint>
+#include <cstdio>
 #include <cstddef>
+#include <cstring>
 #include <string>
+#include <memory>
+#include <vector>
 #include <stdexcept>
+#include <algorithm>
 
 #include "utils.h"
 #include "read_utils.h"
 #include "NumericMatrix.h"
+#include "mtx_utils.h"
+#include "mtx_gzip.h"
 
 #include "tatami_mtx/tatami_mtx.hpp"
 #include "tatami_layered/tatami_layered.hpp"
 #include "eminem/eminem.hpp"
 
-NumericMatrix js_initialize_from_mtx_buffer(JsFakeInt buffer_raw, JsFakeInt size_raw, std::string compression, bool layered) {
-    const auto size = js2int<std::size_t>(size_raw);
-    unsigned char* bufptr = reinterpret_cast<unsigned char*>(js2int<std::uintptr_t>(buffer_raw));
+bool is_gzip_magic(const unsigned char* buffer, std::size_t size) {
+    return size >= 2 && buffer[0] == 0x1f && buffer[1] == 0x8b;
+}
+
+// Zlib streams start with a 2-byte header where the compression method is
+// Deflate and the header is a multiple of 31, see RFC 1950.
+bool is_zlib_header(const unsigned char* buffer, std::size_t size) {
+    return size >= 2 && (buffer[0] & 0x0f) == 8 && (buffer[0] >> 4) <= 7 && ((static_cast<unsigned>(buffer[0]) << 8) | buffer[1]) % 31 == 0;
+}
+
+bool is_mtx_banner(const unsigned char* buffer, std::size_t size) {
+    constexpr char banner[] = "%%MatrixMarket";
+    constexpr std::size_t nbanner = sizeof(banner) - 1;
+    return size >= nbanner && std::memcmp(buffer, banner, nbanner) == 0;
+}
+
+// Mask lengths are negative if the subsets were not supplied as boolean masks.
+MtxSubset create_mtx_subset(
+    bool row_subset,
+    JsFakeInt row_offset_raw,
+    JsFakeInt row_length_raw,
+    JsFakeInt row_mask_length_raw,
+    bool col_subset,
+    JsFakeInt col_offset_raw,
+    JsFakeInt col_length_raw,
+    JsFakeInt col_mask_length_raw
+) {
+    MtxSubset subset;
+    if (row_subset) {
+        subset.use_rows = true;
+        subset.rows = reinterpret_cast<const std::int32_t*>(js2int<std::uintptr_t>(row_offset_raw));
+        subset.num_rows = js2int<std::size_t>(row_length_raw);
+        if (row_mask_length_raw >= 0) {
+            subset.row_mask_length = js2int<std::size_t>(row_mask_length_raw);
+        }
+    }
+    if (col_subset) {
+        subset.use_columns = true;
+        subset.columns = reinterpret_cast<const std::int32_t*>(js2int<std::uintptr_t>(col_offset_raw));
+        subset.num_columns = js2int<std::size_t>(col_length_raw);
+        if (col_mask_length_raw >= 0) {
+            subset.column_mask_length = js2int<std::size_t>(col_mask_length_raw);
+        }
+    }
+    return subset;
+}
+
+// Fallback for files that are not supported by our parser, where we have to
+// load the full matrix with the library parsers before subsetting it.
+NumericMatrix subset_mtx_after_loading(NumericMatrix full, const MtxSubset& subset, bool layered) {
+    std::shared_ptr<const tatami::NumericMatrix> mat = full.ptr();
+    if (subset.use_rows) {
+        check_subset_mask_length<true>(subset.row_mask_length, mat->nrow());
+        check_subset_indices<true>(subset.rows, subset.num_rows, mat->nrow());
+        mat = tatami::make_DelayedSubset(std::move(mat), std::vector<std::int32_t>(subset.rows, subset.rows + subset.num_rows), true);
+    }
+    if (subset.use_columns) {
+        check_subset_mask_length<false>(subset.column_mask_length, mat->ncol());
+        check_subset_indices<false>(subset.columns, subset.num_columns, mat->ncol());
+        mat = tatami::make_DelayedSubset(std::move(mat), std::vector<std::int32_t>(subset.columns, subset.columns + subset.num_columns), false);
+    }
+    return sparse_from_tatami(*mat, layered, false);
+}
+
+NumericMatrix load_mtx_buffer_with_library(unsigned char* bufptr, std::size_t size, const std::string& compression, bool layered) {
     if (layered) {
         if (compression == "none") {
             return NumericMatrix(tatami_layered::read_layered_sparse_from_matrix_market_text_buffer<MatrixValue, MatrixIndex>(bufptr, size));
@@ -41,7 +110,88 @@ NumericMatrix js_initialize_from_mtx_buffer(JsFakeInt buffer_raw, JsFakeInt size
     }
 }
 
-NumericMatrix js_initialize_from_mtx_file(std::string path, std::string compression, bool layered) {
+NumericMatrix js_initialize_from_mtx_buffer(
+    JsFakeInt buffer_raw,
+    JsFakeInt size_raw,
+    std::string compression,
+    bool layered,
+    bool row_subset,
+    JsFakeInt row_offset_raw,
+    JsFakeInt row_length_raw,
+    JsFakeInt row_mask_length_raw,
+    bool col_subset,
+    JsFakeInt col_offset_raw,
+    JsFakeInt col_length_raw,
+    JsFakeInt col_mask_length_raw,
+    JsFakeInt nthreads_raw
+) {
+    return track_storage([&]() -> NumericMatrix {
+        const auto size = js2int<std::size_t>(size_raw);
+        unsigned char* bufptr = reinterpret_cast<unsigned char*>(js2int<std::uintptr_t>(buffer_raw));
+        const auto nthreads = js2int<int>(nthreads_raw);
+        const auto subset = create_mtx_subset(row_subset, row_offset_raw, row_length_raw, row_mask_length_raw, col_subset, col_offset_raw, col_length_raw, col_mask_length_raw);
+
+        // The library only detects Gzip for unknown compression, so we check for Zlib ourselves.
+        if (compression == "unknown" && is_zlib_header(bufptr, size)) {
+            compression = "gzip";
+        }
+
+        // We use our own parser when parallelizing or when subsetting, as the
+        // latter allows us to drop unwanted triplets before they are stored.
+        if (nthreads > 1 || subset.active()) {
+            // For unknown compression, we only use our own parsers if we can recognize the format;
+            // anything else is left to the library's automatic detection.
+            if (compression == "none" || (compression == "unknown" && is_mtx_banner(bufptr, size))) {
+                // Uncompressed buffers can be parsed in parallel by splitting them at line boundaries.
+                const char* text = reinterpret_cast<const char*>(bufptr);
+                MtxHeader header;
+                const auto body_offset = parse_mtx_header(text, text + size, header);
+                if (body_offset && header.supported) {
+                    return parse_mtx_text_buffer_parallel(text, size, header, body_offset, subset, layered, std::max(nthreads, 1));
+                }
+
+            } else if (compression == "gzip" || (compression == "unknown" && is_gzip_magic(bufptr, size))) {
+                // BGZF members can be inflated in parallel, otherwise we overlap the inflation with the parsing.
+                std::vector<BgzfBlock> blocks;
+                NumericMatrix output;
+                if (nthreads > 1 && find_bgzf_blocks(bufptr, size, blocks)) {
+                    if (load_mtx_bgzf_batched(bufptr, blocks, subset, layered, nthreads, output)) {
+                        return output;
+                    }
+                } else if (nthreads > 1) {
+                    BufferSource source(bufptr, size);
+                    if (load_mtx_gzip_pipelined(source, subset, layered, nthreads, output)) {
+                        return output;
+                    }
+                } else {
+                    BufferSource source(bufptr, size);
+                    if (load_mtx_serial(source, true, subset, layered, nthreads, output)) {
+                        return output;
+                    }
+                }
+            }
+        }
+
+        auto output = load_mtx_buffer_with_library(bufptr, size, compression, layered);
+        if (subset.active()) {
+            output = subset_mtx_after_loading(std::move(output), subset, layered);
+        }
+        return output;
+    });
+}
+
+bool is_gzip_file(const std::string& path) {
+    unsigned char magic[2];
+    auto handle = std::fopen(path.c_str(), "rb");
+    if (!handle) {
+        return false;
+    }
+    const auto n = std::fread(magic, 1, 2, handle);
+    std::fclose(handle);
+    return is_gzip_magic(magic, n);
+}
+
+NumericMatrix load_mtx_file_with_library(const std::string& path, const std::string& compression, bool layered) {
     if (layered) {
         if (compression == "none") {
             return NumericMatrix(tatami_layered::read_layered_sparse_from_matrix_market_text_file<MatrixValue, MatrixIndex>(path.c_str()));
@@ -66,6 +216,181 @@ NumericMatrix js_initialize_from_mtx_file(std::string path, std::string compress
     }
 }
 
+NumericMatrix js_initialize_from_mtx_file(
+    std::string path,
+    std::string compression,
+    bool layered,
+    bool row_subset,
+    JsFakeInt row_offset_raw,
+    JsFakeInt row_length_raw,
+    JsFakeInt row_mask_length_raw,
+    bool col_subset,
+    JsFakeInt col_offset_raw,
+    JsFakeInt col_length_raw,
+    JsFakeInt col_mask_length_raw,
+    JsFakeInt nthreads_raw
+) {
+    return track_storage([&]() -> NumericMatrix {
+        const auto nthreads = js2int<int>(nthreads_raw);
+        const auto subset = create_mtx_subset(row_subset, row_offset_raw, row_length_raw, row_mask_length_raw, col_subset, col_offset_raw, col_length_raw, col_mask_length_raw);
+
+        if (nthreads > 1 || subset.active()) {
+            const bool compressed = (compression == "gzip" || (compression == "unknown" && is_gzip_file(path)));
+            NumericMatrix output;
+            if (compressed && nthreads > 1) {
+                FileSource source(path.c_str());
+                if (load_mtx_gzip_pipelined(source, subset, layered, nthreads, output)) {
+                    return output;
+                }
+            } else if (subset.active() && (compressed || compression == "none" || compression == "unknown")) {
+                FileSource source(path.c_str());
+                if (load_mtx_serial(source, compressed, subset, layered, nthreads, output)) {
+                    return output;
+                }
+            }
+        }
+
+        auto output = load_mtx_file_with_library(path, compression, layered);
+        if (subset.active()) {
+            output = subset_mtx_after_loading(std::move(output), subset, layered);
+        }
+        return output;
+    });
+}
+
+// Stateful loader for MatrixMarket files that arrive in pieces, e.g., from a
+// ReadableStream in the browser. Only the current piece and the partial
+// line at its end need to be resident, along with the parsed triplets.
+class MtxStreamLoader {
+public:
+    MtxStreamLoader(
+        std::string compression,
+        bool layered,
+        bool row_subset,
+        JsFakeInt row_offset_raw,
+        JsFakeInt row_length_raw,
+        JsFakeInt row_mask_length_raw,
+        bool col_subset,
+        JsFakeInt col_offset_raw,
+        JsFakeInt col_length_raw,
+        JsFakeInt col_mask_length_raw,
+        JsFakeInt nthreads_raw
+    ) :
+        my_compression(std::move(compression)),
+        my_layered(layered),
+        my_nthreads(js2int<int>(nthreads_raw))
+    {
+        if (my_compression != "none" && my_compression != "gzip" && my_compression != "unknown") {
+            throw std::runtime_error("unknown compression '" + my_compression + "'");
+        }
+
+        // Copying the indices as the JS-side arrays may be freed before the stream is finished.
+        auto subset = create_mtx_subset(row_subset, row_offset_raw, row_length_raw, row_mask_length_raw, col_subset, col_offset_raw, col_length_raw, col_mask_length_raw);
+        if (subset.use_rows) {
+            my_row_subset.insert(my_row_subset.end(), subset.rows, subset.rows + subset.num_rows);
+            subset.rows = my_row_subset.data();
+        }
+        if (subset.use_columns) {
+            my_col_subset.insert(my_col_subset.end(), subset.columns, subset.columns + subset.num_columns);
+            subset.columns = my_col_subset.data();
+        }
+        my_parser = MtxChunkParser(subset);
+    }
+
+    // The parser refers to our copies of the subset indices.
+    MtxStreamLoader(const MtxStreamLoader&) = delete;
+    MtxStreamLoader& operator=(const MtxStreamLoader&) = delete;
+
+private:
+    std::string my_compression;
+    bool my_layered;
+    int my_nthreads;
+    bool my_finished = false;
+    std::vector<std::int32_t> my_row_subset, my_col_subset;
+
+    std::vector<unsigned char> my_pending;
+    std::unique_ptr<GzipInflater> my_inflater;
+    std::vector<char> my_chunk;
+    MtxChunkParser my_parser;
+
+    void parse(const char* start, const char* end) {
+        if (!my_parser.add(start, end)) {
+            throw std::runtime_error("streaming is only supported for general coordinate MatrixMarket files");
+        }
+    }
+
+    void process(const unsigned char* ptr, std::size_t len) {
+        if (my_compression == "unknown") {
+            // Waiting until we have enough bytes to check the magic number.
+            my_pending.insert(my_pending.end(), ptr, ptr + len);
+            if (my_pending.size() < 2) {
+                return;
+            }
+            // Uncompressed files start with the '%%MatrixMarket' banner, anything else is assumed to be Gzip or Zlib.
+            my_compression = (my_pending[0] == '%' && !is_gzip_magic(my_pending.data(), my_pending.size()) ? "none" : "gzip");
+            auto pending = std::move(my_pending);
+            process(pending.data(), pending.size());
+            return;
+        }
+
+        if (my_compression == "gzip") {
+            if (!my_inflater) {
+                my_inflater.reset(new GzipInflater(1 << 20));
+            }
+            my_inflater->push(
+                ptr,
+                len,
+                [&]() -> std::vector<char> { return std::move(my_chunk); },
+                [&](std::vector<char> chunk) -> bool {
+                    parse(chunk.data(), chunk.data() + chunk.size());
+                    my_chunk = std::move(chunk);
+                    return true;
+                }
+            );
+        } else {
+            auto text = reinterpret_cast<const char*>(ptr);
+            parse(text, text + len);
+        }
+    }
+
+public:
+    void js_feed(JsFakeInt buffer_raw, JsFakeInt size_raw) {
+        if (my_finished) {
+            throw std::runtime_error("cannot feed more data after finish() is called");
+        }
+        const auto size = js2int<std::size_t>(size_raw);
+        const auto bufptr = reinterpret_cast<const unsigned char*>(js2int<std::uintptr_t>(buffer_raw));
+        process(bufptr, size);
+    }
+
+    NumericMatrix js_finish() {
+        if (my_finished) {
+            throw std::runtime_error("finish() has already been called");
+        }
+        my_finished = true;
+
+        if (my_compression == "unknown") {
+            my_compression = "none";
+            auto pending = std::move(my_pending);
+            process(pending.data(), pending.size());
+        }
+        if (my_inflater) {
+            my_inflater->finish();
+            my_inflater.reset();
+        }
+        my_chunk = std::vector<char>();
+        my_parser.finish();
+
+        // The triplets already exist on the heap and are freed during the
+        // conversion, so we add them back to get the size of the storage.
+        const auto start = heap_usage().live + my_parser.triplet_bytes();
+        auto output = my_parser.create_matrix(my_layered, my_nthreads);
+        const auto end = heap_usage().live;
+        output.add_storage(end > start ? end - start : 0);
+        return output;
+    }
+};
+
 emscripten::val get_preamble(std::unique_ptr<byteme::PerByteSerial<char> > input) {
     eminem::Parser<I<decltype(input)> > parser(std::move(input), {});
     parser.scan_preamble();
@@ -111,4 +436,10 @@ EMSCRIPTEN_BINDINGS(read_matrix_market) {
     emscripten::function("initialize_from_mtx_file", &js_initialize_from_mtx_file, emscripten::return_value_policy::take_ownership());
     emscripten::function("read_header_from_mtx_buffer", &js_read_header_from_mtx_buffer, emscripten::return_value_policy::take_ownership());
     emscripten::function("read_header_from_mtx_file", &js_read_header_from_mtx_file, emscripten::return_value_policy::take_ownership());
+
+    emscripten::class_<MtxStreamLoader>("MtxStreamLoader")
+        .constructor<std::string, bool, bool, JsFakeInt, JsFakeInt, JsFakeInt, bool, JsFakeInt, JsFakeInt, JsFakeInt, JsFakeInt>()
+        .function("feed", &MtxStreamLoader::js_feed, emscripten::return_value_policy::take_ownership())
+        .function("finish", &MtxStreamLoader::js_finish, emscripten::return_value_policy::take_ownership())
+        ;
 }
@@ -59,7 +59,7 @@ NumericMatrix convert_ordinary_array_to_sparse_matrix(const Vector_* obj, bool l
     auto dims = fetch_array_dimensions(obj);
     tatami::ArrayView view(obj->data.data(), obj->data.size());
     tatami::DenseColumnMatrix<Type_, MatrixIndex, I<decltype(view)> > raw(dims.first, dims.second, std::move(view));
-    return sparse_from_tatami(raw, layered);
+    return sparse_from_tatami(raw, layered, false);
 }
 
 template<typename Type_>
@@ -117,7 +117,7 @@ NumericMatrix convert_dgCMatrix_to_sparse_matrix(rds2cpp::S4Object* obj, bool la
         std::move(pview)
     );
 
-    return sparse_from_tatami(mat, layered);
+    return sparse_from_tatami(mat, layered, false);
 }
 
 template<typename Type_>
@@ -177,48 +177,50 @@ NumericMatrix convert_dgTMatrix_to_sparse_matrix(rds2cpp::S4Object* obj, bool la
         std::move(p)
     );
 
-    return sparse_from_tatami(mat, layered);
+    return sparse_from_tatami(mat, layered, false);
 }
 
 NumericMatrix js_initialize_from_rds(JsFakeInt ptr_raw, bool force_integer, bool layered) {
-    RdsObject* wrapper = reinterpret_cast<RdsObject*>(js2int<std::uintptr_t>(ptr_raw));
-    auto obj = wrapper->ptr();
+    return track_storage([&]() -> NumericMatrix {
+        RdsObject* wrapper = reinterpret_cast<RdsObject*>(js2int<std::uintptr_t>(ptr_raw));
+        auto obj = wrapper->ptr();
 
-    if (obj->type() == rds2cpp::SEXPType::INT) {
-        auto ivec = static_cast<const rds2cpp::IntegerVector*>(obj);
-        return convert_ordinary_array_to_sparse_matrix<std::int32_t>(ivec, layered);
-    }
+        if (obj->type() == rds2cpp::SEXPType::INT) {
+            auto ivec = static_cast<const rds2cpp::IntegerVector*>(obj);
+            return convert_ordinary_array_to_sparse_matrix<std::int32_t>(ivec, layered);
+        }
 
-    if (obj->type() == rds2cpp::SEXPType::REAL) {
-        auto dvec = static_cast<const rds2cpp::DoubleVector*>(obj);
-        if (force_integer) {
-            return convert_ordinary_array_to_sparse_matrix<std::int32_t>(dvec, layered);
-        } else {
-            return convert_ordinary_array_to_sparse_matrix<double>(dvec, false);
+        if (obj->type() == rds2cpp::SEXPType::REAL) {
+            auto dvec = static_cast<const rds2cpp::DoubleVector*>(obj);
+            if (force_integer) {
+                return convert_ordinary_array_to_sparse_matrix<std::int32_t>(dvec, layered);
+            } else {
+                return convert_ordinary_array_to_sparse_matrix<double>(dvec, false);
+            }
         }
-    }
 
-    if (obj->type() != rds2cpp::SEXPType::S4) {
-        throw std::runtime_error("RDS file must contain an ordinary array or an S4 class");
-    }
+        if (obj->type() != rds2cpp::SEXPType::S4) {
+            throw std::runtime_error("RDS file must contain an ordinary array or an S4 class");
+        }
 
-    auto s4 = static_cast<rds2cpp::S4Object*>(const_cast<rds2cpp::RObject*>(obj));
-    if (s4->class_name == "dgCMatrix") {
+        auto s4 = static_cast<rds2cpp::S4Object*>(const_cast<rds2cpp::RObject*>(obj));
+        if (s4->class_name == "dgCMatrix") {
+            if (force_integer) {
+                return convert_dgCMatrix_to_sparse_matrix<std::int32_t>(s4, layered);
+            } else {
+                return convert_dgCMatrix_to_sparse_matrix<double>(s4, false);
+            }
+        }
+
+        if (s4->class_name != "dgTMatrix") {
+            throw std::runtime_error("S4 object in an RDS file must be a dgTMatrix");
+        }
         if (force_integer) {
-            return convert_dgCMatrix_to_sparse_matrix<std::int32_t>(s4, layered);
+            return convert_dgTMatrix_to_sparse_matrix<std::int32_t>(s4, layered); 
         } else {
-            return convert_dgCMatrix_to_sparse_matrix<double>(s4, false);
+            return convert_dgTMatrix_to_sparse_matrix<double>(s4, false);
         }
-    }
-
-    if (s4->class_name != "dgTMatrix") {
-        throw std::runtime_error("S4 object in an RDS file must be a dgTMatrix");
-    }
-    if (force_integer) {
-        return convert_dgTMatrix_to_sparse_matrix<std::int32_t>(s4, layered); 
-    } else {
-        return convert_dgTMatrix_to_sparse_matrix<double>(s4, false);
-    }
+    });
 }
 
 EMSCRIPTEN_BINDINGS(initialize_from_rds) {
@@ -1,20 +1,245 @@
 #include <emscripten/bind.h>
 
 #include "NumericMatrix.h"
+#include "matrix_stats.h"
 #include "utils.h"
 
 #include "tatami_stats/tatami_stats.hpp"
 
 #include <vector>
+#include <algorithm>
+#include <limits>
 #include <cstdint>
 #include <cstddef>
 
 void js_matrix_sums(const NumericMatrix& mat, bool row, JsFakeInt buffer_raw, JsFakeInt nthreads_raw) {
-    tatami_stats::sums::Options opt;
-    opt.num_threads = js2int<int>(nthreads_raw);
-    tatami_stats::sums::apply(row, *(mat.ptr()), reinterpret_cast<double*>(js2int<std::uintptr_t>(buffer_raw)), opt);
+    matrix_sums(mat, row, reinterpret_cast<double*>(js2int<std::uintptr_t>(buffer_raw)), js2int<int>(nthreads_raw));
+}
+
+// Output buffers for each statistic, or NULL if the statistic is not
+// requested. Each buffer has length equal to the product of the number of
+// groups and the extent of the target dimension, where the statistics for
+// group 'g' start at 'g * extent'.
+struct MatrixStatsBuffers {
+    double* sums = NULL;
+    double* means = NULL;
+    double* variances = NULL;
+    double* detected = NULL;
+    double* mins = NULL;
+    double* maxs = NULL;
+    double* medians = NULL;
+};
+
+// Computes all requested statistics in a single pass through the matrix, so
+// that each row/column only needs to be extracted once. This is especially
+// helpful for file-backed matrices or those with deep delayed operations.
+template<bool sparse_>
+void compute_matrix_stats(
+    const tatami::NumericMatrix& mat,
+    bool row,
+    const std::int32_t* groups,
+    std::size_t ngroups,
+    const MatrixStatsBuffers& buffers,
+    int nthreads
+) {
+    const MatrixIndex dim = (row ? mat.nrow() : mat.ncol());
+    const MatrixIndex otherdim = (row ? mat.ncol() : mat.nrow());
+
+    auto group_sizes = sanisizer::create<std::vector<MatrixIndex> >(ngroups);
+    if (groups) {
+        for (MatrixIndex j = 0; j < otherdim; ++j) {
+            ++(group_sizes[groups[j]]);
+        }
+    } else {
+        group_sizes[0] = otherdim;
+    }
+
+    // Offsets into a buffer where the values are arranged by group, for the medians.
+    auto group_starts = sanisizer::create<std::vector<MatrixIndex> >(ngroups);
+    for (std::size_t g = 1; g < ngroups; ++g) {
+        group_starts[g] = group_starts[g - 1] + group_sizes[g - 1];
+    }
+
+    const bool need_variance = buffers.variances != NULL;
+    const bool need_mean = need_variance || buffers.means != NULL;
+    const bool need_sum = need_mean || buffers.sums != NULL;
+    const bool need_range = buffers.mins != NULL || buffers.maxs != NULL;
+    const bool need_median = buffers.medians != NULL;
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+
+    auto group_of = [&](MatrixIndex j) -> std::size_t {
+        return (groups ? groups[j] : 0);
+    };
+
+    tatami::parallelize([&](int, MatrixIndex start, MatrixIndex length) -> void {
+        auto ext = tatami::consecutive_extractor<sparse_>(mat, row, start, length);
+        auto vbuffer = sanisizer::create<std::vector<double> >(otherdim);
+        std::vector<MatrixIndex> ibuffer;
+        if constexpr(sparse_) {
+            sanisizer::resize(ibuffer, otherdim);
+        }
+
+        auto sums = sanisizer::create<std::vector<double> >(ngroups);
+        auto means = sanisizer::create<std::vector<double> >(ngroups);
+        auto variances = sanisizer::create<std::vector<double> >(ngroups);
+        auto nonzeros = sanisizer::create<std::vector<MatrixIndex> >(ngroups);
+        auto mins = sanisizer::create<std::vector<double> >(ngroups);
+        auto maxs = sanisizer::create<std::vector<double> >(ngroups);
+        auto stored = sanisizer::create<std::vector<MatrixIndex> >(ngroups);
+        std::vector<double> work;
+        if (need_median) {
+            sanisizer::resize(work, otherdim);
+        }
+
+        for (MatrixIndex i = start, end = start + length; i < end; ++i) {
+            const double* vptr;
+            const MatrixIndex* iptr = NULL;
+            MatrixIndex number;
+            if constexpr(sparse_) {
+                auto range = ext->fetch(i, vbuffer.data(), ibuffer.data());
+                vptr = range.value;
+                iptr = range.index;
+                number = range.number;
+            } else {
+                vptr = ext->fetch(i, vbuffer.data());
+                number = otherdim;
+            }
+
+            std::fill(sums.begin(), sums.end(), 0);
+            std::fill(variances.begin(), variances.end(), 0);
+            std::fill(nonzeros.begin(), nonzeros.end(), 0);
+            std::fill(mins.begin(), mins.end(), std::numeric_limits<double>::infinity());
+            std::fill(maxs.begin(), maxs.end(), -std::numeric_limits<double>::infinity());
+            std::fill(stored.begin(), stored.end(), 0);
+
+            for (MatrixIndex k = 0; k < number; ++k) {
+                const auto g = group_of(sparse_ ? iptr[k] : k);
+                const auto val = vptr[k];
+                sums[g] += val;
+                nonzeros[g] += (val != 0);
+                if (need_range) {
+                    mins[g] = std::min(mins[g], val);
+                    maxs[g] = std::max(maxs[g], val);
+                }
+                if (need_median) {
+                    work[group_starts[g] + stored[g]] = val;
+                }
+                ++stored[g];
+            }
+
+            if (need_mean) {
+                for (std::size_t g = 0; g < ngroups; ++g) {
+                    means[g] = (group_sizes[g] ? sums[g] / group_sizes[g] : nan);
+                }
+            }
+
+            if (need_variance) {
+                // Second pass over the extracted values, which is more accurate than using the sum of squares.
+                for (MatrixIndex k = 0; k < number; ++k) {
+                    const auto g = group_of(sparse_ ? iptr[k] : k);
+                    const auto delta = vptr[k] - means[g];
+                    variances[g] += delta * delta;
+                }
+            }
+
+            for (std::size_t g = 0; g < ngroups; ++g) {
+                const auto offset = sanisizer::product_unsafe<std::size_t>(g, dim) + i;
+                const auto gsize = group_sizes[g];
+
+                if (buffers.sums) {
+                    buffers.sums[offset] = sums[g];
+                }
+                if (buffers.means) {
+                    buffers.means[offset] = means[g];
+                }
+                if (buffers.variances) {
+                    if (gsize < 2) {
+                        buffers.variances[offset] = nan;
+                    } else {
+                        // Adding the contribution of the structural zeros, if any.
+                        const auto var = variances[g] + static_cast<double>(gsize - stored[g]) * means[g] * means[g];
+                        buffers.variances[offset] = var / (gsize - 1);
+                    }
+                }
+                if (buffers.detected) {
+                    buffers.detected[offset] = nonzeros[g];
+                }
+                if (need_range) {
+                    double gmin = nan, gmax = nan;
+                    if (gsize) {
+                        gmin = mins[g];
+                        gmax = maxs[g];
+                        if (stored[g] < gsize) {
+                            gmin = std::min(gmin, 0.0);
+                            gmax = std::max(gmax, 0.0);
+                        }
+                    }
+                    if (buffers.mins) {
+                        buffers.mins[offset] = gmin;
+                    }
+                    if (buffers.maxs) {
+                        buffers.maxs[offset] = gmax;
+                    }
+                }
+                if (buffers.medians) {
+                    if (gsize == 0) {
+                        buffers.medians[offset] = nan;
+                    } else if constexpr(sparse_) {
+                        buffers.medians[offset] = tatami_stats::medians::direct(work.data() + group_starts[g], stored[g], gsize, false);
+                    } else {
+                        buffers.medians[offset] = tatami_stats::medians::direct(work.data() + group_starts[g], gsize, false);
+                    }
+                }
+            }
+        }
+    }, dim, nthreads);
+}
+
+void js_matrix_stats(
+    const NumericMatrix& mat,
+    bool row,
+    bool use_groups,
+    JsFakeInt groups_raw,
+    JsFakeInt ngroups_raw,
+    JsFakeInt sums_raw,
+    JsFakeInt means_raw,
+    JsFakeInt variances_raw,
+    JsFakeInt detected_raw,
+    JsFakeInt mins_raw,
+    JsFakeInt maxs_raw,
+    JsFakeInt medians_raw,
+    JsFakeInt nthreads_raw
+) {
+    const std::int32_t* groups = NULL;
+    std::size_t ngroups = 1;
+    if (use_groups) {
+        groups = reinterpret_cast<const std::int32_t*>(js2int<std::uintptr_t>(groups_raw));
+        ngroups = js2int<std::size_t>(ngroups_raw);
+    }
+
+    // Zero offsets indicate that the statistic was not requested.
+    auto to_buffer = [](JsFakeInt raw) -> double* {
+        return reinterpret_cast<double*>(js2int<std::uintptr_t>(raw));
+    };
+    MatrixStatsBuffers buffers;
+    buffers.sums = to_buffer(sums_raw);
+    buffers.means = to_buffer(means_raw);
+    buffers.variances = to_buffer(variances_raw);
+    buffers.detected = to_buffer(detected_raw);
+    buffers.mins = to_buffer(mins_raw);
+    buffers.maxs = to_buffer(maxs_raw);
+    buffers.medians = to_buffer(medians_raw);
+
+    const auto& ptr = mat.ptr();
+    const auto nthreads = js2int<int>(nthreads_raw);
+    if (ptr->sparse()) {
+        compute_matrix_stats<true>(*ptr, row, groups, ngroups, buffers, nthreads);
+    } else {
+        compute_matrix_stats<false>(*ptr, row, groups, ngroups, buffers, nthreads);
+    }
 }
 
 EMSCRIPTEN_BINDINGS(matrix_stats) {
     emscripten::function("matrix_sums", &js_matrix_sums, emscripten::return_value_policy::take_ownership());
+    emscripten::function("matrix_stats", &js_matrix_stats, emscripten::return_value_policy::take_ownership());
 }
@@ -0,0 +1,14 @@
+#ifndef MATRIX_STATS_H
+#define MATRIX_STATS_H
+
+#include "NumericMatrix.h"
+
+#include "tatami_stats/tatami_stats.hpp"
+
+inline void matrix_sums(const NumericMatrix& mat, bool row, double* buffer, int nthreads) {
+    tatami_stats::sums::Options opt;
+    opt.num_threads = nthreads;
+    tatami_stats::sums::apply(row, *(mat.ptr()), buffer, opt);
+}
+
+#endif
@@ -0,0 +1,24 @@
+#include <emscripten/bind.h>
+
+#include "memory_usage.h"
+#include "scratch.h"
+#include "utils.h"
+
+emscripten::val js_heap_usage() {
+    const auto usage = heap_usage();
+    auto output = emscripten::val::object();
+    output.set("live", int2js(usage.live));
+    output.set("fragmented", int2js(usage.fragmented));
+    output.set("peak", int2js(usage.peak));
+    output.set("scratch", int2js(scratch_arena().size()));
+    return output;
+}
+
+JsFakeInt js_release_scratch() {
+    return int2js(scratch_arena().release());
+}
+
+EMSCRIPTEN_BINDINGS(memory_usage) {
+    emscripten::function("heap_usage", &js_heap_usage, emscripten::return_value_policy::take_ownership());
+    emscripten::function("release_scratch", &js_release_scratch, emscripten::return_value_policy::take_ownership());
+}
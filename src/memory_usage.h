@@ -0,0 +1,106 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include <malloc.h>
+
+#ifdef __EMSCRIPTEN__
+#include <unistd.h>
+#include <emscripten/heap.h>
+extern "C" unsigned char __heap_base;
+#endif
+
+// Bytes used by an object, split into those that are only referenced by
+// that object and those that are shared with other objects. The latter
+// are not released when the object is freed.
+struct MemoryUsage {
+    std::size_t owned = 0;
+    std::size_t shared = 0;
+};
+
+template<typename Type_>
+std::size_t vector_bytes(const std::vector<Type_>& x) {
+    return x.capacity() * sizeof(Type_);
+}
+
+template<typename Type_>
+std::size_t nested_vector_bytes(const std::vector<std::vector<Type_> >& x) {
+    std::size_t output = vector_bytes(x);
+    for (const auto& current : x) {
+        output += vector_bytes(current);
+    }
+    return output;
+}
+
+// Statistics from the allocator. 'live' is the number of bytes in
+// allocated blocks; 'fragmented' is the number of bytes in free blocks that
+// are held by the allocator but cannot be returned to the system, as the
+// Wasm heap never shrinks; and 'peak' is the maximum size of the heap
+// obtained by the allocator over the lifetime of the module.
+struct HeapUsage {
+    std::size_t live = 0;
+    std::size_t fragmented = 0;
+    std::size_t peak = 0;
+};
+
+inline HeapUsage heap_usage() {
+    HeapUsage output;
+
+#ifdef __EMSCRIPTEN__
+    // The heap can exceed 4 GiB with MEMORY64, but the mallinfo() fields may
+    // be 32-bit integers that silently wrap. So, we take the allocator's
+    // footprint from the program break, which is exact, and subtract the free
+    // bytes. This is only affected by wrapping if more than 4 GiB is free.
+    auto info = mallinfo();
+    const std::size_t footprint = reinterpret_cast<std::uintptr_t>(sbrk(0)) - reinterpret_cast<std::uintptr_t>(&__heap_base);
+    std::size_t free_bytes;
+    if constexpr(sizeof(info.fordblks) >= sizeof(std::size_t)) {
+        free_bytes = info.fordblks;
+    } else {
+        free_bytes = static_cast<std::make_unsigned_t<decltype(info.fordblks)> >(info.fordblks);
+    }
+    free_bytes = std::min(free_bytes, footprint);
+    output.live = footprint - free_bytes;
+    output.fragmented = free_bytes;
+    output.peak = emscripten_get_heap_size(); // the Wasm heap never shrinks, so its current size is also its peak.
+#else
+    // Native builds (e.g., for benchmarking) use glibc, where mallinfo() is
+    // deprecated in favor of mallinfo2() with size_t fields.
+    auto info = mallinfo2();
+    output.live = info.uordblks + info.hblkhd;
+    output.fragmented = info.fordblks;
+    output.peak = info.arena + info.hblkhd;
+#endif
+
+    return output;
+}
+
+// Measures the number of bytes that were retained in the heap between
+// construction and the call to retained(). This is used to account for
+// the storage of matrices that are loaded by opaque library functions,
+// where we can't directly inspect the sizes of the underlying containers.
+//
+// Note that this is a difference in the global heap usage, so any unrelated
+// allocations or releases in the meantime (e.g., by other threads, or by
+// temporaries that are cached for later use) are also attributed to the
+// tracked object. Callers should only use this around a single-threaded
+// section of code that does nothing but construct the object of interest;
+// results from multi-threaded loaders should be treated as approximate.
+class HeapTracker {
+public:
+    HeapTracker() : my_start(heap_usage().live) {}
+
+    std::size_t retained() const {
+        const auto now = heap_usage().live;
+        return (now > my_start ? now - my_start : 0);
+    }
+
+private:
+    std::size_t my_start;
+};
+
+#endif
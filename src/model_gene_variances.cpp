@@ -1,6 +1,8 @@
 #include <emscripten/bind.h>
 
 #include "NumericMatrix.h"
+#include "format_memory_usage.h"
+#include "model_gene_variances.h"
 #include "utils.h"
 
 #include "scran_variances/scran_variances.hpp"
@@ -20,6 +22,10 @@ public:
     ModelGeneVariancesResults(scran_variances::ModelGeneVariancesBlockedResults<double> store) : my_store_blocked(std::move(store)) {}
 
 private:
+    static std::size_t compute_bytes(const scran_variances::ModelGeneVariancesResults<double>& res) {
+        return vector_bytes(res.means) + vector_bytes(res.variances) + vector_bytes(res.fitted) + vector_bytes(res.residuals);
+    }
+
     const scran_variances::ModelGeneVariancesResults<double>& choose(JsFakeInt b_raw) const {
         if (my_use_blocked) {
             if (b_raw < 0) {
@@ -65,6 +71,19 @@ public:
     bool js_is_blocked() const {
         return my_use_blocked;
     }
+
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        if (my_use_blocked) {
+            usage.owned = compute_bytes(my_store_blocked.average) + vector_bytes(my_store_blocked.per_block);
+            for (const auto& current : my_store_blocked.per_block) {
+                usage.owned += compute_bytes(current);
+            }
+        } else {
+            usage.owned = compute_bytes(my_store_unblocked);
+        }
+        return format_memory_usage(usage);
+    }
 };
 
 ModelGeneVariancesResults js_model_gene_variances(
@@ -75,11 +94,7 @@ ModelGeneVariancesResults js_model_gene_variances(
     std::string weight_policy,
     JsFakeInt nthreads_raw
 ) {
-    scran_variances::ModelGeneVariancesOptions vopt;
-    vopt.fit_variance_trend_options.span = span;
-    vopt.block_weight_policy = translate_block_weight_policy(weight_policy);
-    vopt.num_threads = js2int<int>(nthreads_raw);
-
+    const auto vopt = model_gene_variances_options(span, weight_policy, js2int<int>(nthreads_raw));
     if (use_blocks) {
         const auto blocks = js2int<std::uintptr_t>(blocks_raw);
         auto store = scran_variances::model_gene_variances_blocked(*(mat.ptr()), reinterpret_cast<const std::int32_t*>(blocks), vopt);
@@ -97,15 +112,12 @@ void js_choose_highly_variable_genes(
     JsFakeInt top_raw,
     double bound
 ) {
-    scran_variances::ChooseHighlyVariableGenesOptions copt;
-    copt.top = js2int<std::size_t>(top_raw);
-    copt.use_bound = true;
-    copt.bound = bound;
-    scran_variances::choose_highly_variable_genes(
+    choose_highly_variable_genes(
         js2int<std::size_t>(n_raw),
-        reinterpret_cast<double*>(js2int<std::uintptr_t>(statistics_raw)),
+        reinterpret_cast<const double*>(js2int<std::uintptr_t>(statistics_raw)),
         reinterpret_cast<std::uint8_t*>(js2int<std::uintptr_t>(output_raw)),
-        copt
+        js2int<std::size_t>(top_raw),
+        bound
     );
 }
 
@@ -119,6 +131,7 @@ EMSCRIPTEN_BINDINGS(model_gene_variances) {
         .function("residuals", &ModelGeneVariancesResults::js_residuals, emscripten::return_value_policy::take_ownership())
         .function("num_blocks", &ModelGeneVariancesResults::js_num_blocks, emscripten::return_value_policy::take_ownership())
         .function("is_blocked", &ModelGeneVariancesResults::js_is_blocked, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &ModelGeneVariancesResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 
     emscripten::function("choose_highly_variable_genes", &js_choose_highly_variable_genes, emscripten::return_value_policy::take_ownership());
@@ -0,0 +1,28 @@
+#ifndef MODEL_GENE_VARIANCES_H
+#define MODEL_GENE_VARIANCES_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "utils.h"
+
+#include "scran_variances/scran_variances.hpp"
+
+inline scran_variances::ModelGeneVariancesOptions model_gene_variances_options(double span, const std::string& weight_policy, int nthreads) {
+    scran_variances::ModelGeneVariancesOptions vopt;
+    vopt.fit_variance_trend_options.span = span;
+    vopt.block_weight_policy = translate_block_weight_policy(weight_policy);
+    vopt.num_threads = nthreads;
+    return vopt;
+}
+
+inline void choose_highly_variable_genes(std::size_t n, const double* statistics, std::uint8_t* output, std::size_t top, double bound) {
+    scran_variances::ChooseHighlyVariableGenesOptions copt;
+    copt.top = top;
+    copt.use_bound = true;
+    copt.bound = bound;
+    scran_variances::choose_highly_variable_genes(n, statistics, output, copt);
+}
+
+#endif
@@ -0,0 +1,521 @@
+#ifndef MTX_GZIP_H
+#define MTX_GZIP_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <optional>
+
+#include "zlib.h"
+#include "subpar/subpar.hpp"
+
+#include "mtx_utils.h"
+
+// Bounded queue of inflated chunks, passed from the inflating thread to the
+// parsing thread. Chunks are recycled through a free list so that the
+// resident memory is limited to a fixed number of chunks.
+class InflatedChunkQueue {
+public:
+    InflatedChunkQueue(std::size_t capacity) : my_capacity(capacity) {}
+
+    std::vector<char> take_empty() {
+        std::unique_lock lck(my_mutex);
+        if (my_empty.empty()) {
+            return std::vector<char>();
+        }
+        auto output = std::move(my_empty.back());
+        my_empty.pop_back();
+        return output;
+    }
+
+    // Returns false if the consumer has cancelled the pipeline.
+    bool push(std::vector<char> chunk) {
+        std::unique_lock lck(my_mutex);
+        my_cv.wait(lck, [&]() -> bool { return my_cancelled || my_filled.size() < my_capacity; });
+        if (my_cancelled) {
+            return false;
+        }
+        my_filled.push_back(std::move(chunk));
+        my_cv.notify_all();
+        return true;
+    }
+
+    void finish(std::exception_ptr error) {
+        std::unique_lock lck(my_mutex);
+        my_finished = true;
+        my_error = error;
+        my_cv.notify_all();
+    }
+
+    // Returns false once the producer is finished and all chunks are consumed.
+    bool pop(std::vector<char>& chunk) {
+        std::unique_lock lck(my_mutex);
+        my_cv.wait(lck, [&]() -> bool { return my_finished || !my_filled.empty(); });
+        if (my_filled.empty()) {
+            if (my_error) {
+                std::rethrow_exception(my_error);
+            }
+            return false;
+        }
+        chunk = std::move(my_filled.front());
+        my_filled.pop_front();
+        my_cv.notify_all();
+        return true;
+    }
+
+    void recycle(std::vector<char> chunk) {
+        std::unique_lock lck(my_mutex);
+        my_empty.push_back(std::move(chunk));
+    }
+
+    void cancel() {
+        std::unique_lock lck(my_mutex);
+        my_cancelled = true;
+        my_cv.notify_all();
+    }
+
+private:
+    std::size_t my_capacity;
+    std::mutex my_mutex;
+    std::condition_variable my_cv;
+    std::deque<std::vector<char> > my_filled;
+    std::vector<std::vector<char> > my_empty;
+    bool my_finished = false;
+    bool my_cancelled = false;
+    std::exception_ptr my_error;
+};
+
+// Sources of (possibly compressed) bytes, which are supplied in blocks by next().
+class BufferSource {
+public:
+    BufferSource(const unsigned char* buffer, std::size_t size) : my_buffer(buffer), my_size(size) {}
+
+    // Returns a pointer to the next block of bytes and its length, which is zero at the end.
+    std::pair<const unsigned char*, std::size_t> next() {
+        auto output = std::make_pair(my_buffer, my_size);
+        my_size = 0;
+        return output;
+    }
+
+private:
+    const unsigned char* my_buffer;
+    std::size_t my_size;
+};
+
+class FileSource {
+public:
+    FileSource(const char* path) : my_handle(std::fopen(path, "rb")), my_buffer(1 << 20) {
+        if (!my_handle) {
+            throw std::runtime_error("failed to open file at '" + std::string(path) + "'");
+        }
+    }
+
+    ~FileSource() {
+        std::fclose(my_handle);
+    }
+
+    FileSource(const FileSource&) = delete;
+    FileSource& operator=(const FileSource&) = delete;
+
+    std::pair<const unsigned char*, std::size_t> next() {
+        auto n = std::fread(my_buffer.data(), 1, my_buffer.size(), my_handle);
+        if (n < my_buffer.size() && std::ferror(my_handle)) {
+            throw std::runtime_error("failed to read from the file");
+        }
+        return std::make_pair(my_buffer.data(), n);
+    }
+
+private:
+    std::FILE* my_handle;
+    std::vector<unsigned char> my_buffer;
+};
+
+// Push-based inflation of (possibly concatenated) Gzip members, where the
+// compressed bytes can be supplied in arbitrary pieces. Zlib streams are
+// also accepted, as zlib detects the header of each member automatically.
+class GzipInflater {
+public:
+    GzipInflater(std::size_t chunk_size) : my_chunk_size(chunk_size) {
+        std::memset(&my_strm, 0, sizeof(z_stream));
+        if (inflateInit2(&my_strm, 32 + MAX_WBITS) != Z_OK) {
+            throw std::runtime_error("failed to initialize the zlib stream");
+        }
+    }
+
+    ~GzipInflater() {
+        inflateEnd(&my_strm);
+    }
+
+    GzipInflater(const GzipInflater&) = delete;
+    GzipInflater& operator=(const GzipInflater&) = delete;
+
+    // Calls 'emit(chunk)' on each non-empty inflated chunk, where 'chunk' is
+    // a std::vector<char> obtained from 'get_chunk()'. Inflation stops early
+    // if 'emit' returns false, in which case this function also returns false.
+    template<class GetChunk_, class Emit_>
+    bool push(const unsigned char* input, std::size_t n, GetChunk_ get_chunk, Emit_ emit) {
+        // 'avail_in' is a uInt, so large inputs are supplied in pieces that fit.
+        constexpr std::size_t max_piece = std::numeric_limits<uInt>::max();
+        do {
+            const auto piece = std::min(n, max_piece);
+            if (!push_piece(input, piece, get_chunk, emit)) {
+                return false;
+            }
+            input += piece;
+            n -= piece;
+        } while (n > 0);
+        return true;
+    }
+
+    // Checks that the last member was complete.
+    void finish() const {
+        if (!my_member_done) {
+            throw std::runtime_error("truncated Gzip-compressed MatrixMarket file");
+        }
+    }
+
+private:
+    z_stream my_strm;
+    std::size_t my_chunk_size;
+    bool my_member_done = false;
+
+    template<class GetChunk_, class Emit_>
+    bool push_piece(const unsigned char* input, std::size_t n, GetChunk_& get_chunk, Emit_& emit) {
+        my_strm.next_in = const_cast<Bytef*>(input);
+        my_strm.avail_in = n;
+
+        // Continuing while there is input, or while zlib may be holding more output.
+        do {
+            if (my_member_done) {
+                if (my_strm.avail_in == 0) {
+                    break;
+                }
+                inflateReset(&my_strm); // starting the next member of a multi-member file.
+                my_member_done = false;
+            }
+
+            std::vector<char> chunk = get_chunk();
+            chunk.resize(my_chunk_size);
+            my_strm.next_out = reinterpret_cast<Bytef*>(chunk.data());
+            my_strm.avail_out = my_chunk_size;
+
+            auto ret = inflate(&my_strm, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                my_member_done = true;
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                throw std::runtime_error("failed to inflate the Gzip-compressed MatrixMarket file");
+            }
+
+            const std::size_t produced = my_chunk_size - my_strm.avail_out;
+            if (produced) {
+                chunk.resize(produced);
+                if (!emit(std::move(chunk))) {
+                    return false;
+                }
+            }
+        } while (my_strm.avail_in > 0 || my_strm.avail_out == 0);
+
+        return true;
+    }
+};
+
+// Inflates all compressed bytes from 'source' into chunks of the queue.
+// This is intended to run in its own thread.
+template<class Source_>
+void inflate_into_queue(Source_& source, InflatedChunkQueue& queue, std::size_t chunk_size) {
+    GzipInflater inflater(chunk_size);
+    auto get_chunk = [&]() -> std::vector<char> { return queue.take_empty(); };
+    auto emit = [&](std::vector<char> chunk) -> bool { return queue.push(std::move(chunk)); };
+
+    while (1) {
+        auto next = source.next();
+        if (next.second == 0) {
+            break;
+        }
+        if (!inflater.push(next.first, next.second, get_chunk, emit)) {
+            return;
+        }
+    }
+
+    inflater.finish();
+}
+
+// Parses the inflated chunks as they arrive. Returns false if the header
+// describes a file that is not supported by our parser, in which case the
+// pipeline is cancelled.
+inline bool parse_mtx_from_queue(InflatedChunkQueue& queue, MtxChunkParser& parser) {
+    std::vector<char> chunk;
+    while (queue.pop(chunk)) {
+        if (!parser.add(chunk.data(), chunk.data() + chunk.size())) {
+            queue.cancel();
+            return false;
+        }
+        queue.recycle(std::move(chunk));
+    }
+    parser.finish();
+    return true;
+}
+
+// Overlaps the decompression and parsing of Gzip-compressed MatrixMarket
+// files, by inflating in a separate thread while the current thread parses.
+// Returns false if the file is not supported by our parser.
+template<class Source_>
+bool load_mtx_gzip_pipelined(Source_& source, const MtxSubset& subset, bool layered, int nthreads, NumericMatrix& output) {
+    constexpr std::size_t chunk_size = 1 << 20;
+    InflatedChunkQueue queue(4);
+
+    std::thread inflater([&]() -> void {
+        try {
+            inflate_into_queue(source, queue, chunk_size);
+            queue.finish(nullptr);
+        } catch (...) {
+            queue.finish(std::current_exception());
+        }
+    });
+
+    MtxChunkParser parser(subset);
+    bool supported;
+    try {
+        supported = parse_mtx_from_queue(queue, parser);
+    } catch (...) {
+        queue.cancel();
+        inflater.join();
+        throw;
+    }
+    inflater.join();
+
+    if (supported) {
+        output = parser.create_matrix(layered, nthreads);
+    }
+    return supported;
+}
+
+// Parses a (possibly Gzip-compressed) MatrixMarket file in the current
+// thread. This is used instead of the library parsers when subsets are
+// requested, as we can drop triplets before they are stored.
+// Returns false if the file is not supported by our parser.
+template<class Source_>
+bool load_mtx_serial(Source_& source, bool compressed, const MtxSubset& subset, bool layered, int nthreads, NumericMatrix& output) {
+    MtxChunkParser parser(subset);
+    std::unique_ptr<GzipInflater> inflater;
+    if (compressed) {
+        inflater.reset(new GzipInflater(1 << 20));
+    }
+
+    std::vector<char> chunk;
+    bool supported = true;
+    while (supported) {
+        auto next = source.next();
+        if (next.second == 0) {
+            break;
+        }
+        if (compressed) {
+            inflater->push(
+                next.first,
+                next.second,
+                [&]() -> std::vector<char> { return std::move(chunk); },
+                [&](std::vector<char> inflated) -> bool {
+                    supported = parser.add(inflated.data(), inflated.data() + inflated.size());
+                    chunk = std::move(inflated);
+                    return supported;
+                }
+            );
+        } else {
+            auto text = reinterpret_cast<const char*>(next.first);
+            supported = parser.add(text, text + next.second);
+        }
+    }
+
+    if (!supported) {
+        return false;
+    }
+    if (compressed) {
+        inflater->finish();
+    }
+    parser.finish();
+    output = parser.create_matrix(layered, nthreads);
+    return true;
+}
+
+// Each member of a BGZF file records its compressed size in the 'BC' extra
+// subfield and its uncompressed size in the footer, so all members can be
+// located and inflated in parallel without scanning the compressed stream.
+struct BgzfBlock {
+    std::size_t input_offset, input_size;
+    std::size_t output_offset, output_size;
+};
+
+inline bool find_bgzf_blocks(const unsigned char* buffer, std::size_t size, std::vector<BgzfBlock>& blocks) {
+    std::size_t offset = 0, total = 0;
+    while (offset < size) {
+        const auto ptr = buffer + offset;
+        const auto remaining = size - offset;
+        if (remaining < 18 || ptr[0] != 0x1f || ptr[1] != 0x8b || ptr[2] != 8 || !(ptr[3] & 4)) {
+            return false;
+        }
+        const std::size_t xlen = ptr[10] | (static_cast<std::size_t>(ptr[11]) << 8);
+        if (xlen < 6 || ptr[12] != 'B' || ptr[13] != 'C' || ptr[14] != 2 || ptr[15] != 0) {
+            return false;
+        }
+        const std::size_t bsize = (ptr[16] | (static_cast<std::size_t>(ptr[17]) << 8)) + 1;
+        if (bsize > remaining || bsize < 26) {
+            return false;
+        }
+
+        const auto footer = ptr + bsize - 4;
+        const std::size_t isize = footer[0] | (static_cast<std::size_t>(footer[1]) << 8) | (static_cast<std::size_t>(footer[2]) << 16) | (static_cast<std::size_t>(footer[3]) << 24);
+        if (isize > 65536) {
+            return false;
+        }
+        blocks.push_back(BgzfBlock{ offset, bsize, total, isize });
+        total += isize;
+        offset += bsize;
+    }
+    return !blocks.empty();
+}
+
+// Inflates blocks '[first, last)' in parallel into 'output', which is
+// resized to hold their combined uncompressed size.
+inline void inflate_bgzf_batch(const unsigned char* buffer, const std::vector<BgzfBlock>& blocks, std::size_t first, std::size_t last, std::vector<char>& output, int nthreads) {
+    const auto base = blocks[first].output_offset;
+    output.resize(blocks[last - 1].output_offset + blocks[last - 1].output_size - base);
+
+    subpar::parallelize_range(nthreads, last - first, [&](int, std::size_t start, std::size_t length) -> void {
+        for (auto b = first + start, end = first + start + length; b < end; ++b) {
+            const auto& block = blocks[b];
+            z_stream strm;
+            std::memset(&strm, 0, sizeof(z_stream));
+            if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) {
+                throw std::runtime_error("failed to initialize the zlib stream");
+            }
+            strm.next_in = const_cast<Bytef*>(buffer + block.input_offset);
+            strm.avail_in = block.input_size; // both sizes are at most 64 KiB, as checked by find_bgzf_blocks().
+            strm.next_out = reinterpret_cast<Bytef*>(output.data() + (block.output_offset - base));
+            strm.avail_out = block.output_size;
+            auto ret = inflate(&strm, Z_FINISH);
+            inflateEnd(&strm);
+            if (ret != Z_STREAM_END || strm.avail_out != 0) {
+                throw std::runtime_error("failed to inflate a block of the BGZF-compressed MatrixMarket file");
+            }
+        }
+    });
+}
+
+// Inflates batches of BGZF blocks in parallel in a separate thread, while the
+// current thread parses each batch in parallel. Only a bounded number of
+// batches are resident at any time, rather than the entire inflated file.
+// The threads are split between the inflating and parsing steps so that no
+// more than 'nthreads' are in use at once, including the inflating thread.
+// Returns false if the file is not supported by our parser.
+inline bool load_mtx_bgzf_batched(const unsigned char* buffer, const std::vector<BgzfBlock>& blocks, const MtxSubset& subset, bool layered, int nthreads, NumericMatrix& output) {
+    constexpr std::size_t batch_size = 1 << 24;
+    InflatedChunkQueue queue(2);
+    const int parse_threads = std::max(1, nthreads / 2);
+    const int inflate_threads = std::max(1, nthreads - parse_threads - 1);
+
+    std::thread inflater([&]() -> void {
+        try {
+            const auto nblocks = blocks.size();
+            std::size_t first = 0;
+            while (first < nblocks) {
+                auto last = first + 1;
+                while (last < nblocks && blocks[last].output_offset + blocks[last].output_size - blocks[first].output_offset <= batch_size) {
+                    ++last;
+                }
+                auto chunk = queue.take_empty();
+                inflate_bgzf_batch(buffer, blocks, first, last, chunk, inflate_threads);
+                if (!queue.push(std::move(chunk))) {
+                    break;
+                }
+                first = last;
+            }
+            queue.finish(nullptr);
+        } catch (...) {
+            queue.finish(std::current_exception());
+        }
+    });
+
+    MtxHeader header;
+    std::optional<MtxSelection> selection;
+    auto stores = sanisizer::create<std::vector<MtxTriplets> >(parse_threads);
+    bool supported = true;
+
+    try {
+        // Holds the header until it is complete, and then any partial line at the end of each batch.
+        std::string carry;
+        std::vector<char> chunk;
+        while (queue.pop(chunk)) {
+            const char* start = chunk.data();
+            const char* end = start + chunk.size();
+
+            if (!selection) {
+                carry.insert(carry.end(), start, end);
+                queue.recycle(std::move(chunk));
+                const auto offset = parse_mtx_header(carry.data(), carry.data() + carry.size(), header);
+                if (!offset) {
+                    continue;
+                }
+                if (!header.supported) {
+                    supported = false;
+                    queue.cancel();
+                    break;
+                }
+                selection.emplace(header, subset);
+                chunk.assign(carry.begin() + offset, carry.end());
+                carry.clear();
+                start = chunk.data();
+                end = start + chunk.size();
+            }
+
+            if (!carry.empty()) {
+                auto first_newline = mtx_find_newline(start, end);
+                carry.insert(carry.end(), start, first_newline);
+                if (first_newline == end) {
+                    queue.recycle(std::move(chunk));
+                    continue;
+                }
+                parse_mtx_lines(carry.data(), carry.data() + carry.size(), header, *selection, stores[0]);
+                carry.clear();
+                start = first_newline + 1;
+            }
+
+            auto last_newline = end;
+            while (last_newline > start && last_newline[-1] != '\n') {
+                --last_newline;
+            }
+            parse_mtx_lines_parallel(start, last_newline, header, *selection, stores);
+            carry.insert(carry.end(), last_newline, end);
+            queue.recycle(std::move(chunk));
+        }
+
+        if (supported) {
+            if (!selection) {
+                throw std::runtime_error("failed to find the size line in the MatrixMarket file");
+            }
+            parse_mtx_lines(carry.data(), carry.data() + carry.size(), header, *selection, stores[0]);
+        }
+    } catch (...) {
+        queue.cancel();
+        inflater.join();
+        throw;
+    }
+    inflater.join();
+
+    if (supported) {
+        output = mtx_triplets_to_matrix(header, *selection, stores, layered, nthreads);
+    }
+    return supported;
+}
+
+#endif
@@ -0,0 +1,524 @@
+#ifndef MTX_UTILS_H
+#define MTX_UTILS_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <memory>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <charconv>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include "NumericMatrix.h"
+#include "read_utils.h"
+#include "utils.h"
+
+#include "subpar/subpar.hpp"
+#include "tatami/tatami.hpp"
+
+// Our own parser for the body of a MatrixMarket coordinate file. Unlike the
+// parsers in tatami_mtx and tatami_layered, this operates on arbitrary
+// line-aligned chunks of text, so that the body can be split across threads.
+// Each chunk is parsed into its own triplet store, and all stores are merged
+// into a compressed sparse row matrix at the end. Only general coordinate
+// matrices with integer, real or pattern fields are supported here; callers
+// should fall back to the library parsers for anything else.
+
+enum class MtxField : char { INTEGER, REAL, PATTERN };
+
+struct MtxHeader {
+    bool supported = false;
+    MtxField field = MtxField::INTEGER;
+    MatrixIndex nrows = 0;
+    MatrixIndex ncols = 0;
+    std::size_t nlines = 0;
+};
+
+struct MtxTriplets {
+    std::vector<MatrixIndex> rows;
+    std::vector<MatrixIndex> columns;
+    std::vector<double> values;
+    std::size_t lines = 0; // including those that were dropped by the subset.
+};
+
+// Row and column indices to retain, as supplied by the caller. The indices
+// are not owned by this object and must outlive any parsing.
+// If the indices were derived from a boolean mask on the JS side, the length
+// of the mask is also recorded so that it can be checked against the header.
+struct MtxSubset {
+    bool use_rows = false;
+    const std::int32_t* rows = NULL;
+    std::size_t num_rows = 0;
+    std::optional<std::size_t> row_mask_length;
+
+    bool use_columns = false;
+    const std::int32_t* columns = NULL;
+    std::size_t num_columns = 0;
+    std::optional<std::size_t> column_mask_length;
+
+    bool active() const {
+        return use_rows || use_columns;
+    }
+};
+
+template<bool row_>
+void check_subset_mask_length(const std::optional<std::size_t>& mask_length, MatrixIndex full) {
+    if (mask_length.has_value() && *mask_length != static_cast<std::size_t>(full)) {
+        throw std::runtime_error("length of the " + (row_ ? std::string("row") : std::string("column")) + " mask should be equal to the number of " + (row_ ? std::string("rows") : std::string("columns")));
+    }
+}
+
+// Maps each original index to its position(s) in the subset, so that
+// unsorted and duplicated indices are respected. Indices that are not in the
+// subset are mapped to an empty range, allowing the parser to drop their
+// triplets before they are stored.
+class MtxIndexMap {
+public:
+    MtxIndexMap(MatrixIndex full) : my_extent(full) {}
+
+    MtxIndexMap(MatrixIndex full, const std::int32_t* subset, std::size_t len) :
+        my_active(true),
+        my_extent(sanisizer::cast<MatrixIndex>(len)),
+        my_offsets(sanisizer::sum<std::size_t>(full, 1)),
+        my_targets(len)
+    {
+        for (std::size_t i = 0; i < len; ++i) {
+            ++(my_offsets[subset[i] + 1]);
+        }
+        for (MatrixIndex i = 0; i < full; ++i) {
+            my_offsets[i + 1] += my_offsets[i];
+        }
+        std::vector<std::size_t> fill(my_offsets.begin(), my_offsets.end() - 1);
+        for (std::size_t i = 0; i < len; ++i) {
+            my_targets[fill[subset[i]]++] = i;
+        }
+    }
+
+    bool active() const {
+        return my_active;
+    }
+
+    MatrixIndex extent() const {
+        return my_extent;
+    }
+
+    // Only valid if active() is true.
+    std::pair<const MatrixIndex*, const MatrixIndex*> find(MatrixIndex i) const {
+        const auto base = my_targets.data();
+        return std::make_pair(base + my_offsets[i], base + my_offsets[i + 1]);
+    }
+
+private:
+    bool my_active = false;
+    MatrixIndex my_extent;
+    std::vector<std::size_t> my_offsets;
+    std::vector<MatrixIndex> my_targets;
+};
+
+struct MtxSelection {
+    MtxSelection(const MtxHeader& header, const MtxSubset& subset) :
+        rows(create<true>(header.nrows, subset.use_rows, subset.rows, subset.num_rows, subset.row_mask_length)),
+        columns(create<false>(header.ncols, subset.use_columns, subset.columns, subset.num_columns, subset.column_mask_length))
+    {}
+
+    MtxIndexMap rows, columns;
+
+private:
+    template<bool row_>
+    static MtxIndexMap create(MatrixIndex full, bool use, const std::int32_t* subset, std::size_t len, const std::optional<std::size_t>& mask_length) {
+        if (!use) {
+            return MtxIndexMap(full);
+        }
+        check_subset_mask_length<row_>(mask_length, full);
+        check_subset_indices<row_>(subset, len, full);
+        return MtxIndexMap(full, subset, len);
+    }
+};
+
+inline const char* mtx_skip_blanks(const char* ptr, const char* end) {
+    while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\r')) {
+        ++ptr;
+    }
+    return ptr;
+}
+
+inline const char* mtx_find_newline(const char* ptr, const char* end) {
+    auto found = static_cast<const char*>(std::memchr(ptr, '\n', end - ptr));
+    return (found ? found : end);
+}
+
+template<typename Integer_>
+const char* mtx_parse_integer(const char* ptr, const char* end, Integer_& output) {
+    ptr = mtx_skip_blanks(ptr, end);
+    auto res = std::from_chars(ptr, end, output);
+    if (res.ec != std::errc()) {
+        throw std::runtime_error("failed to parse an integer in the MatrixMarket file");
+    }
+    return res.ptr;
+}
+
+inline const char* mtx_parse_double(const char* ptr, const char* end, double& output) {
+    ptr = mtx_skip_blanks(ptr, end);
+    auto stop = ptr;
+    while (stop < end && *stop != ' ' && *stop != '\t' && *stop != '\r' && *stop != '\n') {
+        ++stop;
+    }
+
+    // strtod() needs a null-terminated string, and the token might be at the very end of the buffer.
+    char token[64];
+    const std::size_t len = stop - ptr;
+    if (len == 0 || len >= sizeof(token)) {
+        throw std::runtime_error("failed to parse a value in the MatrixMarket file");
+    }
+    std::memcpy(token, ptr, len);
+    token[len] = '\0';
+
+    char* tend;
+    output = std::strtod(token, &tend);
+    if (tend != token + len) {
+        throw std::runtime_error("failed to parse a value in the MatrixMarket file");
+    }
+    return stop;
+}
+
+// Parses the banner, comments and size line. Returns the number of bytes up
+// to and including the size line, or zero if the header is incomplete, e.g.,
+// because only the start of the file is available.
+inline std::size_t parse_mtx_header(const char* start, const char* end, MtxHeader& header) {
+    auto ptr = start;
+    bool first = true;
+
+    while (ptr < end) {
+        auto eol = mtx_find_newline(ptr, end);
+        if (eol == end) {
+            return 0;
+        }
+
+        std::string line(ptr, eol);
+        if (first) {
+            if (line.rfind("%%MatrixMarket", 0) != 0) {
+                throw std::runtime_error("MatrixMarket file should start with the '%%MatrixMarket' banner");
+            }
+            std::transform(line.begin(), line.end(), line.begin(), [](unsigned char c) -> char { return std::tolower(c); });
+            header.supported = (line.find(" coordinate") != std::string::npos && line.find(" general") != std::string::npos);
+            if (line.find(" pattern") != std::string::npos) {
+                header.field = MtxField::PATTERN;
+            } else if (line.find(" real") != std::string::npos || line.find(" double") != std::string::npos) {
+                header.field = MtxField::REAL;
+            } else if (line.find(" integer") != std::string::npos) {
+                header.field = MtxField::INTEGER;
+            } else {
+                header.supported = false;
+            }
+            first = false;
+
+        } else {
+            auto lstart = mtx_skip_blanks(ptr, eol);
+            if (lstart != eol && *lstart != '%') {
+                if (header.supported) {
+                    auto next = mtx_parse_integer(lstart, eol, header.nrows);
+                    next = mtx_parse_integer(next, eol, header.ncols);
+                    mtx_parse_integer(next, eol, header.nlines);
+                }
+                return (eol - start) + 1;
+            }
+        }
+
+        ptr = eol + 1;
+    }
+
+    return 0;
+}
+
+// Parses all lines in '[start, end)', which should not contain any partial
+// lines, except for the last line of the file that may lack a newline.
+// Triplets outside of the selection are skipped without parsing their values.
+inline void parse_mtx_lines(const char* start, const char* end, const MtxHeader& header, const MtxSelection& selection, MtxTriplets& store) {
+    const bool subsetted = selection.rows.active() || selection.columns.active();
+    auto ptr = start;
+    while (ptr < end) {
+        auto eol = mtx_find_newline(ptr, end);
+        auto lstart = mtx_skip_blanks(ptr, eol);
+
+        if (lstart != eol && *lstart != '%') {
+            MatrixIndex r, c;
+            auto next = mtx_parse_integer(lstart, eol, r);
+            next = mtx_parse_integer(next, eol, c);
+            if (r < 1 || r > header.nrows || c < 1 || c > header.ncols) {
+                throw std::runtime_error("row or column index out of range in the MatrixMarket file");
+            }
+            ++(store.lines);
+            --r;
+            --c;
+
+            if (!subsetted) {
+                double val = 1;
+                if (header.field != MtxField::PATTERN) {
+                    next = mtx_parse_double(next, eol, val);
+                }
+                store.rows.push_back(r);
+                store.columns.push_back(c);
+                store.values.push_back(val);
+
+            } else {
+                std::pair<const MatrixIndex*, const MatrixIndex*> rrange(&r, &r + 1);
+                if (selection.rows.active()) {
+                    rrange = selection.rows.find(r);
+                }
+                std::pair<const MatrixIndex*, const MatrixIndex*> crange(&c, &c + 1);
+                if (selection.columns.active()) {
+                    crange = selection.columns.find(c);
+                }
+
+                if (rrange.first != rrange.second && crange.first != crange.second) {
+                    double val = 1;
+                    if (header.field != MtxField::PATTERN) {
+                        next = mtx_parse_double(next, eol, val);
+                    }
+                    for (auto rptr = rrange.first; rptr != rrange.second; ++rptr) {
+                        for (auto cptr = crange.first; cptr != crange.second; ++cptr) {
+                            store.rows.push_back(*rptr);
+                            store.columns.push_back(*cptr);
+                            store.values.push_back(val);
+                        }
+                    }
+                }
+            }
+        }
+
+        ptr = eol + (eol < end);
+    }
+}
+
+// Merges the triplet stores, in order, into a compressed sparse row matrix.
+// The narrowest storage types are chosen before the merge so that the
+// triplets are written directly into the final vectors, and each store is
+// released as soon as it is merged to reduce the peak memory usage.
+inline NumericMatrix mtx_triplets_to_matrix(const MtxHeader& header, const MtxSelection& selection, std::vector<MtxTriplets>& stores, bool layered, int nthreads) {
+    std::size_t nlines = 0;
+    for (const auto& store : stores) {
+        nlines += store.lines;
+    }
+    if (nlines != header.nlines) {
+        throw std::runtime_error("expected " + std::to_string(header.nlines) + " non-zero elements in the MatrixMarket file, found " + std::to_string(nlines));
+    }
+
+    const auto nrows = selection.rows.extent();
+    const auto ncols = selection.columns.extent();
+    auto offsets = sanisizer::create<std::vector<std::size_t> >(sanisizer::sum<std::size_t>(nrows, 1));
+    NarrowSummary<double> summary;
+    for (const auto& store : stores) {
+        for (auto r : store.rows) {
+            ++(offsets[r + 1]);
+        }
+        for (auto v : store.values) {
+            summary.add(v);
+        }
+    }
+    for (MatrixIndex r = 0; r < nrows; ++r) {
+        offsets[r + 1] += offsets[r];
+    }
+
+    const std::size_t nnz = offsets.back();
+    const auto choice = choose_sparse_storage(summary.choose(), ncols, nnz);
+
+    auto output = dispatch_sparse_storage<double>(choice, [&](auto value, auto index, auto pointer) -> NumericMatrix {
+        typedef I<decltype(value)> Value;
+        typedef I<decltype(index)> Index;
+        auto indices = sanisizer::create<std::vector<Index> >(nnz);
+        auto values = sanisizer::create<std::vector<Value> >(nnz);
+        {
+            std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+            for (auto& store : stores) {
+                const auto n = store.rows.size();
+                for (I<decltype(n)> k = 0; k < n; ++k) {
+                    auto& pos = fill[store.rows[k]];
+                    indices[pos] = store.columns[k];
+                    values[pos] = store.values[k];
+                    ++pos;
+                }
+                store = MtxTriplets();
+            }
+        }
+
+        // Files are usually sorted by column within each row (or not sorted by
+        // row at all), so we only need to sort the rows that are out of order.
+        subpar::parallelize_range(nthreads, nrows, [&](int, MatrixIndex first, MatrixIndex length) -> void {
+            std::vector<std::pair<Index, Value> > work;
+            for (MatrixIndex r = first, last = first + length; r < last; ++r) {
+                const auto rstart = offsets[r], rend = offsets[r + 1];
+                if (std::is_sorted(indices.begin() + rstart, indices.begin() + rend)) {
+                    continue;
+                }
+                work.clear();
+                for (auto k = rstart; k < rend; ++k) {
+                    work.emplace_back(indices[k], values[k]);
+                }
+                std::sort(work.begin(), work.end());
+                for (auto k = rstart; k < rend; ++k) {
+                    indices[k] = work[k - rstart].first;
+                    values[k] = work[k - rstart].second;
+                }
+            }
+        });
+
+        auto mat = std::make_shared<tatami::CompressedSparseRowMatrix<
+            MatrixValue,
+            MatrixIndex,
+            std::vector<Value>,
+            std::vector<Index>,
+            std::vector<I<decltype(pointer)> >
+        > >(
+            nrows,
+            ncols,
+            std::move(values),
+            std::move(indices),
+            std::vector<I<decltype(pointer)> >(offsets.begin(), offsets.end())
+        );
+
+        if (layered) {
+            return sparse_from_tatami(*mat, true, false, nthreads);
+        } else {
+            return NumericMatrix(std::move(mat));
+        }
+    });
+
+    if (!layered) {
+        output.set_storage_savings(sparse_storage_savings<double>(choice, nrows, nnz));
+    }
+    return output;
+}
+
+// Incremental parser for a MatrixMarket file that arrives in arbitrary
+// pieces, e.g., from a decompressor or a stream. Partial lines at the end of
+// each piece are carried over to the next piece.
+class MtxChunkParser {
+public:
+    MtxChunkParser() = default;
+
+    MtxChunkParser(const MtxSubset& subset) : my_subset(subset) {}
+
+    // Returns false if the header was found but is not supported, in which
+    // case no further pieces should be added.
+    bool add(const char* start, const char* end) {
+        if (my_has_header) {
+            consume(start, end);
+            return true;
+        }
+
+        my_carry.insert(my_carry.end(), start, end);
+        const auto offset = parse_mtx_header(my_carry.data(), my_carry.data() + my_carry.size(), my_header);
+        if (offset) {
+            if (!my_header.supported) {
+                return false;
+            }
+            my_has_header = true;
+            my_selection.emplace(my_header, my_subset);
+            std::string body = my_carry.substr(offset);
+            my_carry.clear();
+            consume(body.data(), body.data() + body.size());
+        }
+        return true;
+    }
+
+    // Parses the last line, which may not be terminated by a newline.
+    void finish() {
+        if (!my_has_header) {
+            throw std::runtime_error("failed to find the size line in the MatrixMarket file");
+        }
+        parse_mtx_lines(my_carry.data(), my_carry.data() + my_carry.size(), my_header, *my_selection, my_store[0]);
+        my_carry.clear();
+    }
+
+    const MtxHeader& header() const {
+        return my_header;
+    }
+
+    std::size_t triplet_bytes() const {
+        const auto& store = my_store[0];
+        return vector_bytes(store.rows) + vector_bytes(store.columns) + vector_bytes(store.values);
+    }
+
+    NumericMatrix create_matrix(bool layered, int nthreads) {
+        return mtx_triplets_to_matrix(my_header, *my_selection, my_store, layered, nthreads);
+    }
+
+private:
+    void consume(const char* start, const char* end) {
+        if (!my_carry.empty()) {
+            auto first_newline = mtx_find_newline(start, end);
+            my_carry.insert(my_carry.end(), start, first_newline);
+            if (first_newline == end) {
+                return;
+            }
+            parse_mtx_lines(my_carry.data(), my_carry.data() + my_carry.size(), my_header, *my_selection, my_store[0]);
+            my_carry.clear();
+            start = first_newline + 1;
+        }
+
+        auto last_newline = end;
+        while (last_newline > start && last_newline[-1] != '\n') {
+            --last_newline;
+        }
+        parse_mtx_lines(start, last_newline, my_header, *my_selection, my_store[0]);
+        my_carry.insert(my_carry.end(), last_newline, end);
+    }
+
+    MtxSubset my_subset;
+    MtxHeader my_header;
+    std::optional<MtxSelection> my_selection;
+    bool my_has_header = false;
+    std::string my_carry;
+    std::vector<MtxTriplets> my_store = std::vector<MtxTriplets>(1);
+};
+
+// Parses all lines in '[start, end)' in parallel, by splitting them into
+// line-aligned pieces that are parsed into separate triplet stores. As in
+// parse_mtx_lines(), only the last line of the file may be incomplete.
+inline void parse_mtx_lines_parallel(const char* start, const char* end, const MtxHeader& header, const MtxSelection& selection, std::vector<MtxTriplets>& stores) {
+    const int nthreads = stores.size();
+    const std::size_t size = end - start;
+
+    auto boundaries = sanisizer::create<std::vector<const char*> >(sanisizer::sum<std::size_t>(nthreads, 1));
+    boundaries[0] = start;
+    for (int t = 1; t < nthreads; ++t) {
+        auto candidate = std::max(boundaries[t - 1], start + (size / nthreads) * t);
+        if (candidate > start && candidate < end && candidate[-1] != '\n') {
+            candidate = mtx_find_newline(candidate, end);
+            candidate += (candidate < end);
+        }
+        boundaries[t] = candidate;
+    }
+    boundaries[nthreads] = end;
+
+    subpar::parallelize_range(nthreads, nthreads, [&](int, int first, int length) -> void {
+        for (int t = first, last = first + length; t < last; ++t) {
+            parse_mtx_lines(boundaries[t], boundaries[t + 1], header, selection, stores[t]);
+        }
+    });
+}
+
+// Parses the body of an uncompressed MatrixMarket file in parallel.
+inline NumericMatrix parse_mtx_text_buffer_parallel(const char* buffer, std::size_t size, const MtxHeader& header, std::size_t body_offset, const MtxSubset& subset, bool layered, int nthreads) {
+    const MtxSelection selection(header, subset);
+    auto stores = sanisizer::create<std::vector<MtxTriplets> >(nthreads);
+    if (!subset.active()) { // otherwise we don't know how many triplets will be retained.
+        const std::size_t expected = header.nlines / nthreads + 1;
+        for (auto& store : stores) {
+            store.rows.reserve(expected);
+            store.columns.reserve(expected);
+            store.values.reserve(expected);
+        }
+    }
+
+    parse_mtx_lines_parallel(buffer + body_offset, buffer + size, header, selection, stores);
+    return mtx_triplets_to_matrix(header, selection, stores, layered, nthreads);
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef NORMALIZE_COUNTS_H
+#define NORMALIZE_COUNTS_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "NumericMatrix.h"
+
+#include "scran_norm/scran_norm.hpp"
+
+// 'blocks' may be NULL, in which case all cells are assumed to be in the same block.
+inline void center_size_factors(std::size_t n, double* ptr, const std::int32_t* blocks, bool to_lowest_block) {
+    scran_norm::CenterSizeFactorsOptions opt;
+    if (blocks) {
+        opt.block_mode = (to_lowest_block ? scran_norm::CenterBlockMode::LOWEST : scran_norm::CenterBlockMode::PER_BLOCK);
+        scran_norm::center_size_factors_blocked(n, ptr, blocks, NULL, opt);
+    } else {
+        scran_norm::center_size_factors(n, ptr, NULL, opt);
+    }
+}
+
+inline NumericMatrix normalize_counts(const NumericMatrix& mat, std::vector<double> sf, bool log, bool allow_zero, bool allow_non_finite) {
+    scran_norm::SanitizeSizeFactorsOptions san_opt;
+    if (allow_zero) {
+        san_opt.handle_zero = scran_norm::SanitizeAction::SANITIZE;
+    }
+    if (allow_non_finite) {
+        san_opt.handle_nan = scran_norm::SanitizeAction::SANITIZE;
+        san_opt.handle_infinite = scran_norm::SanitizeAction::SANITIZE;
+    }
+    scran_norm::sanitize_size_factors(sf.size(), sf.data(), san_opt);
+
+    scran_norm::NormalizeCountsOptions norm_opt;
+    norm_opt.log = log;
+    NumericMatrix output(scran_norm::normalize_counts(mat.ptr(), std::move(sf), norm_opt));
+    output.add_storage(mat);
+    return output;
+}
+
+#endif
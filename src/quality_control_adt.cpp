@@ -2,6 +2,7 @@
 
 #include "utils.h"
 #include "NumericMatrix.h"
+#include "format_memory_usage.h"
 
 #include "scran_qc/scran_qc.hpp"
 
@@ -42,6 +43,12 @@ public:
     JsFakeInt js_num_cells() const {
         return int2js(my_store.sum.size());
     }
+
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        usage.owned = vector_bytes(my_store.sum) + vector_bytes(my_store.detected) + nested_vector_bytes(my_store.subset_sum);
+        return format_memory_usage(usage);
+    }
 };
 
 ComputeAdtQcMetricsResults js_per_cell_adt_qc_metrics(const NumericMatrix& mat, JsFakeInt nsubsets_raw, JsFakeInt subsets_raw, JsFakeInt nthreads_raw) {
@@ -124,6 +131,16 @@ public:
         return my_use_blocked;
     }
 
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        if (my_use_blocked) {
+            usage.owned = vector_bytes(my_store_blocked.get_detected()) + nested_vector_bytes(my_store_blocked.get_subset_sum());
+        } else {
+            usage.owned = vector_bytes(my_store_unblocked.get_subset_sum());
+        }
+        return format_memory_usage(usage);
+    }
+
     void js_filter(const ComputeAdtQcMetricsResults& metrics, JsFakeInt blocks_raw, JsFakeInt output_raw) const {
         const auto output = js2int<std::uintptr_t>(output_raw);
         auto optr = reinterpret_cast<std::uint8_t*>(output);
@@ -162,6 +179,7 @@ EMSCRIPTEN_BINDINGS(quality_control_adt) {
         .function("subset_sum", &ComputeAdtQcMetricsResults::js_subset_sum, emscripten::return_value_policy::take_ownership())
         .function("num_subsets", &ComputeAdtQcMetricsResults::js_num_subsets, emscripten::return_value_policy::take_ownership())
         .function("num_cells", &ComputeAdtQcMetricsResults::js_num_cells, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &ComputeAdtQcMetricsResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 
     emscripten::function("suggest_adt_qc_filters", &js_suggest_adt_qc_filters, emscripten::return_value_policy::take_ownership());
@@ -173,6 +191,7 @@ EMSCRIPTEN_BINDINGS(quality_control_adt) {
         .function("num_subsets", &SuggestAdtQcFiltersResults::js_num_subsets, emscripten::return_value_policy::take_ownership())
         .function("num_blocks", &SuggestAdtQcFiltersResults::js_num_blocks, emscripten::return_value_policy::take_ownership())
         .function("is_blocked", &SuggestAdtQcFiltersResults::js_is_blocked, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &SuggestAdtQcFiltersResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         .function("filter", &SuggestAdtQcFiltersResults::js_filter, emscripten::return_value_policy::take_ownership())
         ;
 }
@@ -2,6 +2,7 @@
 
 #include "utils.h"
 #include "NumericMatrix.h"
+#include "format_memory_usage.h"
 
 #include "scran_qc/scran_qc.hpp"
 
@@ -41,6 +42,12 @@ public:
     JsFakeInt js_num_cells() const {
         return int2js(my_store.sum.size());
     }
+
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        usage.owned = vector_bytes(my_store.sum) + vector_bytes(my_store.detected) + vector_bytes(my_store.max_value) + vector_bytes(my_store.max_index);
+        return format_memory_usage(usage);
+    }
 };
 
 ComputeCrisprQcMetricsResults js_per_cell_crispr_qc_metrics(const NumericMatrix& mat, JsFakeInt nthreads_raw) {
@@ -94,6 +101,14 @@ public:
         return my_use_blocked;
     }
 
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        if (my_use_blocked) {
+            usage.owned = vector_bytes(my_store_blocked.get_max_value());
+        }
+        return format_memory_usage(usage);
+    }
+
     void js_filter(const ComputeCrisprQcMetricsResults& metrics, JsFakeInt blocks_raw, JsFakeInt output_raw) const {
         const auto output = js2int<std::uintptr_t>(output_raw);
         auto optr = reinterpret_cast<std::uint8_t*>(output);
@@ -130,6 +145,7 @@ EMSCRIPTEN_BINDINGS(quality_control_crispr) {
         .function("max_value", &ComputeCrisprQcMetricsResults::js_max_value, emscripten::return_value_policy::take_ownership())
         .function("max_index", &ComputeCrisprQcMetricsResults::js_max_index, emscripten::return_value_policy::take_ownership())
         .function("num_cells", &ComputeCrisprQcMetricsResults::js_num_cells, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &ComputeCrisprQcMetricsResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 
     emscripten::function("suggest_crispr_qc_filters", &js_suggest_crispr_qc_filters, emscripten::return_value_policy::take_ownership());
@@ -139,6 +155,7 @@ EMSCRIPTEN_BINDINGS(quality_control_crispr) {
         .function("max_value", &SuggestCrisprQcFiltersResults::js_max_value, emscripten::return_value_policy::take_ownership())
         .function("num_blocks", &SuggestCrisprQcFiltersResults::js_num_blocks, emscripten::return_value_policy::take_ownership())
         .function("is_blocked", &SuggestCrisprQcFiltersResults::js_is_blocked, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &SuggestCrisprQcFiltersResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         .function("filter", &SuggestCrisprQcFiltersResults::js_filter, emscripten::return_value_policy::take_ownership())
         ;
 }
@@ -2,6 +2,8 @@
 
 #include "utils.h"
 #include "NumericMatrix.h"
+#include "format_memory_usage.h"
+#include "quality_control_rna.h"
 
 #include "scran_qc/scran_qc.hpp"
 
@@ -42,12 +44,16 @@ public:
     JsFakeInt js_num_cells() const {
         return int2js(my_store.sum.size());
     }
+
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        usage.owned = vector_bytes(my_store.sum) + vector_bytes(my_store.detected) + nested_vector_bytes(my_store.subset_proportion);
+        return format_memory_usage(usage);
+    }
 };
 
 ComputeRnaQcMetricsResults js_compute_rna_qc_metrics(const NumericMatrix& mat, JsFakeInt nsubsets_raw, JsFakeInt subsets_raw, JsFakeInt nthreads_raw) {
-    scran_qc::ComputeRnaQcMetricsOptions opt;
-    opt.num_threads = js2int<int>(nthreads_raw);
-    auto store = scran_qc::compute_rna_qc_metrics(*(mat.ptr()), convert_array_of_offsets<const std::uint8_t*>(nsubsets_raw, subsets_raw), opt);
+    auto store = compute_rna_qc_metrics(mat, convert_array_of_offsets<const std::uint8_t*>(nsubsets_raw, subsets_raw), js2int<int>(nthreads_raw));
     return ComputeRnaQcMetricsResults(std::move(store));
 }
 
@@ -136,6 +142,16 @@ public:
         return my_use_blocked;
     }
 
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        if (my_use_blocked) {
+            usage.owned = vector_bytes(my_store_blocked.get_sum()) + vector_bytes(my_store_blocked.get_detected()) + nested_vector_bytes(my_store_blocked.get_subset_proportion());
+        } else {
+            usage.owned = vector_bytes(my_store_unblocked.get_subset_proportion());
+        }
+        return format_memory_usage(usage);
+    }
+
     void js_filter(const ComputeRnaQcMetricsResults& metrics, JsFakeInt blocks_raw, JsFakeInt output_raw) const {
         const auto output = js2int<std::uintptr_t>(output_raw);
         auto optr = reinterpret_cast<std::uint8_t*>(output);
@@ -173,6 +189,7 @@ EMSCRIPTEN_BINDINGS(quality_control_rna) {
         .function("subset_proportion", &ComputeRnaQcMetricsResults::js_subset_proportion, emscripten::return_value_policy::take_ownership())
         .function("num_subsets", &ComputeRnaQcMetricsResults::js_num_subsets, emscripten::return_value_policy::take_ownership())
         .function("num_cells", &ComputeRnaQcMetricsResults::js_num_cells, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &ComputeRnaQcMetricsResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 
     emscripten::function("suggest_rna_qc_filters", &js_suggest_rna_qc_filters, emscripten::return_value_policy::take_ownership());
@@ -185,6 +202,7 @@ EMSCRIPTEN_BINDINGS(quality_control_rna) {
         .function("num_subsets", &SuggestRnaQcFiltersResults::js_num_subsets, emscripten::return_value_policy::take_ownership())
         .function("num_blocks", &SuggestRnaQcFiltersResults::js_num_blocks, emscripten::return_value_policy::take_ownership())
         .function("is_blocked", &SuggestRnaQcFiltersResults::js_is_blocked, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &SuggestRnaQcFiltersResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         .function("filter", &SuggestRnaQcFiltersResults::js_filter, emscripten::return_value_policy::take_ownership())
         ;
 }
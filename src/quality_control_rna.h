@@ -0,0 +1,17 @@
+#ifndef QUALITY_CONTROL_RNA_H
+#define QUALITY_CONTROL_RNA_H
+
+#include <vector>
+#include <cstdint>
+
+#include "NumericMatrix.h"
+
+#include "scran_qc/scran_qc.hpp"
+
+inline scran_qc::ComputeRnaQcMetricsResults<double, std::int32_t, double> compute_rna_qc_metrics(const NumericMatrix& mat, const std::vector<const std::uint8_t*>& subsets, int nthreads) {
+    scran_qc::ComputeRnaQcMetricsOptions opt;
+    opt.num_threads = nthreads;
+    return scran_qc::compute_rna_qc_metrics(*(mat.ptr()), subsets, opt);
+}
+
+#endif
@@ -55,6 +55,7 @@ EMSCRIPTEN_BINDINGS(rds_utils) {
         .function("type", &RdsObject::js_type, emscripten::return_value_policy::take_ownership())
         .function("numeric_vector", &RdsObject::js_numeric_vector, emscripten::return_value_policy::take_ownership())
         .function("string_vector", &RdsObject::js_string_vector, emscripten::return_value_policy::take_ownership())
+        .function("string_pool", &RdsObject::js_string_pool, emscripten::return_value_policy::take_ownership())
         .function("attribute_names", &RdsObject::js_attribute_names, emscripten::return_value_policy::take_ownership())
         .function("find_attribute", &RdsObject::js_find_attribute, emscripten::return_value_policy::take_ownership())
         .function("load_attribute_by_name", &RdsObject::js_load_attribute_by_name, emscripten::return_value_policy::take_ownership())
@@ -10,6 +10,7 @@
 #include <cstddef>
 
 #include "utils.h"
+#include "string_pool.h"
 
 #include "rds2cpp/rds2cpp.hpp"
 
@@ -112,6 +113,18 @@ public:
         return extract_strings(sptr->data);
     }
 
+    StringPool js_string_pool() const {
+        if (my_ptr->type() != rds2cpp::SEXPType::STR) {
+            throw std::runtime_error("cannot return string values for non-string RObject type");
+        }
+        auto sptr = static_cast<const rds2cpp::StringVector*>(my_ptr);
+        StringPool output(sptr->data.size());
+        for (const auto& s : sptr->data) {
+            output.add(s);
+        }
+        return output;
+    }
+
 private:
     template<class AttrClass>
     emscripten::val extract_attribute_names() {
@@ -3,36 +3,300 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
 
 #include "NumericMatrix.h"
 #include "tatami/tatami.hpp"
 #include "tatami_layered/tatami_layered.hpp"
 
+// Storage types for the compressed sparse matrices are chosen to be as narrow
+// as possible. Count matrices usually have small values and fewer than 65536
+// columns, so the default int32/double values, int32 indices and size_t
+// pointers would waste a lot of memory for non-layered matrices.
+enum class NarrowValue : char { U8, U16, NONE };
+
+struct SparseStorageChoice {
+    NarrowValue value = NarrowValue::NONE;
+    bool index16 = false;
+    bool pointer32 = false;
+};
+
+template<typename Value_>
+NarrowValue choose_narrow_value(Value_ lower, Value_ upper) {
+    if (lower >= 0) {
+        if (upper <= std::numeric_limits<std::uint8_t>::max()) {
+            return NarrowValue::U8;
+        } else if (upper <= std::numeric_limits<std::uint16_t>::max()) {
+            return NarrowValue::U16;
+        }
+    }
+    return NarrowValue::NONE;
+}
+
+inline SparseStorageChoice choose_sparse_storage(NarrowValue value, MatrixIndex ncols, std::size_t nnz) {
+    SparseStorageChoice choice;
+    choice.value = value;
+    choice.index16 = (static_cast<std::size_t>(ncols) <= static_cast<std::size_t>(std::numeric_limits<std::uint16_t>::max()) + 1);
+    choice.pointer32 = (nnz <= std::numeric_limits<std::uint32_t>::max());
+    return choice;
+}
+
+template<typename StorageValue_>
+std::size_t sparse_storage_savings(const SparseStorageChoice& choice, MatrixIndex nrows, std::size_t nnz) {
+    std::size_t value_size = sizeof(StorageValue_);
+    if (choice.value == NarrowValue::U8) {
+        value_size = sizeof(std::uint8_t);
+    } else if (choice.value == NarrowValue::U16) {
+        value_size = sizeof(std::uint16_t);
+    }
+    const std::size_t index_size = (choice.index16 ? sizeof(std::uint16_t) : sizeof(MatrixIndex));
+    const std::size_t pointer_size = (choice.pointer32 ? sizeof(std::uint32_t) : sizeof(std::size_t));
+
+    // All savings are computed relative to the wide types that would
+    // otherwise be used, so they are always non-negative.
+    const std::size_t nptrs = static_cast<std::size_t>(nrows) + 1;
+    return nnz * (sizeof(StorageValue_) - value_size) + nnz * (sizeof(MatrixIndex) - index_size) + nptrs * (sizeof(std::size_t) - pointer_size);
+}
+
+// Calls 'fun' with default-constructed instances of the chosen value, index
+// and pointer types, so that callers can use them for template deduction.
+template<typename StorageValue_, class Function_>
+NumericMatrix dispatch_sparse_storage(const SparseStorageChoice& choice, Function_ fun) {
+    auto with_pointer = [&](auto value, auto index) -> NumericMatrix {
+        if (choice.pointer32) {
+            return fun(value, index, std::uint32_t());
+        } else {
+            return fun(value, index, std::size_t());
+        }
+    };
+
+    auto with_index = [&](auto value) -> NumericMatrix {
+        if (choice.index16) {
+            return with_pointer(value, std::uint16_t());
+        } else {
+            return with_pointer(value, MatrixIndex());
+        }
+    };
+
+    if (choice.value == NarrowValue::U8) {
+        return with_index(std::uint8_t());
+    } else if (choice.value == NarrowValue::U16) {
+        return with_index(std::uint16_t());
+    } else {
+        return with_index(StorageValue_());
+    }
+}
+
+// Values are only narrowed if they can be exactly represented by the
+// narrower type, so floating-point inputs must also be integral. Each value
+// is checked after conversion to the storage type, e.g., for float32.
+template<typename StorageValue_>
+struct NarrowSummary {
+    bool nonnegative_integers = true;
+    StorageValue_ upper = 0;
+
+    template<typename Value_>
+    void add(Value_ v) {
+        if (!nonnegative_integers) {
+            return;
+        }
+        const StorageValue_ stored = v;
+        if (stored < 0 || stored != std::trunc(stored)) {
+            nonnegative_integers = false;
+        } else if (stored > upper) {
+            upper = stored;
+        }
+    }
+
+    void merge(const NarrowSummary& other) {
+        nonnegative_integers = nonnegative_integers && other.nonnegative_integers;
+        upper = std::max(upper, other.upper);
+    }
+
+    NarrowValue choose() const {
+        return (nonnegative_integers ? choose_narrow_value<StorageValue_>(0, upper) : NarrowValue::NONE);
+    }
+};
+
 template<typename StorageValue_, class ValueVector_, class IndexVector_, class PointerVector_>
 NumericMatrix copy_into_sparse(MatrixIndex nrows, MatrixIndex ncols, const ValueVector_& x, const IndexVector_& i, const PointerVector_& p) {
-    return NumericMatrix(
-        std::make_shared<tatami::CompressedSparseRowMatrix<
-            MatrixValue,
-            MatrixIndex,
-            std::vector<StorageValue_>,
-            std::vector<MatrixIndex>,
-            std::vector<std::size_t>
-        > >(
-            nrows,
-            ncols, 
-            std::vector<StorageValue_>(x.begin(), x.end()),
-            std::vector<MatrixIndex>(i.begin(), i.end()),
-            std::vector<std::size_t>(p.begin(), p.end())
-        )
-    );
+    NarrowSummary<StorageValue_> summary;
+    for (auto v : x) {
+        summary.add(v);
+    }
+
+    const std::size_t nnz = x.size();
+    auto choice = choose_sparse_storage(summary.choose(), ncols, nnz);
+
+    NumericMatrix output = dispatch_sparse_storage<StorageValue_>(choice, [&](auto value, auto index, auto pointer) -> NumericMatrix {
+        return NumericMatrix(
+            std::make_shared<tatami::CompressedSparseRowMatrix<
+                MatrixValue,
+                MatrixIndex,
+                std::vector<I<decltype(value)> >,
+                std::vector<I<decltype(index)> >,
+                std::vector<I<decltype(pointer)> >
+            > >(
+                nrows,
+                ncols, 
+                std::vector<I<decltype(value)> >(x.begin(), x.end()),
+                std::vector<I<decltype(index)> >(i.begin(), i.end()),
+                std::vector<I<decltype(pointer)> >(p.begin(), p.end())
+            )
+        );
+    });
+
+    output.set_storage_savings(sparse_storage_savings<StorageValue_>(choice, nrows, nnz));
+    return output;
 }
 
+// Counts the non-zero elements in each row of 'mat' while summarizing the
+// values for narrowing, in a single pass along the preferred dimension.
+template<bool sparse_, typename StorageValue_, typename Value_, typename Index_>
+NarrowSummary<StorageValue_> count_and_summarize_non_zeros(const tatami::Matrix<Value_, Index_>& mat, std::size_t* row_counts, int nthreads) {
+    const bool row = mat.prefer_rows();
+    const auto nrows = mat.nrow();
+    const Index_ primary = (row ? nrows : mat.ncol());
+    const Index_ secondary = (row ? mat.ncol() : nrows);
+    std::fill_n(row_counts, nrows, 0);
+
+    // When iterating by column, each thread needs its own counts for the rows.
+    auto summaries = sanisizer::create<std::vector<NarrowSummary<StorageValue_> > >(std::max(nthreads, 1));
+    auto thread_counts = sanisizer::create<std::vector<std::vector<std::size_t> > >(row ? 0 : std::max(nthreads, 1));
+
+    tatami::parallelize([&](int t, Index_ start, Index_ length) -> void {
+        tatami::Options opt;
+        opt.sparse_ordered_index = false;
+        auto ext = tatami::consecutive_extractor<sparse_>(mat, row, start, length, opt);
+        auto vbuffer = sanisizer::create<std::vector<Value_> >(secondary);
+        std::vector<Index_> ibuffer;
+        if constexpr(sparse_) {
+            sanisizer::resize(ibuffer, secondary);
+        }
+
+        std::size_t* counts = row_counts;
+        if (!row) {
+            sanisizer::resize(thread_counts[t], nrows);
+            counts = thread_counts[t].data();
+        }
+        auto& summary = summaries[t];
+
+        for (Index_ i = start, end = start + length; i < end; ++i) {
+            const Value_* vptr;
+            const Index_* iptr = NULL;
+            Index_ number;
+            if constexpr(sparse_) {
+                auto range = ext->fetch(vbuffer.data(), ibuffer.data());
+                vptr = range.value;
+                iptr = range.index;
+                number = range.number;
+            } else {
+                vptr = ext->fetch(vbuffer.data());
+                number = secondary;
+            }
+
+            std::size_t count = 0;
+            for (Index_ k = 0; k < number; ++k) {
+                const auto val = vptr[k];
+                if (val) {
+                    summary.add(val);
+                    if (row) {
+                        ++count;
+                    } else {
+                        ++(counts[sparse_ ? iptr[k] : k]);
+                    }
+                }
+            }
+            if (row) {
+                counts[i] = count;
+            }
+        }
+    }, primary, nthreads);
+
+    for (const auto& current : thread_counts) {
+        for (Index_ r = 0; r < nrows; ++r) {
+            row_counts[r] += current[r];
+        }
+    }
+    for (std::size_t t = 1; t < summaries.size(); ++t) {
+        summaries.front().merge(summaries[t]);
+    }
+    return summaries.front();
+}
+
+// Non-layered counterpart to tatami::convert_to_compressed_sparse() that
+// uses the narrowest storage types. We count the non-zeros per row and check
+// whether the values can be narrowed in a single pass, so that all storage
+// types are known before anything is allocated; a second pass fills them.
+template<typename StorageValue_, typename Value_, typename Index_>
+NumericMatrix compact_sparse_from_tatami(const tatami::Matrix<Value_, Index_>& mat, int nthreads) {
+    const auto nrows = mat.nrow();
+    const auto ncols = mat.ncol();
+    auto pointers = sanisizer::create<std::vector<std::size_t> >(sanisizer::sum<std::size_t>(nrows, 1));
+    NarrowSummary<StorageValue_> summary;
+    if (mat.is_sparse()) {
+        summary = count_and_summarize_non_zeros<true, StorageValue_>(mat, pointers.data() + 1, nthreads);
+    } else {
+        summary = count_and_summarize_non_zeros<false, StorageValue_>(mat, pointers.data() + 1, nthreads);
+    }
+    for (Index_ r = 0; r < nrows; ++r) {
+        pointers[r + 1] += pointers[r];
+    }
+    const std::size_t nnz = pointers.back();
+
+    auto choice = choose_sparse_storage(summary.choose(), ncols, nnz);
+
+    NumericMatrix output = dispatch_sparse_storage<StorageValue_>(choice, [&](auto value, auto index, auto pointer) -> NumericMatrix {
+        auto values = sanisizer::create<std::vector<I<decltype(value)> > >(nnz);
+        auto indices = sanisizer::create<std::vector<I<decltype(index)> > >(nnz);
+        tatami::fill_compressed_sparse_contents(&mat, true, pointers.data(), values.data(), indices.data(), nthreads);
+        return NumericMatrix(
+            std::make_shared<tatami::CompressedSparseRowMatrix<
+                MatrixValue,
+                MatrixIndex,
+                std::vector<I<decltype(value)> >,
+                std::vector<I<decltype(index)> >,
+                std::vector<I<decltype(pointer)> >
+            > >(
+                nrows,
+                ncols, 
+                std::move(values),
+                std::move(indices),
+                std::vector<I<decltype(pointer)> >(pointers.begin(), pointers.end())
+            )
+        );
+    });
+
+    output.set_storage_savings(sparse_storage_savings<StorageValue_>(choice, nrows, nnz));
+    return output;
+}
+
+// The 'float32' flag stores non-integer values in single precision to halve
+// the memory usage, while still exposing them as MatrixValue to callers.
 template<typename Value_, typename Index_>
-NumericMatrix sparse_from_tatami(const tatami::Matrix<Value_, Index_>& mat, bool layered) {
+NumericMatrix sparse_from_tatami(const tatami::Matrix<Value_, Index_>& mat, bool layered, bool float32, int nthreads = 1) {
     if (layered) {
-        return NumericMatrix(tatami_layered::convert_to_layered_sparse<MatrixValue, MatrixIndex>(mat));
+        tatami_layered::ConvertToLayeredSparseOptions lopt;
+        lopt.num_threads = nthreads;
+        return NumericMatrix(tatami_layered::convert_to_layered_sparse<MatrixValue, MatrixIndex>(mat, lopt));
+    } else if (float32) {
+        return compact_sparse_from_tatami<float>(mat, nthreads);
+    } else {
+        return compact_sparse_from_tatami<Value_>(mat, nthreads);
+    }
+}
+
+template<typename Value_, typename Index_>
+NumericMatrix dense_from_tatami(const tatami::Matrix<Value_, Index_>& mat, bool float32, int nthreads = 1) {
+    tatami::ConvertToDenseOptions dopt;
+    dopt.num_threads = nthreads;
+    if (float32) {
+        return NumericMatrix(tatami::convert_to_dense<MatrixValue, MatrixIndex, float>(mat, true, dopt));
     } else {
-        return NumericMatrix(tatami::convert_to_compressed_sparse<MatrixValue, MatrixIndex, Value_, Index_>(&mat, true));
+        return NumericMatrix(tatami::convert_to_dense<MatrixValue, MatrixIndex, Value_>(mat, true, dopt));
     }
 }
 
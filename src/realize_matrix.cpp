@@ -0,0 +1,25 @@
+#include <emscripten/bind.h>
+
+#include "NumericMatrix.h"
+#include "read_utils.h"
+#include "utils.h"
+
+void js_realize_matrix(NumericMatrix& mat, bool sparse, bool layered, bool float32, JsFakeInt nthreads_raw) {
+    const auto nthreads = js2int<int>(nthreads_raw);
+    auto realized = track_storage([&]() -> NumericMatrix {
+        if (sparse) {
+            return sparse_from_tatami(*(mat.ptr()), layered, float32, nthreads);
+        } else {
+            return dense_from_tatami(*(mat.ptr()), float32, nthreads);
+        }
+    });
+
+    // The realized matrix no longer references any of the previous storage.
+    mat.reset_ptr(realized.ptr());
+    mat.set_storage(realized.storage());
+    mat.set_storage_savings(realized.storage_savings());
+}
+
+EMSCRIPTEN_BINDINGS(realize_matrix) {
+    emscripten::function("realize_matrix", &js_realize_matrix, emscripten::return_value_policy::take_ownership());
+}
@@ -5,6 +5,8 @@
 #include <stdexcept>
 
 #include "NumericMatrix.h"
+#include "run_pca.h"
+#include "format_memory_usage.h"
 #include "utils.h"
 
 #include "Eigen/Dense"
@@ -64,6 +66,24 @@ public:
         }
     }
 
+private:
+    template<class Store_>
+    static MemoryUsage compute_memory_usage(const Store_& store) {
+        MemoryUsage output;
+        const auto nvalues = store.components.size() + store.variance_explained.size() + store.rotation.size() + store.center.size() + store.scale.size();
+        output.owned = nvalues * sizeof(double);
+        return output;
+    }
+
+public:
+    emscripten::val js_memory_usage() const {
+        if (my_use_blocked) {
+            return format_memory_usage(compute_memory_usage(my_store_blocked));
+        } else {
+            return format_memory_usage(compute_memory_usage(my_store_unblocked));
+        }
+    }
+
 public:
     JsFakeInt js_num_cells() const {
         if (my_use_blocked) {
@@ -95,49 +115,23 @@ PcaResults js_run_pca(
     bool realize_matrix,
     JsFakeInt nthreads_raw
 ) {
-    const auto number = js2int<int>(number_raw); 
-    if (number < 1) {
-        throw std::runtime_error("requested number of PCs should be positive");
-    }
-
-    auto ptr = mat.ptr();
-    const auto NR = ptr->nrow();
-
+    const std::uint8_t* subset = NULL;
     if (use_subset) {
-        const auto subset = js2int<std::uintptr_t>(subset_raw);
-        auto subptr = reinterpret_cast<const std::uint8_t*>(subset);
-        std::vector<int> keep;
-        for (I<decltype(NR)> r = 0; r < NR; ++r) {
-            if (subptr[r]) {
-                keep.push_back(r);
-            }
-        }
-        auto tmp = tatami::make_DelayedSubset(std::move(ptr), std::move(keep), true);
-        ptr = std::move(tmp);
+        subset = reinterpret_cast<const std::uint8_t*>(js2int<std::uintptr_t>(subset_raw));
     }
+    const auto ptr = pca_input(mat, subset);
 
+    const auto number = js2int<int>(number_raw); 
     const auto nthreads = js2int<int>(nthreads_raw);
 
     if (use_blocks) {
-        scran_pca::BlockedPcaOptions opt;
-        opt.number = number;
-        opt.scale = scale;
-        opt.realize_matrix = realize_matrix;
-        opt.num_threads = nthreads;
-        opt.block_weight_policy = translate_block_weight_policy(weight_policy);
-        opt.components_from_residuals = components_from_residuals;
-
+        const auto opt = blocked_pca_options(number, scale, realize_matrix, weight_policy, components_from_residuals, nthreads);
         const auto blocks = js2int<std::uintptr_t>(blocks_raw);
         auto store = scran_pca::blocked_pca(*ptr, reinterpret_cast<const std::int32_t*>(blocks), opt);
         return PcaResults(std::move(store));
 
     } else {
-        scran_pca::SimplePcaOptions opt;
-        opt.number = number;
-        opt.scale = scale;
-        opt.realize_matrix = realize_matrix;
-        opt.num_threads = nthreads;
-
+        const auto opt = pca_options<scran_pca::SimplePcaOptions>(number, scale, realize_matrix, nthreads);
         auto store = scran_pca::simple_pca(*ptr, opt);
         return PcaResults(std::move(store));
     }
@@ -153,5 +147,6 @@ EMSCRIPTEN_BINDINGS(run_pca) {
         .function("rotation", &PcaResults::js_rotation, emscripten::return_value_policy::take_ownership())
         .function("num_cells", &PcaResults::js_num_cells, emscripten::return_value_policy::take_ownership())
         .function("num_pcs", &PcaResults::js_num_pcs, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &PcaResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 }
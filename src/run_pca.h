@@ -0,0 +1,52 @@
+#ifndef RUN_PCA_H
+#define RUN_PCA_H
+
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+
+#include "NumericMatrix.h"
+#include "scratch.h"
+#include "utils.h"
+
+#include "tatami/tatami.hpp"
+#include "scran_pca/scran_pca.hpp"
+
+// 'subset' may be NULL, in which case all features are used.
+inline std::shared_ptr<const tatami::Matrix<MatrixValue, MatrixIndex> > pca_input(const NumericMatrix& mat, const std::uint8_t* subset) {
+    if (subset) {
+        return subset_rows_by_mask(mat.ptr(), subset);
+    } else {
+        return mat.ptr();
+    }
+}
+
+template<class Options_>
+Options_ pca_options(int number, bool scale, bool realize_matrix, int nthreads) {
+    if (number < 1) {
+        throw std::runtime_error("requested number of PCs should be positive");
+    }
+    Options_ opt;
+    opt.number = number;
+    opt.scale = scale;
+    opt.realize_matrix = realize_matrix;
+    opt.num_threads = nthreads;
+    return opt;
+}
+
+inline scran_pca::BlockedPcaOptions blocked_pca_options(
+    int number,
+    bool scale,
+    bool realize_matrix,
+    const std::string& weight_policy,
+    bool components_from_residuals,
+    int nthreads
+) {
+    auto opt = pca_options<scran_pca::BlockedPcaOptions>(number, scale, realize_matrix, nthreads);
+    opt.block_weight_policy = translate_block_weight_policy(weight_policy);
+    opt.components_from_residuals = components_from_residuals;
+    return opt;
+}
+
+#endif
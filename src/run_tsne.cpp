@@ -2,9 +2,10 @@
 
 #include "utils.h"
 #include "NeighborIndex.h"
+#include "format_memory_usage.h"
+#include "run_tsne.h"
 #include "qdtsne/qdtsne.hpp"
 
-#include <chrono>
 #include <cstdint>
 #include <cstddef>
 
@@ -14,8 +15,14 @@ private:
 
     Status my_status;
 
+    // The status is opaque, so its storage is measured from the heap when it
+    // is initialized. This is approximate as it includes any allocations by
+    // other threads in the meantime, and it ignores any growth of the status
+    // while the algorithm is running.
+    std::size_t my_storage;
+
 public:
-    TsneStatus(Status s) : my_status(std::move(s)) {}
+    TsneStatus(Status s, std::size_t storage) : my_status(std::move(s)), my_storage(storage) {}
 
     Status& status() {
         return my_status;
@@ -27,21 +34,24 @@ public:
     }
 
     TsneStatus js_deepcopy() const {
-        return TsneStatus(my_status);
+        return TsneStatus(my_status, my_storage);
     }
 
     JsFakeInt js_num_observations() const {
         return int2js(my_status.num_observations());
     }
+
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        usage.owned = my_storage;
+        return format_memory_usage(usage);
+    }
 };
 
 TsneStatus js_initialize_tsne(const NeighborResults& neighbors, double perplexity, JsFakeInt nthreads_raw) {
-    qdtsne::Options opt;
-    opt.perplexity = perplexity;
-    opt.num_threads = js2int<int>(nthreads_raw);
-    opt.max_depth = 7; // speed up iterations, avoid problems with duplicates.
-    auto stat = qdtsne::initialize<2>(neighbors.neighbors(), opt);
-    return TsneStatus(std::move(stat));
+    HeapTracker tracker;
+    auto stat = initialize_tsne(neighbors, perplexity, js2int<int>(nthreads_raw));
+    return TsneStatus(std::move(stat), tracker.retained());
 }
 
 void js_randomize_tsne_start(JsFakeInt n_raw, JsFakeInt Y_raw, JsFakeInt seed_raw) {
@@ -59,23 +69,8 @@ JsFakeInt js_perplexity_to_k(double perplexity) {
 }
 
 void js_run_tsne(TsneStatus& obj, JsFakeInt runtime_raw, JsFakeInt maxiter_raw, JsFakeInt Y_raw) {
-    auto& status = obj.status();
     const auto Y = js2int<std::uintptr_t>(Y_raw);
-    double* ptr = reinterpret_cast<double*>(Y);
-
-    auto iter = status.iteration();
-    const auto runtime = js2int<std::uint64_t>(runtime_raw);
-    const auto maxiter = js2int<I<decltype(iter)> >(maxiter_raw); 
-
-    if (runtime <= 0) {
-        status.run(ptr, maxiter);
-    } else {
-        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(runtime);
-        do {
-            ++iter;
-            status.run(ptr, iter);
-        } while (iter < maxiter && std::chrono::steady_clock::now() < end);
-    }
+    run_tsne(obj.status(), js2int<std::uint64_t>(runtime_raw), js2int<int>(maxiter_raw), reinterpret_cast<double*>(Y));
 }
 
 EMSCRIPTEN_BINDINGS(run_tsne) {
@@ -91,5 +86,6 @@ EMSCRIPTEN_BINDINGS(run_tsne) {
         .function("iterations", &TsneStatus::js_iterations, emscripten::return_value_policy::take_ownership())
         .function("deepcopy", &TsneStatus::js_deepcopy, emscripten::return_value_policy::take_ownership())
         .function("num_observations", &TsneStatus::js_num_observations, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &TsneStatus::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 }
@@ -0,0 +1,34 @@
+#ifndef RUN_TSNE_H
+#define RUN_TSNE_H
+
+#include <chrono>
+#include <cstdint>
+
+#include "utils.h"
+#include "NeighborIndex.h"
+
+#include "qdtsne/qdtsne.hpp"
+
+inline qdtsne::Status<2, std::int32_t, double> initialize_tsne(const NeighborResults& neighbors, double perplexity, int nthreads) {
+    qdtsne::Options opt;
+    opt.perplexity = perplexity;
+    opt.num_threads = nthreads;
+    opt.max_depth = 7; // speed up iterations, avoid problems with duplicates.
+    return qdtsne::initialize<2>(neighbors.neighbors(), opt);
+}
+
+// If 'runtime' is positive, iterations stop after 'runtime' milliseconds even if 'maxiter' is not yet reached.
+inline void run_tsne(qdtsne::Status<2, std::int32_t, double>& status, std::uint64_t runtime, int maxiter, double* Y) {
+    auto iter = status.iteration();
+    if (runtime <= 0) {
+        status.run(Y, maxiter);
+    } else {
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(runtime);
+        do {
+            ++iter;
+            status.run(Y, iter);
+        } while (iter < maxiter && std::chrono::steady_clock::now() < end);
+    }
+}
+
+#endif
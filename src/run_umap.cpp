@@ -2,11 +2,13 @@
 
 #include "utils.h"
 #include "NeighborIndex.h"
+#include "format_memory_usage.h"
+#include "run_umap.h"
 
 #include "umappp/umappp.hpp"
-#include "knncolle/knncolle.hpp"
 
-#include <chrono>
+#include <cstdint>
+#include <cstddef>
 
 class UmapStatus {
 private:
@@ -14,8 +16,14 @@ private:
 
     Status my_status;
 
+    // The status is opaque, so its storage is measured from the heap when it
+    // is initialized. This is approximate as it includes any allocations by
+    // other threads in the meantime, and it ignores any growth of the status
+    // while the algorithm is running.
+    std::size_t my_storage;
+
 public:
-    UmapStatus(Status s) : my_status(std::move(s)) {}
+    UmapStatus(Status s, std::size_t storage) : my_status(std::move(s)), my_storage(storage) {}
 
     Status& status() {
         return my_status;
@@ -31,12 +39,18 @@ public:
     }
 
     UmapStatus js_deepcopy() const {
-        return UmapStatus(my_status);
+        return UmapStatus(my_status, my_storage);
     }
 
     JsFakeInt js_num_observations() const {
         return int2js(my_status.num_observations());
     }
+
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        usage.owned = my_storage;
+        return format_memory_usage(usage);
+    }
 };
 
 UmapStatus js_initialize_umap(
@@ -46,47 +60,15 @@ UmapStatus js_initialize_umap(
     JsFakeInt Y_raw,
     JsFakeInt nthreads_raw
 ) {
-    umappp::Options opt;
-    opt.min_dist = min_dist;
-    opt.num_epochs = js2int<int>(num_epochs_raw);
-    opt.num_threads = js2int<int>(nthreads_raw);
-
-    const auto& in_neighbors = neighbors.neighbors(); 
-    const auto nobs = in_neighbors.size();
-    auto copy = sanisizer::create<std::vector<std::vector<std::pair<std::int32_t, float> > > >(nobs);
-    for (I<decltype(nobs)> i = 0; i < nobs; ++i) {
-        auto& output = copy[i];
-        const auto& src = in_neighbors[i];
-        const auto n = src.size();
-        output.reserve(n);
-        for (I<decltype(n)> j = 0; j < n; ++j) {
-            output.emplace_back(src[j].first, src[j].second);
-        }
-    }
-
+    HeapTracker tracker; // includes the copy of the neighbors, which is moved into the status.
     const auto Y = js2int<std::uintptr_t>(Y_raw);
-    float* embedding = reinterpret_cast<float*>(Y);
-    auto stat = umappp::initialize(std::move(copy), 2, embedding, opt);
-    return UmapStatus(std::move(stat));
+    auto stat = initialize_umap(neighbors, js2int<int>(num_epochs_raw), min_dist, reinterpret_cast<float*>(Y), js2int<int>(nthreads_raw));
+    return UmapStatus(std::move(stat), tracker.retained());
 }
 
 void js_run_umap(UmapStatus& obj, JsFakeInt Y_raw, JsFakeInt runtime_raw) {
-    const auto runtime = js2int<std::uint64_t>(runtime_raw); 
     const auto Y = js2int<std::uintptr_t>(Y_raw);
-    float* embedding = reinterpret_cast<float*>(Y);
-    auto& status = obj.status();
-
-    if (runtime <= 0) {
-        status.run(embedding);
-    } else {
-        auto current = status.epoch();
-        const auto total = status.num_epochs();
-        const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(runtime);
-        do {
-            ++current;
-            status.run(embedding, current);
-        } while (current < total && std::chrono::steady_clock::now() < end);
-    }
+    run_umap(obj.status(), reinterpret_cast<float*>(Y), js2int<std::uint64_t>(runtime_raw));
 }
 
 EMSCRIPTEN_BINDINGS(run_umap) {
@@ -98,6 +80,7 @@ EMSCRIPTEN_BINDINGS(run_umap) {
         .function("epoch", &UmapStatus::js_epoch, emscripten::return_value_policy::take_ownership())
         .function("num_epochs", &UmapStatus::js_num_epochs, emscripten::return_value_policy::take_ownership())
         .function("num_observations", &UmapStatus::js_num_observations, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &UmapStatus::js_memory_usage, emscripten::return_value_policy::take_ownership())
         .function("deepcopy", &UmapStatus::js_deepcopy, emscripten::return_value_policy::take_ownership())
         ;
 }
@@ -0,0 +1,52 @@
+#ifndef RUN_UMAP_H
+#define RUN_UMAP_H
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include "utils.h"
+#include "NeighborIndex.h"
+
+#include "umappp/umappp.hpp"
+
+inline umappp::Status<std::int32_t, float> initialize_umap(const NeighborResults& neighbors, int num_epochs, double min_dist, float* embedding, int nthreads) {
+    umappp::Options opt;
+    opt.min_dist = min_dist;
+    opt.num_epochs = num_epochs;
+    opt.num_threads = nthreads;
+
+    // umappp takes ownership of the neighbors, so a fresh copy is made on
+    // each call rather than using a scratch buffer; see ScratchArena.
+    const auto& in_neighbors = neighbors.neighbors(); 
+    const auto nobs = in_neighbors.size();
+    auto copy = sanisizer::create<std::vector<std::vector<std::pair<std::int32_t, float> > > >(nobs);
+    for (I<decltype(nobs)> i = 0; i < nobs; ++i) {
+        auto& output = copy[i];
+        const auto& src = in_neighbors[i];
+        const auto n = src.size();
+        output.reserve(n);
+        for (I<decltype(n)> j = 0; j < n; ++j) {
+            output.emplace_back(src[j].first, src[j].second);
+        }
+    }
+
+    return umappp::initialize(std::move(copy), 2, embedding, opt);
+}
+
+// If 'runtime' is positive, epochs stop after 'runtime' milliseconds even if not all epochs are complete.
+inline void run_umap(umappp::Status<std::int32_t, float>& status, float* embedding, std::uint64_t runtime) {
+    if (runtime <= 0) {
+        status.run(embedding);
+    } else {
+        auto current = status.epoch();
+        const auto total = status.num_epochs();
+        const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(runtime);
+        do {
+            ++current;
+            status.run(embedding, current);
+        } while (current < total && std::chrono::steady_clock::now() < end);
+    }
+}
+
+#endif
@@ -1,6 +1,8 @@
 #include <emscripten/bind.h>
 
 #include "NumericMatrix.h"
+#include "scratch.h"
+#include "score_gsdecon.h"
 #include "utils.h"
 
 #include "gsdecon/gsdecon.hpp"
@@ -37,21 +39,9 @@ GsdeconResults js_score_gsdecon(
     std::string weight_policy,
     JsFakeInt nthreads_raw
 ) {
-    const auto NR = mat.ptr()->nrow();
     const auto subset = js2int<std::uintptr_t>(subset_raw);
-    auto subptr = reinterpret_cast<const std::uint8_t*>(subset);
-    std::vector<I<decltype(NR)> > keep;
-    for (I<decltype(NR)> r = 0; r < NR; ++r) {
-        if (subptr[r]) {
-            keep.push_back(r);
-        }
-    }
-    auto ptr = tatami::make_DelayedSubset(mat.ptr(), std::move(keep), true);
-
-    gsdecon::Options opt;
-    opt.scale = scale;
-    opt.num_threads = js2int<int>(nthreads_raw);
-    opt.block_weight_policy = translate_block_weight_policy(weight_policy);
+    auto ptr = subset_rows_by_mask(mat.ptr(), reinterpret_cast<const std::uint8_t*>(subset));
+    const auto opt = gsdecon_options(scale, weight_policy, js2int<int>(nthreads_raw));
 
     if (use_blocks) {
         const auto blocks = js2int<std::uintptr_t>(blocks_raw);
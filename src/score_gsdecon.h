@@ -0,0 +1,18 @@
+#ifndef SCORE_GSDECON_H
+#define SCORE_GSDECON_H
+
+#include <string>
+
+#include "utils.h"
+
+#include "gsdecon/gsdecon.hpp"
+
+inline gsdecon::Options gsdecon_options(bool scale, const std::string& weight_policy, int nthreads) {
+    gsdecon::Options opt;
+    opt.scale = scale;
+    opt.num_threads = nthreads;
+    opt.block_weight_policy = translate_block_weight_policy(weight_policy);
+    return opt;
+}
+
+#endif
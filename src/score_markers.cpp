@@ -1,6 +1,8 @@
 #include <emscripten/bind.h>
 
 #include "NumericMatrix.h"
+#include "format_memory_usage.h"
+#include "score_markers.h"
 #include "utils.h"
 
 #include "scran_markers/scran_markers.hpp"
@@ -31,6 +33,15 @@ static emscripten::val get_effect_summary(const scran_markers::SummaryResults<do
     }
 }
 
+template<class Summary_>
+std::size_t effect_summary_bytes(const std::vector<Summary_>& summaries) {
+    std::size_t output = vector_bytes(summaries);
+    for (const auto& res : summaries) {
+        output += vector_bytes(res.min) + vector_bytes(res.mean) + vector_bytes(res.median) + vector_bytes(res.max) + vector_bytes(res.min_rank);
+    }
+    return output;
+}
+
 class ScoreMarkersResults {
     typedef scran_markers::ScoreMarkersSummaryResults<double, std::int32_t> Store;
 
@@ -58,6 +69,14 @@ public:
         return int2js(my_store.detected.size());
     }
 
+    emscripten::val js_memory_usage() const {
+        MemoryUsage usage;
+        usage.owned = nested_vector_bytes(my_store.mean) + nested_vector_bytes(my_store.detected) +
+            effect_summary_bytes(my_store.cohens_d) + effect_summary_bytes(my_store.auc) + 
+            effect_summary_bytes(my_store.delta_mean) + effect_summary_bytes(my_store.delta_detected);
+        return format_memory_usage(usage);
+    }
+
 public:
     emscripten::val js_cohens_d(JsFakeInt g_raw, std::string summary) const {
         return get_effect_summary(my_store.cohens_d[js2int<std::size_t>(g_raw)], summary);
@@ -90,12 +109,7 @@ ScoreMarkersResults js_score_markers(
     bool compute_max,
     JsFakeInt nthreads_raw
 ) {
-    scran_markers::ScoreMarkersSummaryOptions mopt;
-    mopt.threshold = threshold;
-    mopt.compute_auc = compute_auc;
-    mopt.compute_median = compute_med;
-    mopt.compute_max = compute_max;
-    mopt.num_threads = js2int<int>(nthreads_raw);
+    const auto mopt = score_markers_options(threshold, compute_auc, compute_med, compute_max, js2int<int>(nthreads_raw));
 
     const auto groups = js2int<std::uintptr_t>(groups_raw);
     auto gptr = reinterpret_cast<const std::int32_t*>(groups);
@@ -120,5 +134,6 @@ EMSCRIPTEN_BINDINGS(score_markers) {
         .function("delta_mean", &ScoreMarkersResults::js_delta_mean, emscripten::return_value_policy::take_ownership())
         .function("delta_detected", &ScoreMarkersResults::js_delta_detected, emscripten::return_value_policy::take_ownership())
         .function("num_groups", &ScoreMarkersResults::js_num_groups, emscripten::return_value_policy::take_ownership())
+        .function("memory_usage", &ScoreMarkersResults::js_memory_usage, emscripten::return_value_policy::take_ownership())
         ;
 }
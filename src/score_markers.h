@@ -0,0 +1,16 @@
+#ifndef SCORE_MARKERS_H
+#define SCORE_MARKERS_H
+
+#include "scran_markers/scran_markers.hpp"
+
+inline scran_markers::ScoreMarkersSummaryOptions score_markers_options(double threshold, bool compute_auc, bool compute_med, bool compute_max, int nthreads) {
+    scran_markers::ScoreMarkersSummaryOptions mopt;
+    mopt.threshold = threshold;
+    mopt.compute_auc = compute_auc;
+    mopt.compute_median = compute_med;
+    mopt.compute_max = compute_max;
+    mopt.num_threads = nthreads;
+    return mopt;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <vector>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <memory>
+#include <cstdint>
+
+#include "sanisizer/sanisizer.hpp"
+#include "tatami/tatami.hpp"
+
+#include "NumericMatrix.h"
+
+// Slots for the scratch buffers. Each slot should only be used by one
+// binding at a time, so bindings that call each other need different slots.
+enum class ScratchSlot : unsigned char {
+    SUBSET_INDICES,
+    GROUP_SIZES,
+    NUM_SLOTS
+};
+
+// Module-wide pool of scratch buffers for the transient allocations in the
+// bindings. Each buffer grows to the largest size requested across all calls
+// and is then reused, so repeated analyses do not keep allocating and freeing
+// large temporaries in a Wasm heap that can never shrink. All buffers can be
+// freed with release() once an analysis is finished.
+//
+// Only the temporaries that are allocated by the bindings themselves can be
+// pooled here, e.g., the row indices for subsetting in runPca() and
+// scoreGsdecon() and the group sizes in aggregateAcrossCells(). The larger
+// temporaries - the realized, centered or residual matrices in scran_pca and
+// gsdecon, and their per-block buffers - are Eigen objects that are created
+// and owned inside those libraries, which do not accept caller-supplied
+// storage. Realizing the matrix ourselves into pooled storage and passing it
+// with 'realize_matrix = false' is not an option either, as the libraries
+// then fall back to extracting rows through tatami in every IRLBA iteration.
+// Similarly, the copy of the neighbors in initialize_umap() is moved into the
+// umappp::Status and lives as long as the UMAP run, so it cannot be pooled.
+class ScratchArena {
+public:
+    template<typename Type_>
+    Type_* get(ScratchSlot slot, std::size_t n) {
+        static_assert(std::is_trivially_copyable<Type_>::value);
+        auto& current = my_buffers[static_cast<std::size_t>(slot)];
+        const auto needed = sanisizer::product<std::size_t>(n, sizeof(Type_));
+        if (current.size() < needed) {
+            current.clear();
+            current.shrink_to_fit();
+            sanisizer::resize(current, needed);
+        }
+        return reinterpret_cast<Type_*>(current.data());
+    }
+
+    std::size_t size() const {
+        std::size_t output = 0;
+        for (const auto& current : my_buffers) {
+            output += current.capacity();
+        }
+        return output;
+    }
+
+    std::size_t release() {
+        const auto output = size();
+        for (auto& current : my_buffers) {
+            current.clear();
+            current.shrink_to_fit();
+        }
+        return output;
+    }
+
+private:
+    // Allocations from operator new are suitably aligned for any fundamental type.
+    std::array<std::vector<unsigned char>, static_cast<std::size_t>(ScratchSlot::NUM_SLOTS)> my_buffers;
+};
+
+inline ScratchArena& scratch_arena() {
+    static ScratchArena arena;
+    return arena;
+}
+
+// Subsets the rows of 'ptr' to those with non-zero entries in 'mask'. The
+// row indices are stored in the SUBSET_INDICES slot, so the returned matrix
+// should not outlive the binding that calls this function.
+inline std::shared_ptr<const tatami::Matrix<MatrixValue, MatrixIndex> > subset_rows_by_mask(std::shared_ptr<const tatami::Matrix<MatrixValue, MatrixIndex> > ptr, const std::uint8_t* mask) {
+    const auto NR = ptr->nrow();
+    auto keep = scratch_arena().get<MatrixIndex>(ScratchSlot::SUBSET_INDICES, NR);
+    MatrixIndex nkeep = 0;
+    for (I<decltype(NR)> r = 0; r < NR; ++r) {
+        if (mask[r]) {
+            keep[nkeep] = r;
+            ++nkeep;
+        }
+    }
+    return tatami::make_DelayedSubset(std::move(ptr), tatami::ArrayView<MatrixIndex>(keep, nkeep), true);
+}
+
+#endif
@@ -0,0 +1,11 @@
+#include <emscripten/bind.h>
+
+#include "string_pool.h"
+
+EMSCRIPTEN_BINDINGS(string_pool) {
+    emscripten::class_<StringPool>("StringPool")
+        .function("size", &StringPool::js_size, emscripten::return_value_policy::take_ownership())
+        .function("bytes", &StringPool::js_bytes, emscripten::return_value_policy::take_ownership())
+        .function("offsets", &StringPool::js_offsets, emscripten::return_value_policy::take_ownership())
+        ;
+}
@@ -0,0 +1,75 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <emscripten/val.h>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+#include "utils.h"
+#include "sanisizer/sanisizer.hpp"
+
+// Collection of strings that can be transferred to Javascript as a single
+// UTF-8 buffer and an array of offsets, where string 'i' is stored in
+// 'bytes[offsets[i]:offsets[i + 1]]'. This avoids the creation of one JS
+// string per element via embind, which is slow for millions of strings.
+class StringPool {
+public:
+    StringPool() : my_offsets(1) {}
+
+    StringPool(std::size_t reserved) : my_offsets(1) {
+        my_offsets.reserve(sanisizer::sum<std::size_t>(reserved, 1));
+    }
+
+    void add(const char* ptr, std::size_t len) {
+        my_bytes.insert(my_bytes.end(), ptr, ptr + len);
+        my_offsets.push_back(sanisizer::cast<std::uint32_t>(my_bytes.size()));
+    }
+
+    void add(const std::string& x) {
+        add(x.data(), x.size());
+    }
+
+private:
+    std::vector<char> my_bytes;
+    std::vector<std::uint32_t> my_offsets;
+
+public:
+    JsFakeInt js_size() const {
+        return int2js(my_offsets.size() - 1);
+    }
+
+    emscripten::val js_bytes() const {
+        return emscripten::val(emscripten::typed_memory_view(my_bytes.size(), reinterpret_cast<const std::uint8_t*>(my_bytes.data())));
+    }
+
+    emscripten::val js_offsets() const {
+        return emscripten::val(emscripten::typed_memory_view(my_offsets.size(), my_offsets.data()));
+    }
+};
+
+// Iterates over the strings in a pool created by the Javascript side, i.e.,
+// 'bytes_raw' and 'offsets_raw' are offsets to a Uint8WasmArray of length
+// 'nbytes' and a Uint32WasmArray of length 'n + 1', respectively.
+template<class Function_>
+void visit_string_pool(JsFakeInt bytes_raw, std::size_t nbytes, JsFakeInt offsets_raw, std::size_t n, Function_ fun) {
+    const auto bytes = reinterpret_cast<const char*>(js2int<std::uintptr_t>(bytes_raw));
+    const auto offsets = reinterpret_cast<const std::uint32_t*>(js2int<std::uintptr_t>(offsets_raw));
+    if (offsets[0] != 0) {
+        throw std::runtime_error("string pool offsets should start at zero");
+    }
+    if (offsets[n] > nbytes) {
+        throw std::runtime_error("string pool offsets should not exceed the length of the buffer");
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        if (offsets[i + 1] < offsets[i]) {
+            throw std::runtime_error("string pool offsets should be non-decreasing");
+        }
+        fun(i, bytes + offsets[i], static_cast<std::size_t>(offsets[i + 1] - offsets[i]));
+    }
+}
+
+#endif
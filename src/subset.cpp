@@ -3,18 +3,94 @@
 #include <vector>
 #include <stdexcept>
 #include <string>
+#include <optional>
 
 #include "NumericMatrix.h"
 #include "utils.h"
 
 #include "tatami/tatami.hpp"
 
+std::shared_ptr<const tatami::NumericMatrix> subset_by_indices(std::shared_ptr<const tatami::NumericMatrix> matrix, const std::vector<MatrixIndex>& indices, bool row) {
+    // Sorted and contiguous indices can use the cheaper block subset.
+    bool contiguous = true;
+    for (I<decltype(indices.size())> i = 1, end = indices.size(); i < end; ++i) {
+        if (indices[i] != indices[i - 1] + 1) {
+            contiguous = false;
+            break;
+        }
+    }
+
+    if (contiguous && !indices.empty()) {
+        return std::make_shared<tatami::DelayedSubsetBlock<MatrixValue, MatrixIndex> >(std::move(matrix), indices.front(), indices.size(), row);
+    } else {
+        return tatami::make_DelayedSubset<MatrixValue, MatrixIndex>(std::move(matrix), indices, row);
+    }
+}
+
+template<bool row_>
+void compose_subset(NumericMatrix& matrix, const std::int32_t* offset_ptr, std::size_t length) {
+    auto chain = matrix.subset_chain();
+    if (!chain.seed) {
+        chain.seed = matrix.ptr();
+        chain.seed_storage_savings = matrix.storage_savings();
+    }
+
+    // Mapping the requested indices back to the seed matrix, so that we
+    // only ever need a single subset wrapper for each dimension.
+    std::vector<MatrixIndex> requested(offset_ptr, offset_ptr + length);
+    auto& existing = (row_ ? chain.rows : chain.columns);
+    if (existing.has_value()) {
+        const auto& previous = *existing;
+        for (auto& r : requested) {
+            r = previous[r];
+        }
+    }
+
+    const auto full = (row_ ? chain.seed->nrow() : chain.seed->ncol());
+    bool identity = sanisizer::is_equal(requested.size(), full);
+    if (identity) {
+        for (I<decltype(requested.size())> i = 0, end = requested.size(); i < end; ++i) {
+            if (!sanisizer::is_equal(requested[i], i)) {
+                identity = false;
+                break;
+            }
+        }
+    }
+
+    if (identity) {
+        existing.reset();
+    } else {
+        existing = std::move(requested);
+    }
+
+    auto output = chain.seed;
+    if (chain.rows.has_value()) {
+        output = subset_by_indices(std::move(output), *(chain.rows), true);
+    }
+    if (chain.columns.has_value()) {
+        output = subset_by_indices(std::move(output), *(chain.columns), false);
+    }
+
+    // An identity subset of an unsubsetted matrix leaves it untouched,
+    // so we keep the existing extractors and delayed operation chains.
+    if (output == matrix.ptr()) {
+        return;
+    }
+
+    const bool at_seed = !chain.rows.has_value() && !chain.columns.has_value();
+    matrix.reset_ptr(std::move(output));
+    if (at_seed) {
+        matrix.set_storage_savings(chain.seed_storage_savings);
+    }
+    matrix.set_subset_chain(std::move(chain));
+}
+
 void js_column_subset(NumericMatrix& matrix, JsFakeInt offset_raw, JsFakeInt length_raw) {
     const auto length = js2int<std::size_t>(length_raw);
     const auto offset = js2int<std::uintptr_t>(offset_raw);
     const auto offset_ptr = reinterpret_cast<const std::int32_t*>(offset);
     check_subset_indices<false>(offset_ptr, length, matrix.ptr()->ncol());
-    matrix.reset_ptr(tatami::make_DelayedSubset<MatrixValue, MatrixIndex>(matrix.ptr(), std::vector<std::int32_t>(offset_ptr, offset_ptr + length), false));
+    compose_subset<false>(matrix, offset_ptr, length);
     return;
 }
 
@@ -23,7 +99,7 @@ void js_row_subset(NumericMatrix& matrix, JsFakeInt offset_raw, JsFakeInt length
     const auto offset = js2int<std::uintptr_t>(offset_raw);
     const auto offset_ptr = reinterpret_cast<const std::int32_t*>(offset);
     check_subset_indices<true>(offset_ptr, length, matrix.ptr()->nrow());
-    matrix.reset_ptr(tatami::make_DelayedSubset<MatrixValue, MatrixIndex>(matrix.ptr(), std::vector<std::int32_t>(offset_ptr, offset_ptr + length), true));
+    compose_subset<true>(matrix, offset_ptr, length);
     return;
 }
 
@@ -1,27 +1,75 @@
 #include <emscripten/bind.h>
 
-#include "tatami/tatami.hpp"
+#include "subpar/subpar.hpp"
 
 #include "utils.h"
 
+#include <algorithm>
 #include <vector>
 #include <cstdint>
 #include <cstddef>
 
-void js_transpose_matrix(JsFakeInt nr_raw, JsFakeInt nc_raw, JsFakeInt input_raw, bool column_major, JsFakeInt output_raw) {
+// Cache-blocked transpose of a row-major 'nr x nc' matrix into a row-major
+// 'nc x nr' matrix. Tiles are small enough that the source rows and the
+// destination rows of each tile stay in cache, avoiding the strided misses
+// of a naive transpose. Threads are assigned contiguous runs of tiles in
+// both dimensions, so that tall/thin and short/wide inputs are parallelized
+// equally well. Tiles are ordered by input column (i.e., output row) so that
+// each thread mostly writes to its own output rows; threads only share the
+// cache lines at the edges of their runs.
+template<typename Type_>
+void tiled_transpose(const Type_* input, std::size_t nr, std::size_t nc, Type_* output, int nthreads) {
+    constexpr std::size_t tile_size = 512 / sizeof(Type_); // i.e., 8 cache lines per row of a tile.
+    const auto ncol_tiles = nc / tile_size + (nc % tile_size > 0);
+    const auto nrow_tiles = nr / tile_size + (nr % tile_size > 0);
+
+    subpar::parallelize_range(
+        nthreads,
+        sanisizer::product<std::size_t>(ncol_tiles, nrow_tiles),
+        [&](int, std::size_t first, std::size_t length) {
+            for (auto t = first, end = first + length; t < end; ++t) {
+                const auto c0 = (t / nrow_tiles) * tile_size;
+                const auto c1 = std::min(nc, c0 + tile_size);
+                const auto r0 = (t % nrow_tiles) * tile_size;
+                const auto r1 = std::min(nr, r0 + tile_size);
+                for (auto c = c0; c < c1; ++c) {
+                    auto optr = output + c * nr;
+                    auto iptr = input + c;
+                    for (auto r = r0; r < r1; ++r) {
+                        optr[r] = iptr[r * nc];
+                    }
+                }
+            }
+        }
+    );
+}
+
+void js_transpose_matrix(JsFakeInt nr_raw, JsFakeInt nc_raw, JsFakeInt input_raw, bool column_major, JsFakeInt output_raw, bool float32, JsFakeInt nthreads_raw) {
     const auto nr = js2int<std::size_t>(nr_raw);
     const auto nc = js2int<std::size_t>(nc_raw);
     const auto input = js2int<std::uintptr_t>(input_raw);
     const auto output = js2int<std::uintptr_t>(output_raw);
-    tatami::transpose(
-        reinterpret_cast<const double*>(input),
-        (column_major ? nc : nr),
-        (column_major ? nr : nc),
-        reinterpret_cast<double*>(output)
-    );
+    const auto nthreads = js2int<int>(nthreads_raw);
+
+    if (float32) {
+        tiled_transpose(
+            reinterpret_cast<const float*>(input),
+            (column_major ? nc : nr),
+            (column_major ? nr : nc),
+            reinterpret_cast<float*>(output),
+            nthreads
+        );
+    } else {
+        tiled_transpose(
+            reinterpret_cast<const double*>(input),
+            (column_major ? nc : nr),
+            (column_major ? nr : nc),
+            reinterpret_cast<double*>(output),
+            nthreads
+        );
+    }
 }
 
 EMSCRIPTEN_BINDINGS(transpose_matrix) {
     emscripten::function("transpose_matrix", &js_transpose_matrix, emscripten::return_value_policy::take_ownership());
 }
-
@@ -3,6 +3,7 @@
 
 #include "read_utils.h"
 #include "NumericMatrix.h"
+#include "hdf5_serialize.h"
 
 #include "H5Cpp.h"
 #include "tatami_hdf5/tatami_hdf5.hpp"
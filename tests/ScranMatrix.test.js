@@ -0,0 +1,135 @@
+import * as scran from "../js/index.js";
+import * as simulate from "./simulate.js";
+import * as compare from "./compare.js";
+import * as wa from "wasmarrays.js";
+
+beforeAll(async () => { await scran.initialize({ localFile: true }) });
+afterAll(async () => { await scran.terminate() });
+
+test("batched row extraction works correctly", () => {
+    var mat = simulate.simulateMatrix(50, 20);
+    let NC = mat.numberOfColumns();
+    let indices = [5, 0, 49, 5, 20];
+
+    let out = mat.rows(indices);
+    expect(out.length).toBe(indices.length * NC);
+    for (var i = 0; i < indices.length; i++) {
+        expect(compare.equalArrays(out.slice(i * NC, (i + 1) * NC), mat.row(indices[i]))).toBe(true);
+    }
+
+    // Same results with multiple threads.
+    let multi = mat.rows(indices, { numberOfThreads: 3 });
+    expect(compare.equalArrays(multi, out)).toBe(true);
+
+    // Works through a delayed operation.
+    let logged = scran.delayedMath(mat, "log1p");
+    let lout = logged.rows(indices, { numberOfThreads: 2 });
+    expect(compare.equalFloatArrays(lout, out.map(Math.log1p))).toBe(true);
+    logged.free();
+
+    // Works with a buffer.
+    let buffer = scran.createFloat64WasmArray(indices.length * NC);
+    let bout = mat.rows(indices, { buffer: buffer, asTypedArray: false });
+    expect(bout instanceof wa.Float64WasmArray).toBe(true);
+    expect(compare.equalArrays(bout.array(), out)).toBe(true);
+    buffer.free();
+
+    let wrong = scran.createFloat64WasmArray(1);
+    expect(() => mat.rows(indices, { buffer: wrong })).toThrow("length of 'buffer'");
+    wrong.free();
+
+    expect(() => mat.rows([50])).toThrow("less than the number of rows");
+    mat.free();
+})
+
+test("batched column extraction works correctly", () => {
+    var mat = simulate.simulateMatrix(50, 20);
+    let NR = mat.numberOfRows();
+    let indices = new Int32Array([19, 1, 2, 10]);
+
+    let out = mat.columns(indices, { numberOfThreads: 2 });
+    expect(out.length).toBe(indices.length * NR);
+    for (var i = 0; i < indices.length; i++) {
+        expect(compare.equalArrays(out.slice(i * NR, (i + 1) * NR), mat.column(indices[i]))).toBe(true);
+    }
+
+    expect(mat.columns([]).length).toBe(0);
+    expect(() => mat.columns([-1])).toThrow("non-negative");
+    mat.free();
+})
+
+function densify(extracted, n) {
+    let output = new Float64Array(n);
+    extracted.indices.forEach((x, i) => { output[x] = extracted.values[i]; });
+    return output;
+}
+
+test("sparse row/column extraction works correctly", () => {
+    var mat = simulate.simulateMatrix(50, 20);
+    let NR = mat.numberOfRows();
+    let NC = mat.numberOfColumns();
+
+    for (var r = 0; r < NR; r += 7) {
+        let extracted = mat.rowSparse(r);
+        expect(extracted.indices instanceof Int32Array).toBe(true);
+        expect(extracted.values.every(x => x != 0)).toBe(true);
+        expect(compare.equalArrays(densify(extracted, NC), mat.row(r))).toBe(true);
+    }
+
+    for (var c = 0; c < NC; c += 3) {
+        let extracted = mat.columnSparse(c);
+        expect(compare.equalArrays(densify(extracted, NR), mat.column(c))).toBe(true);
+    }
+
+    // Works through delayed operations.
+    let scaled = scran.delayedArithmetic(mat, "*", 2);
+    let subbed = scran.subsetColumns(scaled, [1, 3, 5, 7]);
+    let extracted = subbed.rowSparse(10);
+    expect(compare.equalArrays(densify(extracted, 4), subbed.row(10))).toBe(true);
+    scaled.free();
+    subbed.free();
+
+    mat.free();
+})
+
+test("batched sparse extraction works correctly", () => {
+    var mat = simulate.simulateMatrix(50, 20);
+    let NR = mat.numberOfRows();
+    let NC = mat.numberOfColumns();
+
+    let rows = [49, 2, 2, 30, 0];
+    let extracted = mat.rowsSparse(rows, { numberOfThreads: 2 });
+    expect(extracted.length).toBe(rows.length);
+    for (var i = 0; i < rows.length; i++) {
+        expect(compare.equalArrays(densify(extracted[i], NC), mat.row(rows[i]))).toBe(true);
+    }
+
+    let cols = [0, 19, 5];
+    extracted = mat.columnsSparse(cols);
+    expect(extracted.length).toBe(cols.length);
+    for (var i = 0; i < cols.length; i++) {
+        expect(compare.equalArrays(densify(extracted[i], NR), mat.column(cols[i]))).toBe(true);
+    }
+
+    expect(() => mat.rowsSparse([NR])).toThrow("less than the number of rows");
+    mat.free();
+})
+
+test("memory usage is reported correctly", () => {
+    var mat = simulate.simulateMatrix(50, 20);
+    let usage = mat.memoryUsage();
+    expect(usage.owned).toBeGreaterThan(0);
+    expect(usage.shared).toBe(0);
+
+    // Delayed operations share the storage with the original matrix.
+    let logged = scran.delayedMath(mat, "log1p");
+    expect(logged.memoryUsage().owned).toBe(0);
+    expect(logged.memoryUsage().shared).toBe(usage.owned);
+    expect(mat.memoryUsage().shared).toBe(usage.owned);
+
+    // Freeing the original transfers ownership to the delayed matrix.
+    mat.free();
+    expect(logged.memoryUsage().owned).toBe(usage.owned);
+    expect(logged.memoryUsage().shared).toBe(0);
+    logged.free();
+})
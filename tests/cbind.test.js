@@ -47,6 +47,43 @@ test("rbind works correctly", () => {
     mat3.free();
 })
 
+test("physical binding works correctly", () => {
+    var mat1 = simulate.simulateMatrix(20, 10);
+    var mat2 = simulate.simulateMatrix(20, 5);
+    var mat3 = simulate.simulateMatrix(20, 15);
+    var sub3 = scran.subsetRows(mat3, [...Array(20).keys()].reverse());
+
+    var delayed = scran.cbind([mat1, mat2, sub3]);
+    var combined = scran.cbind([mat1, mat2, sub3], { physical: true, numberOfThreads: 2 });
+    expect(combined.isSparse()).toBe(true);
+    expect(combined.numberOfRows()).toBe(20);
+    expect(combined.numberOfColumns()).toBe(30);
+    expect(combined.storageSavings()).toBeGreaterThan(0);
+    for (var c = 0; c < 30; c++) {
+        expect(compare.equalArrays(delayed.column(c), combined.column(c))).toBe(true);
+    }
+    for (var r = 0; r < 20; r++) {
+        expect(compare.equalArrays(delayed.row(r), combined.row(r))).toBe(true);
+    }
+
+    var rdelayed = scran.rbind([mat1, mat1]);
+    var rcombined = scran.rbind([mat1, mat1], { physical: true });
+    expect(rcombined.numberOfRows()).toBe(40);
+    for (var r = 0; r < 40; r++) {
+        expect(compare.equalArrays(rdelayed.row(r), rcombined.row(r))).toBe(true);
+    }
+
+    // Falls back to a delayed bind for dense matrices.
+    var dense = simulate.simulateDenseMatrix(20, 5);
+    var mixed = scran.cbind([mat1, dense], { physical: true });
+    expect(mixed.isSparse()).toBe(false);
+    expect(compare.equalArrays(mixed.column(12), dense.column(2))).toBe(true);
+
+    for (const x of [ mat1, mat2, mat3, sub3, delayed, combined, rdelayed, rcombined, dense, mixed ]) {
+        x.free();
+    }
+})
+
 test("cbindWithNames works correctly (simple)", () => {
     var mat1 = simulate.simulateDenseMatrix(10, 10);
     var names1 = ["A", "B", "C", "D", "E", "F", "G", "H", "I", "J"];
@@ -302,3 +302,60 @@ test("in place editing works correctly", () => {
 
     mat.free();
 })
+
+test("chains of delayed operations are handled correctly", () => {
+    var mat = simulate.simulateMatrix(20, 15);
+    let sf = [];
+    for (var c = 0; c < mat.numberOfColumns(); c++) {
+        sf.push(Math.random() + 0.5);
+    }
+    let centers = [];
+    for (var r = 0; r < mat.numberOfRows(); r++) {
+        centers.push(Math.random());
+    }
+
+    // Typical normalization chain, which preserves sparsity until the last step.
+    let normed = scran.delayedArithmetic(mat, "/", sf, { along: "column" });
+    let logged = scran.delayedMath(normed, "log1p");
+    let scaled = scran.delayedArithmetic(logged, "*", 2);
+    let centered = scran.delayedArithmetic(scaled, "-", centers);
+
+    for (var c = 0; c < mat.numberOfColumns(); c++) {
+        let ref = mat.column(c);
+        let expected_logged = ref.map(x => Math.log1p(x / sf[c]));
+        expect(compare.equalFloatArrays(logged.column(c), expected_logged)).toBe(true);
+        let expected = expected_logged.map((x, r) => x * 2 - centers[r]);
+        expect(compare.equalFloatArrays(centered.column(c), expected)).toBe(true);
+    }
+
+    for (var r = 0; r < mat.numberOfRows(); r++) {
+        let ref = mat.row(r);
+        let expected = ref.map((x, c) => Math.log1p(x / sf[c]) * 2 - centers[r]);
+        expect(compare.equalFloatArrays(centered.row(r), expected)).toBe(true);
+    }
+
+    // Earlier matrices in the chain are not affected.
+    expect(compare.equalFloatArrays(normed.row(0), mat.row(0).map((x, c) => x / sf[c]))).toBe(true);
+
+    // Operations that don't preserve sparsity before sparse-preserving ones.
+    let shifted = scran.delayedArithmetic(mat, "+", 1);
+    let relogged = scran.delayedMath(shifted, "log", { logBase: 2 });
+    let rescaled = scran.delayedArithmetic(relogged, "*", centers);
+    for (var c = 0; c < mat.numberOfColumns(); c++) {
+        let expected = mat.column(c).map((x, r) => Math.log2(x + 1) * centers[r]);
+        expect(compare.equalFloatArrays(rescaled.column(c), expected)).toBe(true);
+    }
+    let sextracted = rescaled.rowSparse(3);
+    let densified = new Float64Array(mat.numberOfColumns());
+    sextracted.indices.forEach((i, j) => { densified[i] = sextracted.values[j]; });
+    expect(compare.equalFloatArrays(densified, rescaled.row(3))).toBe(true);
+
+    // Fusion is not applied across other operations.
+    let transposed = scran.transpose(logged);
+    let added = scran.delayedArithmetic(transposed, "+", 1);
+    expect(compare.equalFloatArrays(added.row(0), logged.column(0).map(x => x + 1))).toBe(true);
+
+    for (const x of [ mat, normed, logged, scaled, centered, shifted, relogged, rescaled, transposed, added ]) {
+        x.free();
+    }
+})
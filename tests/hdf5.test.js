@@ -330,6 +330,45 @@ test("HDF5 string dataset creation works as expected", () => {
     }
 })
 
+test("HDF5 string datasets can be read and written as string pools", () => {
+    const path = dir + "/test.pool.h5";
+    const values = ["Aaron", "", "β-globin", "Jayaram", "Michael"];
+    const pool = scran.encodeStringPool(values);
+    expect(Array.from(pool.offsets)).toEqual([0, 5, 5, 14, 21, 28]);
+    expect(scran.decodeStringPool(pool)).toEqual(values);
+
+    for (const length of [ 20, scran.H5StringType.variableLength ]) {
+        purge(path)
+        let fhandle = scran.createNewHdf5File(path);
+        let dhandle = fhandle.createDataSet("stuff", new scran.H5StringType("UTF-8", length), [5]);
+        dhandle.write(pool);
+
+        let dhandle2 = fhandle.open("stuff");
+        expect(dhandle2.values).toEqual(values);
+        expect(scran.decodeStringPool(dhandle2.stringPool())).toEqual(values);
+
+        expect(() => dhandle.write(scran.encodeStringPool(["A"]))).toThrow(/product of 'shape'/);
+
+        // Offsets must start at zero.
+        let shifted = { bytes: pool.bytes, offsets: pool.offsets.map(o => o + 1) };
+        shifted.offsets[shifted.offsets.length - 1] = pool.bytes.length;
+        expect(() => dhandle.write(shifted)).toThrow(/start at zero/);
+
+        // Works for scalar datasets.
+        let shandle = fhandle.createDataSet("scalar", new scran.H5StringType("UTF-8", length), []);
+        shandle.write(scran.encodeStringPool(["Kanon"]));
+        expect(fhandle.open("scalar").values).toEqual(["Kanon"]);
+        expect(() => shandle.write(scran.encodeStringPool(["A", "B"]))).toThrow(/scalar/);
+    }
+
+    // Not allowed for non-string datasets.
+    purge(path)
+    let fhandle = scran.createNewHdf5File(path);
+    let nhandle = fhandle.writeDataSet("numbers", "Int32", null, [1,2,3]);
+    expect(() => nhandle.stringPool()).toThrow(/non-string/);
+    expect(() => nhandle.write(scran.encodeStringPool(["A", "B", "C"]))).toThrow(/only be written to string datasets/);
+})
+
 test("HDF5 enum dataset creation and loading works as expected", () => {
     const path = dir + "/test.write.h5";
     purge(path)
@@ -81,6 +81,39 @@ test("initialization from HDF5 works correctly with dense inputs", () => {
     mat3.free();
 })
 
+test("initialization from HDF5 works correctly with dense inputs and multiple threads", () => {
+    const path = dir + "/test.dense_threads.h5";
+    purge(path);
+
+    let x = new Float64Array(1200);
+    x.forEach((y, i) => {
+        x[i] = Math.random() < 0.5 ? 0 : Math.random() * 10;
+    });
+
+    let f = new hdf5.File(path, "w");
+    f.create_dataset({ name: "stuff", data: x, shape: [30, 40], chunks: [7, 11], compression: 6 });
+    f.close();
+
+    for (const forceSparse of [ true, false ]) {
+        let ref = scran.initializeMatrixFromHdf5Dataset(path, "stuff", { forceInteger: false, forceSparse, numberOfThreads: 1 });
+        let par = scran.initializeMatrixFromHdf5Dataset(path, "stuff", { forceInteger: false, forceSparse, numberOfThreads: 3 });
+        expect(par.isSparse()).toBe(forceSparse);
+        expect(par.numberOfRows()).toBe(40);
+        expect(par.numberOfColumns()).toBe(30);
+        for (var c = 0; c < 30; c++) {
+            expect(compare.equalArrays(par.column(c), x.slice(c * 40, (c + 1) * 40))).toBe(true);
+            expect(compare.equalArrays(par.column(c), ref.column(c))).toBe(true);
+        }
+        ref.free();
+        par.free();
+    }
+
+    // Also works via the top-level function.
+    let top = scran.initializeMatrixFromHdf5(path, "stuff", { forceInteger: false, numberOfThreads: 2 });
+    expect(compare.equalArrays(top.column(5), x.slice(200, 240))).toBe(true);
+    top.free();
+})
+
 test("dense initialization from HDF5 works correctly with forced integers", () => {
     const path = dir + "/test.dense.h5";
     purge(path);
@@ -372,6 +405,55 @@ test("initialization from HDF5 groups works correctly with subsetting", () => {
     }
 })
 
+test("initialization from HDF5 groups works correctly with unsorted column subsets", () => {
+    let nr = 40;
+    let nc = 30;
+    const path = dir + "/test.subsetted.h5";
+    purge(path);
+
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ true);
+    let f = new hdf5.File(path, "w");
+    f.create_group("foobar");
+    f.get("foobar").create_dataset({ name: "data", data: data });
+    f.get("foobar").create_dataset({ name: "indices", data: indices });
+    f.get("foobar").create_dataset({ name: "indptr", data: indptrs });
+    f.get("foobar").create_dataset({ name: "shape", data: [nr, nc], shape: null, dtype: "<i" });
+    f.close();
+
+    var full = scran.initializeMatrixFromHdf5(path, "foobar", { layered: false });
+
+    // Adjacent columns are coalesced, while unsorted and duplicated columns are respected.
+    let cs = [ 5, 6, 7, 29, 0, 6, 12, 13 ];
+    let rs = [ 3, 1, 39, 20 ];
+    for (const layered of [ true, false ]) {
+        var col_sub = scran.initializeMatrixFromHdf5(path, "foobar", { layered, subsetColumn: cs });
+        expect(col_sub.numberOfRows()).toEqual(nr);
+        expect(col_sub.numberOfColumns()).toEqual(cs.length);
+        for (var i = 0; i < cs.length; ++i) {
+            expect(compare.equalArrays(col_sub.column(i), full.column(cs[i]))).toBe(true);
+        }
+
+        var both_sub = scran.initializeMatrixFromHdf5(path, "foobar", { layered, subsetRow: rs, subsetColumn: cs });
+        expect(both_sub.numberOfRows()).toEqual(rs.length);
+        expect(both_sub.numberOfColumns()).toEqual(cs.length);
+        for (var i = 0; i < rs.length; ++i) {
+            expect(compare.equalArrays(both_sub.row(i), col_sub.row(rs[i]))).toBe(true);
+        }
+
+        col_sub.free();
+        both_sub.free();
+    }
+
+    // Empty subsets are also supported.
+    var empty = scran.initializeMatrixFromHdf5(path, "foobar", { subsetColumn: [] });
+    expect(empty.numberOfRows()).toEqual(nr);
+    expect(empty.numberOfColumns()).toEqual(0);
+    empty.free();
+
+    expect(() => scran.initializeMatrixFromHdf5(path, "foobar", { subsetColumn: [ nc ] })).toThrow("less than the number of columns");
+    full.free();
+})
+
 test("initialization from HDF5 works correctly with custom sparse names", () => {
     const path = dir + "/test.sparse_tenx.h5";
     purge(path);
@@ -402,3 +484,266 @@ test("initialization from HDF5 works correctly with custom sparse names", () =>
         expect(compare.equalArrays(mat.column(c), ref)).toBe(true);
     }
 })
+
+test("file-backed initialization from HDF5 works correctly", () => {
+    let nr = 60;
+    let nc = 25;
+    const path = dir + "/test.file_backed.h5";
+    purge(path);
+
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ true);
+    let dense = new Int32Array(nr * nc);
+    dense.forEach((y, i) => {
+        dense[i] = Math.round(Math.random() * 10);
+    });
+
+    let f = new hdf5.File(path, "w");
+    f.create_group("foobar");
+    f.get("foobar").create_dataset({ name: "data", data: data });
+    f.get("foobar").create_dataset({ name: "indices", data: indices });
+    f.get("foobar").create_dataset({ name: "indptr", data: indptrs });
+    f.get("foobar").create_dataset({ name: "shape", data: [nr, nc], shape: null, dtype: "<i" });
+    f.create_dataset({ name: "stuff", data: dense, shape: [nc, nr] });
+    f.close();
+
+    for (const name of [ "foobar", "stuff" ]) {
+        var ref = scran.initializeMatrixFromHdf5(path, name, { layered: false });
+        var backed = scran.initializeMatrixFromHdf5(path, name, { fileBacked: true, cacheSize: 1000 });
+        expect(backed.numberOfRows()).toBe(nr);
+        expect(backed.numberOfColumns()).toBe(nc);
+        for (var c = 0; c < nc; c++) {
+            expect(compare.equalArrays(backed.column(c), ref.column(c))).toBe(true);
+        }
+        for (var r = 0; r < nr; r++) {
+            expect(compare.equalArrays(backed.row(r), ref.row(r))).toBe(true);
+        }
+
+        // Downstream functions stream from the file.
+        let qc_ref = scran.perCellRnaQcMetrics(ref, []);
+        let qc_backed = scran.perCellRnaQcMetrics(backed, []);
+        expect(compare.equalArrays(qc_ref.sum(), qc_backed.sum())).toBe(true);
+        qc_ref.free();
+        qc_backed.free();
+
+        // Subsets are applied without loading the matrix.
+        var sub = scran.initializeMatrixFromHdf5(path, name, { fileBacked: true, subsetRow: [ 5, 1, 30 ], subsetColumn: [ 2, 20 ] });
+        expect(sub.numberOfRows()).toBe(3);
+        expect(sub.numberOfColumns()).toBe(2);
+        expect(compare.equalArrays(sub.column(1), [5, 1, 30].map(i => ref.column(20)[i]))).toBe(true);
+
+        ref.free();
+        backed.free();
+        sub.free();
+    }
+})
+
+test("file-backed HDF5 matrices report their file accesses", () => {
+    let nr = 100;
+    let nc = 80;
+    const path = dir + "/test.file_stats.h5";
+    purge(path);
+
+    let x = new Int32Array(nr * nc);
+    x.forEach((y, i) => {
+        x[i] = Math.round(Math.random() * 10);
+    });
+    let f = new hdf5.File(path, "w");
+    f.create_dataset({ name: "stuff", data: x, shape: [nc, nr], chunks: [10, 10], compression: 6 });
+    f.close();
+
+    var ref = scran.initializeMatrixFromHdf5(path, "stuff", { forceSparse: false });
+    expect(ref.fileAccessStatistics()).toBeNull();
+
+    for (const cachePolicy of [ "predictive", "lru", "none" ]) {
+        var backed = scran.initializeMatrixFromHdf5(path, "stuff", { fileBacked: true, cachePolicy });
+        let stats = backed.fileAccessStatistics();
+        expect(stats.fetches).toBe(0);
+
+        for (var c = 0; c < nc; c++) {
+            expect(compare.equalArrays(backed.column(c), ref.column(c))).toBe(true);
+        }
+
+        stats = backed.fileAccessStatistics();
+        expect(stats.fetches).toBe(nc);
+        expect(stats.hits + stats.misses).toBe(nc);
+        expect(stats.chunksRead).toBeGreaterThan(0);
+        expect(stats.bytesDecompressed).toBeGreaterThan(0);
+        if (cachePolicy == "none") {
+            expect(stats.hits).toBe(0);
+            expect(stats.chunksRead).toBe(nc * (nr / 10)); // every column reads a row of 10x10 chunks.
+        } else {
+            expect(stats.hits).toBeGreaterThan(0);
+        }
+
+        backed.resetFileAccessStatistics();
+        expect(backed.fileAccessStatistics().fetches).toBe(0);
+        backed.free();
+    }
+
+    expect(() => scran.initializeMatrixFromHdf5(path, "stuff", { fileBacked: true, cachePolicy: "foo" })).toThrow("unknown cache policy");
+    ref.free();
+})
+
+test("initialization from HDF5 groups works correctly with parallel chunk decompression", () => {
+    const path = dir + "/test.sparse_parallel.h5";
+    purge(path);
+
+    let nr = 100;
+    let nc = 50;
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ true);
+
+    let f = new hdf5.File(path, "w");
+    f.create_group("foobar");
+    f.get("foobar").create_dataset({ name: "data", data: data, chunks: [17], compression: 6 });
+    f.get("foobar").create_dataset({ name: "indices", data: indices, chunks: [23], compression: 6 });
+    f.get("foobar").create_dataset({ name: "indptr", data: indptrs });
+    f.get("foobar").create_dataset({ name: "shape", data: [nr, nc], shape: null, dtype: "<i" });
+    f.close();
+
+    for (const layered of [ true, false ]) {
+        let ref = scran.initializeSparseMatrixFromHdf5(path, "foobar", { layered, numberOfThreads: 1 });
+        let par = scran.initializeSparseMatrixFromHdf5(path, "foobar", { layered, numberOfThreads: 3 });
+        expect(par.numberOfRows()).toBe(nr);
+        expect(par.numberOfColumns()).toBe(nc);
+        for (var c = 0; c < nc; c++) {
+            expect(compare.equalArrays(par.column(c), ref.column(c))).toBe(true);
+        }
+        ref.free();
+        par.free();
+    }
+
+    // Same for a CSR matrix, which is used directly when not layered.
+    let ref = scran.initializeSparseMatrixFromHdf5Group(path, "foobar", nc, nr, true, { layered: false, numberOfThreads: 1 });
+    let par = scran.initializeSparseMatrixFromHdf5Group(path, "foobar", nc, nr, true, { layered: false, numberOfThreads: 3 });
+    for (var r = 0; r < nc; r++) {
+        expect(compare.equalArrays(par.row(r), ref.row(r))).toBe(true);
+    }
+    ref.free();
+    par.free();
+})
+
+test("initialization from HDF5 groups works correctly with column prefiltering", () => {
+    const path = dir + "/test.sparse_prefilter.h5";
+    purge(path);
+
+    let nr = 50;
+    let nc = 40;
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ false);
+
+    let f = new hdf5.File(path, "w");
+    f.create_group("foobar");
+    f.get("foobar").create_dataset({ name: "data", data: data });
+    f.get("foobar").create_dataset({ name: "indices", data: indices });
+    f.get("foobar").create_dataset({ name: "indptr", data: indptrs });
+    f.get("foobar").create_dataset({ name: "shape", data: [nr, nc], shape: null, dtype: "<i" });
+    f.close();
+
+    let full = scran.initializeSparseMatrixFromHdf5(path, "foobar", { layered: false });
+    let ref_nonzero = [];
+    let ref_sum = [];
+    for (var c = 0; c < nc; c++) {
+        const col = full.column(c);
+        ref_nonzero.push(col.filter(x => x != 0).length);
+        ref_sum.push(col.reduce((a, b) => a + b));
+    }
+
+    // Checking the totals for both the CSC and CSR layouts.
+    expect(Array.from(scran.computeHdf5ColumnTotals(path, "foobar", nr, nc, false))).toEqual(ref_nonzero);
+    expect(Array.from(scran.computeHdf5ColumnTotals(path, "foobar", nr, nc, false, { type: "sum" }))).toEqual(ref_sum);
+
+    // Treating it as CSR, the column totals are the row totals of the original matrix.
+    let row_nonzero = [];
+    for (var r = 0; r < nr; r++) {
+        row_nonzero.push(full.row(r).filter(x => x != 0).length);
+    }
+    expect(Array.from(scran.computeHdf5ColumnTotals(path, "foobar", nc, nr, true))).toEqual(row_nonzero);
+
+    // Filtering on the totals.
+    const threshold = ref_sum.slice().sort((a, b) => a - b)[Math.floor(nc / 2)];
+    const expected = [];
+    for (var c = 0; c < nc; c++) {
+        if (ref_sum[c] >= threshold) {
+            expected.push(c);
+        }
+    }
+    let filtered = scran.initializeSparseMatrixFromHdf5(path, "foobar", { layered: false, minimumColumnTotal: threshold, columnTotalType: "sum" });
+    expect(filtered.numberOfColumns()).toBe(expected.length);
+    expected.forEach((c, i) => {
+        expect(compare.equalArrays(filtered.column(i), full.column(c))).toBe(true);
+    });
+
+    // Combined with a column subset.
+    const subset = [ 5, 3, 1, 20, 39, 0 ];
+    let combined = scran.initializeSparseMatrixFromHdf5(path, "foobar", { layered: false, subsetColumn: subset, minimumColumnTotal: threshold, columnTotalType: "sum" });
+    const expected_combined = subset.filter(c => ref_sum[c] >= threshold);
+    expect(combined.numberOfColumns()).toBe(expected_combined.length);
+    expected_combined.forEach((c, i) => {
+        expect(compare.equalArrays(combined.column(i), full.column(c))).toBe(true);
+    });
+
+    full.free();
+    filtered.free();
+    combined.free();
+})
+
+test("initialization from HDF5 groups works correctly when splitting by modality", () => {
+    const path = dir + "/test.sparse_modality.h5";
+    purge(path);
+
+    let nr = 60;
+    let nc = 30;
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ false);
+
+    let f = new hdf5.File(path, "w");
+    f.create_group("foobar");
+    f.get("foobar").create_dataset({ name: "data", data: data });
+    f.get("foobar").create_dataset({ name: "indices", data: indices });
+    f.get("foobar").create_dataset({ name: "indptr", data: indptrs });
+    f.get("foobar").create_dataset({ name: "shape", data: [nr, nc], shape: null, dtype: "<i" });
+    f.close();
+
+    let modalities = [];
+    for (var r = 0; r < nr; r++) {
+        modalities.push(r % 7 == 0 ? null : (r % 3 == 0 ? "Antibody Capture" : "Gene Expression"));
+    }
+
+    let full = scran.initializeSparseMatrixFromHdf5(path, "foobar", { layered: false });
+    let split = scran.splitSparseMatrixFromHdf5Group(path, "foobar", nr, nc, false, modalities, { dense: [ "Antibody Capture" ] });
+    expect(Object.keys(split)).toEqual([ "Gene Expression", "Antibody Capture" ]);
+    expect(split["Gene Expression"].isSparse()).toBe(true);
+    expect(split["Antibody Capture"].isSparse()).toBe(false);
+
+    for (const [mod, mat] of Object.entries(split)) {
+        const rows = [];
+        modalities.forEach((m, i) => {
+            if (m === mod) {
+                rows.push(i);
+            }
+        });
+        expect(mat.numberOfRows()).toBe(rows.length);
+        expect(mat.numberOfColumns()).toBe(nc);
+        rows.forEach((r, i) => {
+            expect(compare.equalArrays(mat.row(i), full.row(r))).toBe(true);
+        });
+        mat.free();
+    }
+
+    // Same results for a CSR matrix.
+    let full_csr = scran.initializeSparseMatrixFromHdf5Group(path, "foobar", nc, nr, true, { layered: false });
+    let csr_modalities = modalities.slice(0, nc);
+    let split_csr = scran.splitSparseMatrixFromHdf5Group(path, "foobar", nc, nr, true, csr_modalities, { createMultiMatrix: true });
+    expect(split_csr.available()).toEqual([ "Gene Expression", "Antibody Capture" ]);
+    let csr_rows = [];
+    csr_modalities.forEach((m, i) => {
+        if (m === "Antibody Capture") {
+            csr_rows.push(i);
+        }
+    });
+    csr_rows.forEach((r, i) => {
+        expect(compare.equalArrays(split_csr.get("Antibody Capture").row(i), full_csr.row(r))).toBe(true);
+    });
+
+    split_csr.free();
+    full.free();
+    full_csr.free();
+})
@@ -112,6 +112,12 @@ test("initialization from compressed values works correctly", () => {
     expect(compare.equalArrays(mat.column(0), [0, 0, 3, 0, 0, 0, 0, 0, 0, 0])).toBe(true);
     expect(compare.equalArrays(mat.column(9), [0, 0, 8, 0, 0, 0, 0, 0, 0, 8])).toBe(true);
 
+    // Values are stored as uint8, indices as uint16 and pointers as uint32.
+    expect(mat.storageSavings()).toBe(15 * 3 + 15 * 2 + 11 * 4);
+    let cloned = mat.clone();
+    expect(cloned.storageSavings()).toBe(mat.storageSavings());
+    cloned.free();
+
     // Cleaning up.
     vals.free();
     indices.free();
@@ -130,6 +136,7 @@ test("initialization from compressed values works with forced integers", () => {
     var mat1 = scran.initializeSparseMatrixFromSparseArrays(10, 9, vals, indices, indptrs, { forceInteger: false });
     expect(compare.equalArrays(mat1.row(0), [0, 0, 0, 1.2, 0, 5.3, 0, 0, 0])).toBe(true);
     expect(compare.equalArrays(mat1.row(9), [0, 0, 0, 0, 0, 0, 5.7, 8.8, 0])).toBe(true);
+    expect(mat1.storageSavings()).toBe(15 * 2 + 11 * 4); // non-integer values can't be narrowed.
 
     var mat2 = scran.initializeSparseMatrixFromSparseArrays(10, 9, vals, indices, indptrs, { layered: false });
     for (var i = 0; i < 9; i++) {
@@ -159,6 +166,15 @@ test("initialization from compressed values works with layering", () => {
     expect(mat.numberOfRows()).toBe(11);
     expect(mat.numberOfColumns()).toBe(10);
 
+    // Narrowing only happens for non-layered matrices, where the large values force us to use uint32.
+    var unlayered = scran.initializeSparseMatrixFromSparseArrays(11, 10, vals, indices, indptrs, { byRow: false, layered: false });
+    expect(mat.storageSavings()).toBe(0);
+    expect(unlayered.storageSavings()).toBe(15 * 2 + 12 * 4);
+    for (var r = 0; r < 11; r++) {
+        expect(compare.equalArrays(mat.row(r), unlayered.row(r))).toBe(true);
+    }
+    unlayered.free();
+
     // Checking the contents. 
     expect(compare.equalArrays(mat.row(2), [0, 0, 10, 10, 0, 0, 0, 0, 0, 0])).toBe(true); 
     expect(compare.equalArrays(mat.row(1), [0, 0, 0, 1000, 0, 0, 0, 0, 0, 0])).toBe(true); 
@@ -170,3 +186,48 @@ test("initialization from compressed values works with layering", () => {
     indptrs.free();
     mat.free();
 })
+
+test("initialization works with single precision storage", () => {
+    var vals = scran.createFloat64WasmArray(15);
+    vals.set([1.2, 5.3, 2.6, 3.9, 7.2, 8.1, 9.3, 10.9, 4.6, 2.4, 1.7, 1.1, 3.2, 5.7, 8.8]);
+    var indices = scran.createInt32WasmArray(15);
+    indices.set([3, 5, 5, 0, 2, 3, 1, 2, 5, 5, 6, 8, 8, 6, 7]);
+    var indptrs = scran.createInt32WasmArray(11);
+    indptrs.set([0, 2, 3, 6, 9, 11, 11, 12, 12, 13, 15]);
+
+    var ref = scran.initializeSparseMatrixFromSparseArrays(10, 9, vals, indices, indptrs, { forceInteger: false });
+    var csr = scran.initializeSparseMatrixFromSparseArrays(10, 9, vals, indices, indptrs, { forceInteger: false, singlePrecision: true });
+    var csc = scran.initializeSparseMatrixFromSparseArrays(9, 10, vals, indices, indptrs, { byRow: false, forceInteger: false, singlePrecision: true });
+    expect(csr.isSparse()).toBe(true);
+    expect(csc.isSparse()).toBe(true);
+
+    for (var i = 0; i < 10; i++) {
+        let expected = Float32Array.from(ref.row(i));
+        expect(compare.equalArrays(csr.row(i), expected)).toBe(true);
+        expect(compare.equalArrays(csc.column(i), expected)).toBe(true);
+    }
+
+    // Same for the dense initializers.
+    var dvals = scran.createFloat64WasmArray(15);
+    dvals.set([1.2, 2.5, 0, 0, 7.1, 0, 0, 10.1, 4.2, 2.3, 0, 0, 0, 5.3, 8.1]);
+    var dmat = scran.initializeDenseMatrixFromDenseArray(5, 3, dvals, { singlePrecision: true });
+    var smat = scran.initializeSparseMatrixFromDenseArray(5, 3, dvals, { forceInteger: false, singlePrecision: true });
+    expect(dmat.isSparse()).toBe(false);
+    expect(smat.isSparse()).toBe(true);
+    for (var i = 0; i < 3; i++) {
+        let expected = Float32Array.from(dvals.slice(i * 5, (i + 1) * 5));
+        expect(compare.equalArrays(dmat.column(i), expected)).toBe(true);
+        expect(compare.equalArrays(smat.column(i), expected)).toBe(true);
+    }
+
+    // Cleaning up.
+    vals.free();
+    indices.free();
+    indptrs.free();
+    dvals.free();
+    ref.free();
+    csr.free();
+    csc.free();
+    dmat.free();
+    smat.free();
+})
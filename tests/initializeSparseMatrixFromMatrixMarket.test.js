@@ -113,3 +113,230 @@ test("initialization from Gzipped MatrixMarket works correctly with Gzip", () =>
     mat2.free();
     buffer.free();
 })
+
+test("parallel initialization from MatrixMarket works correctly", () => {
+    let nr = 101;
+    let nc = 37;
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ true);
+    const content = convertToMatrixMarket(nr, nc, data, indices, indptrs);
+    const raw_buffer = (new TextEncoder).encode(content);
+
+    var ref = scran.initializeSparseMatrixFromMatrixMarket(raw_buffer, { layered: false, numberOfThreads: 1 });
+    for (const layered of [ true, false ]) {
+        var mat = scran.initializeSparseMatrixFromMatrixMarket(raw_buffer, { layered, numberOfThreads: 3 });
+        expect(mat.numberOfRows()).toBe(nr);
+        expect(mat.numberOfColumns()).toBe(nc);
+        for (var r = 0; r < nr; r++) {
+            expect(compare.equalArrays(mat.row(r), ref.row(r))).toBe(true);
+        }
+        if (!layered) {
+            expect(mat.storageSavings()).toBeGreaterThan(0);
+        }
+        mat.free();
+    }
+    ref.free();
+
+    // Works with real values, comments and blank lines.
+    let real = "%%MatrixMarket matrix coordinate real general\n% a comment\n5 3 4\n1 2 0.5\n\n5 3 1e-2\n% another comment\n2 1 -3.25\n4 2 7";
+    let rmat = scran.initializeSparseMatrixFromMatrixMarket((new TextEncoder).encode(real), { layered: false, numberOfThreads: 2 });
+    expect(compare.equalArrays(rmat.column(0), [0, -3.25, 0, 0, 0])).toBe(true);
+    expect(compare.equalArrays(rmat.column(1), [0.5, 0, 0, 7, 0])).toBe(true);
+    expect(compare.equalArrays(rmat.column(2), [0, 0, 0, 0, 0.01])).toBe(true);
+    expect(rmat.storageSavings()).toBe(4 * 2 + 6 * 4); // non-integer values can't be narrowed.
+    rmat.free();
+
+    let truncated = "%%MatrixMarket matrix coordinate integer general\n5 3 4\n1 2 5\n5 3 1\n";
+    expect(() => scran.initializeSparseMatrixFromMatrixMarket((new TextEncoder).encode(truncated), { numberOfThreads: 2 })).toThrow("expected 4");
+    let outside = "%%MatrixMarket matrix coordinate integer general\n5 3 2\n1 2 5\n6 3 1\n";
+    expect(() => scran.initializeSparseMatrixFromMatrixMarket((new TextEncoder).encode(outside), { numberOfThreads: 2 })).toThrow("out of range");
+})
+
+function concatenateBytes(parts) {
+    let total = parts.reduce((a, p) => a + p.length, 0);
+    let output = new Uint8Array(total);
+    let offset = 0;
+    for (const p of parts) {
+        output.set(p, offset);
+        offset += p.length;
+    }
+    return output;
+}
+
+function bgzfBlock(text) {
+    // BSIZE is the total block size minus 1, which we only know after compression.
+    let tmp = pako.gzip(text, { header: { extra: [66, 67, 2, 0, 0, 0] } });
+    let bsize = tmp.length - 1;
+    return pako.gzip(text, { header: { extra: [66, 67, 2, 0, bsize & 255, bsize >> 8] } });
+}
+
+test("multi-threaded initialization from Gzipped MatrixMarket works correctly", () => {
+    let nr = 83;
+    let nc = 41;
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ true);
+    const content = convertToMatrixMarket(nr, nc, data, indices, indptrs);
+    var ref = scran.initializeSparseMatrixFromMatrixMarket((new TextEncoder).encode(content), { layered: false, numberOfThreads: 1 });
+
+    function checkMatrix(mat) {
+        expect(mat.numberOfRows()).toBe(nr);
+        expect(mat.numberOfColumns()).toBe(nc);
+        for (var r = 0; r < nr; r++) {
+            expect(compare.equalArrays(mat.row(r), ref.row(r))).toBe(true);
+        }
+        mat.free();
+    }
+
+    // Single member, inflated in a separate thread.
+    let single = pako.gzip(content);
+    checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(single, { numberOfThreads: 2 }));
+    checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(single, { compression: "gzip", layered: false, numberOfThreads: 2 }));
+
+    const path = dir + "/test-threaded.mtx.gz";
+    fs.writeFileSync(path, single);
+    checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(path, { numberOfThreads: 2 }));
+
+    // Multiple members, split at arbitrary positions.
+    let pieces = [ content.slice(0, 100), content.slice(100, 1001), content.slice(1001) ];
+    let multi = concatenateBytes(pieces.map(p => pako.gzip(p)));
+    checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(multi, { numberOfThreads: 3 }));
+
+    // BGZF members, inflated in parallel.
+    let bgzf = concatenateBytes(pieces.map(bgzfBlock));
+    checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(bgzf, { layered: false, numberOfThreads: 3 }));
+
+    // Zlib streams are detected for unknown compression, and are not mistaken for uncompressed text.
+    let zlibbed = pako.deflate(content);
+    checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(zlibbed, { numberOfThreads: 1 }));
+    checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(zlibbed, { numberOfThreads: 2 }));
+    checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(zlibbed, { compression: "gzip", numberOfThreads: 2 }));
+
+    // Truncated files are caught.
+    let truncated = single.slice(0, single.length - 20);
+    expect(() => scran.initializeSparseMatrixFromMatrixMarket(truncated, { numberOfThreads: 2 })).toThrow();
+
+    ref.free();
+})
+
+test("streaming initialization from MatrixMarket works correctly", async () => {
+    let nr = 57;
+    let nc = 31;
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ true);
+    const content = convertToMatrixMarket(nr, nc, data, indices, indptrs);
+    const raw = (new TextEncoder).encode(content);
+    var ref = scran.initializeSparseMatrixFromMatrixMarket(raw, { layered: false, numberOfThreads: 1 });
+
+    function checkMatrix(mat) {
+        expect(mat.numberOfRows()).toBe(nr);
+        expect(mat.numberOfColumns()).toBe(nc);
+        for (var r = 0; r < nr; r++) {
+            expect(compare.equalArrays(mat.row(r), ref.row(r))).toBe(true);
+        }
+        mat.free();
+    }
+
+    // Feeding pieces that don't align with the lines.
+    for (const [bytes, compression] of [ [raw, "unknown"], [raw, "none"], [pako.gzip(content), "unknown"], [pako.gzip(content), "gzip"] ]) {
+        let loader = scran.createMatrixMarketStreamLoader({ compression, layered: compression != "none" });
+        for (var i = 0; i < bytes.length; i += 37) {
+            loader.feed(bytes.slice(i, i + 37));
+        }
+        checkMatrix(loader.finish());
+        expect(() => loader.feed(raw)).toThrow("after finish");
+        loader.free();
+    }
+
+    // Works with a ReadableStream.
+    let streamed = await scran.initializeSparseMatrixFromMatrixMarketStream((new Blob([ pako.gzip(content) ])).stream());
+    checkMatrix(streamed);
+
+    // Errors for unsupported files.
+    let loader = scran.createMatrixMarketStreamLoader();
+    expect(() => loader.feed((new TextEncoder).encode("%%MatrixMarket matrix array real general\n2 2\n1\n2\n3\n4\n"))).toThrow("only supported");
+    loader.free();
+
+    ref.free();
+})
+
+test("initialization from MatrixMarket works correctly with subsets", async () => {
+    let nr = 43;
+    let nc = 29;
+    const { data, indices, indptrs } = simulate.simulateSparseData(nc, nr, /* injectBigValues = */ true);
+    const content = convertToMatrixMarket(nr, nc, data, indices, indptrs);
+    const raw = (new TextEncoder).encode(content);
+    const compressed = pako.gzip(content);
+    const path = dir + "/test-subset.mtx.gz";
+    fs.writeFileSync(path, compressed);
+    var ref = scran.initializeSparseMatrixFromMatrixMarket(raw, { layered: false, numberOfThreads: 1 });
+
+    // Unsorted and duplicated indices are respected.
+    const subsetRow = [ 5, 2, 40, 2, 17, 0 ];
+    const subsetColumn = [ 20, 3, 3, 11, 28, 7, 1 ];
+    function checkMatrix(mat) {
+        expect(mat.numberOfRows()).toBe(subsetRow.length);
+        expect(mat.numberOfColumns()).toBe(subsetColumn.length);
+        for (var i = 0; i < subsetRow.length; i++) {
+            let full = ref.row(subsetRow[i]);
+            expect(compare.equalArrays(mat.row(i), subsetColumn.map(c => full[c]))).toBe(true);
+        }
+        mat.free();
+    }
+
+    for (const nthreads of [ 1, 3 ]) {
+        for (const layered of [ true, false ]) {
+            checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(raw, { layered, subsetRow, subsetColumn, numberOfThreads: nthreads }));
+            checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(compressed, { layered, subsetRow, subsetColumn, numberOfThreads: nthreads }));
+            checkMatrix(scran.initializeSparseMatrixFromMatrixMarket(path, { layered, subsetRow, subsetColumn, numberOfThreads: nthreads }));
+        }
+    }
+
+    let loader = scran.createMatrixMarketStreamLoader({ subsetRow, subsetColumn });
+    for (var i = 0; i < compressed.length; i += 53) {
+        loader.feed(compressed.slice(i, i + 53));
+    }
+    checkMatrix(loader.finish());
+    loader.free();
+
+    // Works with only one subset, or with boolean masks.
+    let rowOnly = scran.initializeSparseMatrixFromMatrixMarket(raw, { subsetRow: new Int32Array([ 10, 20, 30 ]) });
+    expect(rowOnly.numberOfRows()).toBe(3);
+    expect(rowOnly.numberOfColumns()).toBe(nc);
+    expect(compare.equalArrays(rowOnly.row(1), ref.row(20))).toBe(true);
+    rowOnly.free();
+
+    let mask = new Array(nc).fill(false);
+    mask[4] = true;
+    mask[9] = true;
+    let masked = scran.initializeSparseMatrixFromMatrixMarket(raw, { subsetColumn: mask });
+    expect(masked.numberOfRows()).toBe(nr);
+    expect(masked.numberOfColumns()).toBe(2);
+    expect(compare.equalArrays(masked.column(1), ref.column(9))).toBe(true);
+    masked.free();
+
+    let typedMask = new Uint8Array(nr);
+    typedMask[3] = 1;
+    typedMask[7] = 1;
+    for (const x of [ raw, compressed, path ]) {
+        let tmasked = scran.initializeSparseMatrixFromMatrixMarket(x, { subsetRow: typedMask, subsetAsMask: true });
+        expect(tmasked.numberOfRows()).toBe(2);
+        expect(compare.equalArrays(tmasked.row(1), ref.row(7))).toBe(true);
+        tmasked.free();
+    }
+
+    expect(() => scran.initializeSparseMatrixFromMatrixMarket(raw, { subsetColumn: mask.slice(1) })).toThrow("length of the column mask");
+    expect(() => scran.initializeSparseMatrixFromMatrixMarket(path, { subsetRow: typedMask.slice(1), subsetAsMask: true })).toThrow("length of the row mask");
+    let badLoader = scran.createMatrixMarketStreamLoader({ subsetColumn: mask.concat([ true ]) });
+    expect(() => {
+        badLoader.feed(raw);
+        badLoader.finish();
+    }).toThrow("length of the column mask");
+    badLoader.free();
+
+    // Falls back to subsetting after loading for unsupported files.
+    let symmetric = "%%MatrixMarket matrix coordinate integer symmetric\n3 3 2\n2 1 5\n3 3 7\n";
+    let smat = scran.initializeSparseMatrixFromMatrixMarket((new TextEncoder).encode(symmetric), { subsetRow: [ 0, 2 ], subsetColumn: [ 1 ] });
+    expect(compare.equalArrays(smat.column(0), [5, 0])).toBe(true);
+    smat.free();
+
+    expect(() => scran.initializeSparseMatrixFromMatrixMarket(raw, { subsetRow: [ nr ] })).toThrow("less than the number of rows");
+
+    ref.free();
+})
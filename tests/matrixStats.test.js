@@ -40,3 +40,72 @@ test("columnSums works correctly", () => {
 
     // Options are the same as the row sums, so we won't bother testing them again.
 })
+
+function referenceStats(values) {
+    let n = values.length;
+    let sum = values.reduce((a, b) => a + b, 0);
+    let mean = sum / n;
+    let variance = values.reduce((a, b) => a + (b - mean) * (b - mean), 0) / (n - 1);
+    let sorted = Array.from(values).sort((a, b) => a - b);
+    let half = Math.floor(n / 2);
+    let median = (n % 2 == 1 ? sorted[half] : (sorted[half - 1] + sorted[half]) / 2);
+    return {
+        sum: sum,
+        mean: mean,
+        variance: variance,
+        detected: values.filter(x => x != 0).length,
+        min: sorted[0],
+        max: sorted[n - 1],
+        median: median
+    };
+}
+
+test("matrixStats works correctly", () => {
+    for (const mat of [ simulate.simulateMatrix(30, 21), simulate.simulateDenseMatrix(30, 21) ]) {
+        let stats = scran.matrixStats(mat, { numberOfThreads: 2 });
+        for (var r = 0; r < 30; r++) {
+            let ref = referenceStats(mat.row(r));
+            for (const [k, v] of Object.entries(ref)) {
+                expect(stats[k][r]).toBeCloseTo(v);
+            }
+        }
+
+        let cstats = scran.matrixStats(mat, { row: false, statistics: ["median", "detected"] });
+        expect(Object.keys(cstats).sort()).toEqual(["detected", "median"]);
+        for (var c = 0; c < 21; c++) {
+            let ref = referenceStats(mat.column(c));
+            expect(cstats.median[c]).toBeCloseTo(ref.median);
+            expect(cstats.detected[c]).toBe(ref.detected);
+        }
+
+        mat.free();
+    }
+})
+
+test("matrixStats works correctly with groups", () => {
+    var mat = simulate.simulateMatrix(30, 21);
+    let groups = new Int32Array(21);
+    groups.forEach((x, i) => { groups[i] = i % 3; });
+
+    let stats = scran.matrixStats(mat, { groups: groups, numberOfGroups: 4 });
+    expect(stats.mean.length).toBe(30 * 4);
+    for (var r = 0; r < 30; r++) {
+        let current = mat.row(r);
+        for (var g = 0; g < 3; g++) {
+            let ref = referenceStats(current.filter((x, i) => groups[i] == g));
+            for (const [k, v] of Object.entries(ref)) {
+                expect(stats[k][g * 30 + r]).toBeCloseTo(v);
+            }
+        }
+
+        // Empty groups are filled with NaNs.
+        expect(stats.sum[3 * 30 + r]).toBe(0);
+        expect(stats.mean[3 * 30 + r]).toBeNaN();
+        expect(stats.median[3 * 30 + r]).toBeNaN();
+    }
+
+    expect(() => scran.matrixStats(mat, { statistics: ["foo"] })).toThrow("unknown statistic");
+    expect(() => scran.matrixStats(mat, { groups: [0, 1] })).toThrow("length of 'groups'");
+    expect(() => scran.matrixStats(mat, { groups: groups, numberOfGroups: 2 })).toThrow("numberOfGroups");
+    mat.free();
+})
@@ -21,6 +21,10 @@ test("Variance modelling works as expected", () => {
     expect(res.fitted()[0] > 0).toBe(true);
     expect(res.residuals().length).toBe(ngenes);
 
+    let usage = res.memoryUsage();
+    expect(usage.owned).toBeGreaterThanOrEqual(ngenes * 8 * 4);
+    expect(usage.shared).toBe(0);
+
     // Cleaning up.
     mat.free();
     norm.free();
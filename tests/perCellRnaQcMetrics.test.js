@@ -25,6 +25,11 @@ test("per-cell QC metrics can be computed", () => {
     prop.forEach(x => { failures += (x < 0 || x > 1) }); 
     expect(failures).toBe(0);
 
+    // Sums and proportions are doubles, detected counts are 32-bit integers.
+    let usage = qc.memoryUsage();
+    expect(usage.owned).toBeGreaterThanOrEqual(ncells * (8 + 4 + 8));
+    expect(usage.shared).toBe(0);
+
     mat.free();
     qc.free();
 });
@@ -111,6 +111,10 @@ maybe("works for string vectors", () => {
         expect(vec[0].length).toBe(1);
         expect(vec[25].length).toBe(1);
 
+        let pool = vals.stringPool();
+        expect(pool.offsets.length).toBe(27);
+        expect(scran.decodeStringPool(pool)).toEqual(vec);
+
         vals.free();
         stuff.free();
     }
@@ -0,0 +1,90 @@
+import * as scran from "../js/index.js";
+import * as simulate from "./simulate.js";
+import * as compare from "./compare.js";
+
+beforeAll(async () => { await scran.initialize({ localFile: true }) });
+afterAll(async () => { await scran.terminate() });
+
+test("realizing a delayed matrix works correctly", () => {
+    var mat = simulate.simulateMatrix(40, 30);
+    let subbed = scran.subsetColumns(mat, [1, 5, 9, 2, 20, 29]);
+    let normed = scran.normalizeCounts(subbed, { sizeFactors: [1, 2, 0.5, 1.5, 1, 3] });
+
+    let realized = scran.realizeMatrix(normed);
+    expect(realized.isSparse()).toBe(true);
+    expect(realized.numberOfRows()).toBe(normed.numberOfRows());
+    expect(realized.numberOfColumns()).toBe(normed.numberOfColumns());
+    for (var c = 0; c < normed.numberOfColumns(); c++) {
+        expect(compare.equalArrays(realized.column(c), normed.column(c))).toBe(true);
+    }
+
+    let dense = scran.realizeMatrix(normed, { sparse: false, numberOfThreads: 2 });
+    expect(dense.isSparse()).toBe(false);
+    for (var r = 0; r < normed.numberOfRows(); r++) {
+        expect(compare.equalArrays(dense.row(r), normed.row(r))).toBe(true);
+    }
+
+    let single = scran.realizeMatrix(normed, { singlePrecision: true });
+    for (var r = 0; r < normed.numberOfRows(); r++) {
+        expect(compare.equalArrays(single.row(r), Float32Array.from(normed.row(r)))).toBe(true);
+    }
+
+    for (const x of [ subbed, normed, realized, dense, single ]) {
+        x.free();
+    }
+    mat.free();
+})
+
+test("realizing count matrices works correctly", () => {
+    var mat = simulate.simulateMatrix(40, 30);
+    let subbed = scran.subsetRows(mat, [0, 10, 20, 30, 39]);
+
+    let layered = scran.realizeMatrix(subbed, { layered: true, numberOfThreads: 3 });
+    let compact = scran.realizeMatrix(subbed);
+    expect(compact.storageSavings()).toBeGreaterThan(0);
+    for (var r = 0; r < subbed.numberOfRows(); r++) {
+        expect(compare.equalArrays(layered.row(r), subbed.row(r))).toBe(true);
+        expect(compare.equalArrays(compact.row(r), subbed.row(r))).toBe(true);
+    }
+
+    // In-place modification.
+    let copy = subbed.clone();
+    let out = scran.realizeMatrix(copy, { inPlace: true });
+    expect(out).toBe(copy);
+    expect(compare.equalArrays(copy.column(5), subbed.column(5))).toBe(true);
+
+    for (const x of [ subbed, layered, compact, copy ]) {
+        x.free();
+    }
+    mat.free();
+})
+
+test("realizing column-major floating-point matrices narrows integral values", () => {
+    const nr = 50, nc = 20;
+    let values = new Float64Array(nr * nc);
+    for (var i = 0; i < values.length; i++) {
+        values[i] = (i % 3 == 0 ? i % 7 : 0);
+    }
+    let dense = scran.initializeDenseMatrixFromDenseArray(nr, nc, values);
+    expect(dense.isSparse()).toBe(false);
+
+    let compact = scran.realizeMatrix(dense, { sparse: true, numberOfThreads: 3 });
+    let single = scran.realizeMatrix(dense, { sparse: true, singlePrecision: true, numberOfThreads: 3 });
+    expect(compact.isSparse()).toBe(true);
+    expect(compact.storageSavings()).toBeGreaterThan(0);
+    expect(single.storageSavings()).toBeGreaterThan(0);
+    for (var r = 0; r < nr; r++) {
+        expect(compare.equalArrays(compact.row(r), dense.row(r))).toBe(true);
+        expect(compare.equalArrays(single.row(r), dense.row(r))).toBe(true);
+    }
+
+    // Non-integer values are stored at full width.
+    let scaled = scran.initializeDenseMatrixFromDenseArray(nr, nc, values.map(x => x / 2));
+    let unnarrowed = scran.realizeMatrix(scaled, { sparse: true, numberOfThreads: 2 });
+    expect(unnarrowed.storageSavings()).toBeLessThan(compact.storageSavings());
+    expect(compare.equalArrays(unnarrowed.column(3), scaled.column(3))).toBe(true);
+
+    for (const x of [ dense, compact, single, scaled, unnarrowed ]) {
+        x.free();
+    }
+})
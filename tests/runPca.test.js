@@ -36,6 +36,15 @@ test("PCA works as expected with feature subsetting", () => {
     expect(pca.varianceExplained().length).toBe(15);
     expect(pca.totalVariance() > 0).toBe(true);
 
+    // Subset indices are held in a reusable scratch buffer.
+    expect(scran.heapUsage().scratch).toBeGreaterThanOrEqual(ngenes * 4);
+    var pca2 = scran.runPca(mat, { features: feat, numberOfPCs: 15 });
+    expect(compare.equalFloatArrays(pca2.varianceExplained(), pca.varianceExplained())).toBe(true);
+    pca2.free();
+
+    expect(scran.releaseScratchSpace()).toBeGreaterThanOrEqual(ngenes * 4);
+    expect(scran.heapUsage().scratch).toBe(0);
+
     // Mopping up.
     mat.free();
     pca.free();
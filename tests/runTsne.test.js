@@ -24,6 +24,9 @@ test("runTsne works as expected", () => {
     expect(compare.equalArrays(start.x, finished.x)).toBe(false);
     expect(compare.equalArrays(start.y, finished.y)).toBe(false);
 
+    // Includes at least the coordinates.
+    expect(init.memoryUsage().owned).toBeGreaterThanOrEqual(ncells * 2 * 8);
+
     // We get the same results when starting from existing NN results.
     let nnres2 = scran.findNearestNeighbors(index, scran.perplexityToNeighbors(30));
     let finished2 = scran.runTsne(nnres2);
@@ -31,6 +31,10 @@ test("scoreMarkers works as expected", () => {
     expect(() => output.cohensD(0, { summary: "foo" })).toThrow("foo");
     expect(() => output.cohensD(0, { summary: "median" })).toThrow("summary type 'median' not available");
 
+    let usage = output.memoryUsage();
+    expect(usage.owned).toBeGreaterThanOrEqual(3 * ngenes * 8 * 2);
+    expect(usage.shared).toBe(0);
+
     mat.free();
     norm.free();
     output.free();
@@ -64,6 +64,87 @@ test("subsetting works in place", () => {
     expect(mat.column(1)).toEqual(ref4);
 })
 
+test("repeated subsetting works correctly", () => {
+    var mat = simulate.simulateMatrix(30, 20);
+
+    // Composes multiple row and column subsets, interleaved.
+    let sub1 = scran.subsetRows(mat, [29, 0, 5, 10, 11, 12, 13, 2]);
+    let sub2 = scran.subsetColumns(sub1, [3, 4, 5, 6, 19]);
+    let sub3 = scran.subsetRows(sub2, [7, 3, 4, 5, 0]);
+    let sub4 = scran.subsetColumns(sub3, [4, 0, 0]);
+
+    let rows = [2, 10, 11, 12, 29];
+    let cols = [19, 3, 3];
+    expect(sub4.numberOfRows()).toBe(rows.length);
+    expect(sub4.numberOfColumns()).toBe(cols.length);
+    for (var r = 0; r < rows.length; r++) {
+        let ref = mat.row(rows[r]);
+        expect(compare.equalArrays(sub4.row(r), cols.map(c => ref[c]))).toBe(true);
+    }
+
+    // Earlier subsets are unaffected.
+    expect(compare.equalArrays(sub1.row(0), mat.row(29))).toBe(true);
+    expect(compare.equalArrays(sub2.column(4), sub1.column(19))).toBe(true);
+
+    // Contiguous subsets work correctly.
+    let block = scran.subsetRows(sub2, [3, 4, 5]);
+    for (var r = 0; r < 3; r++) {
+        expect(compare.equalArrays(block.row(r), sub2.row(r + 3))).toBe(true);
+    }
+
+    // Subsetting to the same rows of a subset works correctly.
+    let full = scran.subsetRows(mat, [5, 6, 7]);
+    scran.subsetRows(full, [0, 1, 2], { inPlace: true });
+    expect(compare.equalArrays(full.row(2), mat.row(7))).toBe(true);
+
+    // Subsets are not composed across other operations.
+    let scaled = scran.delayedArithmetic(sub2, "*", 2);
+    let sub5 = scran.subsetColumns(scaled, [1]);
+    expect(compare.equalArrays(sub5.column(0), sub2.column(1).map(x => x * 2))).toBe(true);
+
+    for (const x of [ mat, sub1, sub2, sub3, sub4, block, full, scaled, sub5 ]) {
+        x.free();
+    }
+})
+
+test("identity subsets return the original matrix", () => {
+    const nr = 15, nc = 12;
+    let values = new Int32Array(nr * nc);
+    for (var i = 0; i < values.length; i++) {
+        values[i] = (i % 4 == 0 ? i % 9 : 0);
+    }
+    let mat = scran.initializeSparseMatrixFromDenseArray(nr, nc, values, { layered: false });
+    const savings = mat.storageSavings();
+    expect(savings).toBeGreaterThan(0);
+
+    // Subset wrappers would discard the storage savings of the narrow types,
+    // so these are only retained if no wrapper was added.
+    let allrows = scran.subsetRows(mat, Array.from({ length: nr }, (_, i) => i));
+    expect(allrows.storageSavings()).toBe(savings);
+    expect(allrows.memoryUsage()).toEqual(mat.memoryUsage());
+    scran.subsetColumns(allrows, Array.from({ length: nc }, (_, i) => i), { inPlace: true });
+    expect(allrows.storageSavings()).toBe(savings);
+    expect(compare.equalArrays(allrows.row(4), mat.row(4))).toBe(true);
+
+    // Non-identity subsets use a wrapper, but restoring all rows and columns returns the original matrix.
+    let reversed = scran.subsetRows(mat, Array.from({ length: nr }, (_, i) => nr - i - 1));
+    expect(reversed.storageSavings()).toBe(0);
+    scran.subsetRows(reversed, Array.from({ length: nr }, (_, i) => nr - i - 1), { inPlace: true });
+    expect(reversed.storageSavings()).toBe(savings);
+    for (var r = 0; r < nr; r++) {
+        expect(compare.equalArrays(reversed.row(r), mat.row(r))).toBe(true);
+    }
+
+    let partial = scran.subsetColumns(mat, [0, 2, 4]);
+    expect(partial.storageSavings()).toBe(0);
+    scran.subsetRows(partial, Array.from({ length: nr }, (_, i) => i), { inPlace: true });
+    expect(partial.storageSavings()).toBe(0); // still has a column subset.
+
+    for (const x of [ mat, allrows, reversed, partial ]) {
+        x.free();
+    }
+})
+
 test("splitRows works as expected", () => {
     let split = {
         A: [0, 3],
@@ -43,3 +43,44 @@ test("transposeMatrix works correctly", () => {
     transposed = scran.transposeMatrix(nr, nc, arr, { columnMajor: false })
     expect(transposed).toEqual(manual);
 })
+
+test("transposeMatrix works with multiple threads and single precision", () => {
+    let nr = 1003;
+    let nc = 77;
+    let arr = new Float64Array(nr * nc);
+    arr.forEach((x, i) => {
+        arr[i] = Math.random();
+    });
+
+    let manual = new Float64Array(arr.length);
+    for (var r = 0; r < nr; r++) {
+        for (var c = 0; c < nc; c++) {
+            manual[r * nc + c] = arr[c * nr + r];
+        }
+    }
+
+    expect(scran.transposeMatrix(nr, nc, arr, { numberOfThreads: 3 })).toEqual(manual);
+    expect(scran.transposeMatrix(nr, nc, manual, { columnMajor: false, numberOfThreads: 2 })).toEqual(arr);
+
+    // Tall and thin inputs are split across threads by rows as well as columns.
+    let tall = new Float64Array(5000 * 3);
+    tall.forEach((x, i) => {
+        tall[i] = i;
+    });
+    let tall_manual = new Float64Array(tall.length);
+    for (var r = 0; r < 5000; r++) {
+        for (var c = 0; c < 3; c++) {
+            tall_manual[c * 5000 + r] = tall[r * 3 + c];
+        }
+    }
+    expect(scran.transposeMatrix(5000, 3, tall, { columnMajor: false, numberOfThreads: 4 })).toEqual(tall_manual);
+
+    let farr = Float32Array.from(arr);
+    let ftransposed = scran.transposeMatrix(nr, nc, farr, { singlePrecision: true, numberOfThreads: 2 });
+    expect(ftransposed instanceof Float32Array).toBe(true);
+    expect(ftransposed).toEqual(Float32Array.from(manual));
+
+    let buffer = scran.createFloat64WasmArray(nr * nc);
+    expect(() => scran.transposeMatrix(nr, nc, farr, { singlePrecision: true, buffer })).toThrow("Float32WasmArray");
+    buffer.free();
+})
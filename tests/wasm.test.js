@@ -13,3 +13,20 @@ test("wasm heap memory is reported correctly", () => {
 test("maximum number of threads is reported correctly", () => {
     expect(scran.maximumThreads()).toBeGreaterThan(0);
 })
+
+test("SIMD usage is reported correctly", () => {
+    expect(typeof scran.usesSimd()).toBe("boolean");
+    expect(scran.usesSimd()).toBe(WebAssembly.validate(new Uint8Array([0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11])));
+})
+
+test("wasm heap usage is reported correctly", () => {
+    var before = scran.heapUsage();
+    expect(before.live).toBeGreaterThan(0);
+    expect(before.fragmented).toBeGreaterThanOrEqual(0);
+
+    var thing = scran.createUint8WasmArray(100000);
+    var during = scran.heapUsage();
+    expect(during.live).toBeGreaterThanOrEqual(before.live + 100000);
+    expect(during.peak).toBeGreaterThanOrEqual(during.live);
+    thing.free();
+})